@@ -0,0 +1,75 @@
+#!/bin/bash
+
+# Measure how long it takes to lower some of the generators in apps/,
+# with and without the simplifier's cache of simplified Exprs
+# (HL_SIMPLIFIER_CACHE), and check that both produce the same Stmt.
+
+if [ $# -lt 3 ]; then
+  echo "Usage: $0 halide_distrib_path halide_target output_dir [app ...]"
+  exit 1
+fi
+
+set -eu
+
+HALIDE_DISTRIB_PATH=$(cd ${1} && pwd)
+HL_TARGET=${2}
+mkdir -p ${3}
+OUT=$(cd ${3} && pwd)
+shift 3
+
+APPS_ROOT=$(cd $(dirname $0)/.. && pwd)
+
+if [ $# -gt 0 ]; then
+    APPS="$@"
+else
+    APPS="local_laplacian resnet_50"
+fi
+
+# Lowering is slow enough that a few runs are plenty
+RUNS=${RUNS:-3}
+
+printf "%-20s %14s %14s %10s\n" "app" "no cache (s)" "cache (s)" "speedup"
+
+FAILED=0
+for APP in ${APPS}; do
+    # The generator name is usually the app name
+    case ${APP} in
+        resnet_50) GENERATOR_NAME=resnet50 ;;
+        *) GENERATOR_NAME=${APP} ;;
+    esac
+
+    GENERATOR=${OUT}/${APP}/host/${GENERATOR_NAME}.generator
+    make -s -C ${APPS_ROOT}/${APP} \
+         HALIDE_DISTRIB_PATH=${HALIDE_DISTRIB_PATH} \
+         BIN=${OUT}/${APP} \
+         ${GENERATOR} > /dev/null
+
+    for CACHE in 0 1; do
+        mkdir -p ${OUT}/${APP}/${CACHE}
+        BEST=
+        for R in $(seq ${RUNS}); do
+            # Only emit the Stmt, so that we time lowering and not
+            # LLVM.
+            START=$(date +%s.%N)
+            HL_SIMPLIFIER_CACHE=${CACHE} \
+                ${GENERATOR} -g ${GENERATOR_NAME} -o ${OUT}/${APP}/${CACHE} -f ${GENERATOR_NAME} \
+                -e stmt target=${HL_TARGET}-no_runtime auto_schedule=false
+            END=$(date +%s.%N)
+            T=$(echo "${END} - ${START}" | bc)
+            if [ -z "${BEST}" ] || [ $(echo "${T} < ${BEST}" | bc) -eq 1 ]; then
+                BEST=${T}
+            fi
+        done
+        eval TIME_${CACHE}=${BEST}
+    done
+
+    printf "%-20s %14.2f %14.2f %9.2fx\n" ${APP} ${TIME_0} ${TIME_1} $(echo "${TIME_0} / ${TIME_1}" | bc -l)
+
+    if ! cmp -s ${OUT}/${APP}/0/${GENERATOR_NAME}.stmt \
+                ${OUT}/${APP}/1/${GENERATOR_NAME}.stmt; then
+        echo "${APP}: the simplifier cache changed the lowered Stmt"
+        FAILED=1
+    fi
+done
+
+exit ${FAILED}
@@ -0,0 +1,78 @@
+"""
+Measures how many realizations per second of a small pipeline several
+Python threads can get through at once. realize() releases the GIL while
+the pipeline runs, so with more threads the throughput should go up,
+as long as there are cores to spare.
+"""
+
+import halide as hl
+
+import numpy as np
+import concurrent.futures
+import os
+import time
+
+def get_blur(input):
+    x, y = hl.Var("x"), hl.Var("y")
+
+    clamped = hl.BoundaryConditions.repeat_edge(input)
+
+    blur_x = hl.Func("blur_x")
+    blur_y = hl.Func("blur_y")
+    blur_x[x, y] = (clamped[x, y] + clamped[x + 1, y] + clamped[x + 2, y]) / 3
+    blur_y[x, y] = (blur_x[x, y] + blur_x[x, y + 1] + blur_x[x, y + 2]) / 3
+
+    # Deliberately not parallel: the parallelism comes from the Python
+    # threads calling realize() concurrently.
+    xi, yi = hl.Var("xi"), hl.Var("yi")
+    blur_y.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8)
+    blur_x.compute_at(blur_y, x).vectorize(x, 8)
+
+    return blur_y
+
+
+def run(blur, outputs, iterations):
+    # Each thread realizes into its own preallocated array, which is
+    # written to in place, without copying.
+    def work(output):
+        for _ in range(iterations):
+            blur.realize(output)
+
+    start = time.perf_counter()
+    with concurrent.futures.ThreadPoolExecutor(max_workers=len(outputs)) as executor:
+        for f in [executor.submit(work, o) for o in outputs]:
+            f.result()
+    elapsed = time.perf_counter() - start
+    return len(outputs) * iterations / elapsed
+
+
+def main():
+    width, height = 512, 512
+    iterations = 50
+
+    input_data = np.random.rand(height, width).astype(np.float32)
+    input = hl.Buffer(input_data.T)
+
+    blur = get_blur(input)
+    blur.compile_jit()
+
+    max_threads = min(os.cpu_count() or 1, 8)
+    thread_counts = sorted(set([1, 2, 4, max_threads]))
+    thread_counts = [t for t in thread_counts if t <= max_threads]
+
+    expected = None
+    for threads in thread_counts:
+        outputs = [np.empty((width, height), dtype=np.float32, order="F") for _ in range(threads)]
+        throughput = run(blur, outputs, iterations)
+        print("%d thread(s): %.1f realizations/s" % (threads, throughput))
+
+        if expected is None:
+            expected = outputs[0].copy()
+        for o in outputs:
+            assert np.array_equal(o, expected), "Threads produced different results"
+
+    print("Success!")
+
+
+if __name__ == "__main__":
+    main()
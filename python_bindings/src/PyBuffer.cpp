@@ -230,32 +230,27 @@ py::object buffer_setitem_operator(Buffer<> &buf, const std::vector<int> &pos, c
     return py::object();
 }
 
+std::vector<halide_dimension_t> make_dim_vec(const py::buffer_info &info) {
+    const Type t = format_descriptor_to_type(info.format);
+    std::vector<halide_dimension_t> dims;
+    dims.reserve(info.ndim);
+    for (int i = 0; i < info.ndim; i++) {
+        if (INT_MAX < info.shape[i] || INT_MAX < (info.strides[i] / t.bytes())) {
+            throw py::value_error("Out of range arguments to make_dim_vec.");
+        }
+        dims.emplace_back(0, (int32_t)info.shape[i], (int32_t)(info.strides[i] / t.bytes()));
+    }
+    return dims;
+}
+
 // Use an alias class so that if we are created via a py::buffer, we can
 // keep the py::buffer_info class alive for the life of the Buffer<>,
 // ensuring the data isn't collected out from under us.
 class PyBuffer : public Buffer<> {
     py::buffer_info info;
 
-    static std::vector<halide_dimension_t> make_dim_vec(const py::buffer_info &info) {
-        const Type t = format_descriptor_to_type(info.format);
-        std::vector<halide_dimension_t> dims;
-        dims.reserve(info.ndim);
-        for (int i = 0; i < info.ndim; i++) {
-            if (INT_MAX < info.shape[i] || INT_MAX < (info.strides[i] / t.bytes())) {
-                throw py::value_error("Out of range arguments to make_dim_vec.");
-            }
-            dims.emplace_back(0, (int32_t)info.shape[i], (int32_t)(info.strides[i] / t.bytes()));
-        }
-        return dims;
-    }
-
     PyBuffer(py::buffer_info &&info, const std::string &name)
-        : Buffer<>(
-              format_descriptor_to_type(info.format),
-              info.ptr,
-              (int)info.ndim,
-              make_dim_vec(info).data(),
-              name),
+        : Buffer<>(pybufferinfo_to_halidebuffer(info, name)),
           info(std::move(info)) {
     }
 
@@ -291,6 +286,14 @@ public:
 
 }  // namespace
 
+Buffer<> pybufferinfo_to_halidebuffer(const py::buffer_info &info, const std::string &name) {
+    return Buffer<>(format_descriptor_to_type(info.format),
+                    info.ptr,
+                    (int)info.ndim,
+                    make_dim_vec(info).data(),
+                    name);
+}
+
 void define_buffer(py::module &m) {
     using BufferDimension = Halide::Runtime::Buffer<>::Dimension;
 
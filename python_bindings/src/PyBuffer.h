@@ -8,6 +8,12 @@ namespace PythonBindings {
 
 void define_buffer(py::module &m);
 
+// Wrap the memory described by a py::buffer_info in a Buffer<>, without
+// copying it. The Buffer<> does not keep the memory alive; the caller
+// must hold on to the py::buffer_info (or the object it came from) for
+// as long as the Buffer<> is in use.
+Buffer<> pybufferinfo_to_halidebuffer(const py::buffer_info &info, const std::string &name = "");
+
 }  // namespace PythonBindings
 }  // namespace Halide
 
@@ -149,6 +149,11 @@ void define_enums(py::module &m) {
         .value("ARMDotProd", Target::Feature::ARMDotProd)
         .value("LLVMLargeCodeModel", Target::Feature::LLVMLargeCodeModel)
         .value("RVV", Target::Feature::RVV)
+        .value("ProfileEvents", Target::Feature::ProfileEvents)
+        .value("AVX512_Cascadelake", Target::Feature::AVX512_Cascadelake)
+        .value("AVX512_Cooperlake", Target::Feature::AVX512_Cooperlake)
+        .value("AVX512_SapphireRapids", Target::Feature::AVX512_SapphireRapids)
+        .value("AutoPrefetch", Target::Feature::AutoPrefetch)
         .value("FeatureEnd", Target::Feature::FeatureEnd);
 
     py::enum_<halide_type_code_t>(m, "TypeCode")
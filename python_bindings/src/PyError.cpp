@@ -9,13 +9,17 @@ void halide_python_error(void *, const char *msg) {
     throw Error(msg);
 }
 
+// Pipelines are compiled and run without holding the GIL (see
+// PyPipeline.h), so take it back before calling into Python.
 void halide_python_print(void *, const char *msg) {
+    py::gil_scoped_acquire acquire;
     py::print(msg, py::arg("end") = "");
 }
 
 class HalidePythonCompileTimeErrorReporter : public CompileTimeErrorReporter {
 public:
     void warning(const char *msg) override {
+        py::gil_scoped_acquire acquire;
         py::print(msg, py::arg("end") = "");
     }
 
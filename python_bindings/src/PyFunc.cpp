@@ -6,6 +6,7 @@
 #include "PyExpr.h"
 #include "PyFuncRef.h"
 #include "PyLoopLevel.h"
+#include "PyPipeline.h"
 #include "PyScheduleMethods.h"
 #include "PyStage.h"
 #include "PyTuple.h"
@@ -70,14 +71,14 @@ void define_set_func_ref<double>(py::class_<Func> &func_class) {
              });
 }
 
-py::object realization_to_object(const Realization &r) {
-    // Only one Buffer -> just return it
-    if (r.size() == 1) {
-        return py::cast(r[0]);
+// Func::realize() and Func::compile_jit() make the Func's Pipeline on
+// first use. Make it here instead, while we still hold the GIL, so that
+// several threads realizing the same Func don't race to do so.
+Pipeline func_pipeline(Func &f) {
+    if (!f.defined()) {
+        throw Error("Func is undefined\n");
     }
-
-    // Multiple -> return as Python tuple
-    return to_python_tuple(r);
+    return f.pipeline();
 }
 
 }  // namespace
@@ -117,7 +118,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, Buffer<> buffer, const Target &target) -> void {
-                    f.realize(buffer, target);
+                    realize_without_gil(func_pipeline(f), Realization(buffer), target);
                 },
                 py::arg("dst"), py::arg("target") = Target())
 
@@ -125,14 +126,29 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, std::vector<Buffer<>> buffers, const Target &t) -> void {
-                    f.realize(Realization(buffers), t);
+                    realize_without_gil(func_pipeline(f), Realization(buffers), t);
+                },
+                py::arg("dst"), py::arg("target") = Target())
+
+            // See the corresponding comment in PyPipeline.cpp.
+            .def(
+                "realize",
+                [](Func &f, const py::buffer &buffer, const Target &target) -> void {
+                    realize_without_gil(func_pipeline(f), std::vector<py::buffer>{buffer}, target);
+                },
+                py::arg("dst"), py::arg("target") = Target())
+
+            .def(
+                "realize",
+                [](Func &f, const std::vector<py::buffer> &buffers, const Target &target) -> void {
+                    realize_without_gil(func_pipeline(f), buffers, target);
                 },
                 py::arg("dst"), py::arg("target") = Target())
 
             .def(
                 "realize",
                 [](Func &f, const std::vector<int32_t> &sizes, const Target &target) -> py::object {
-                    return realization_to_object(f.realize(sizes, target));
+                    return realize_without_gil(func_pipeline(f), sizes, target);
                 },
                 py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target())
 
@@ -140,7 +156,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, const Target &target) -> py::object {
-                    return realization_to_object(f.realize(x_size, target));
+                    return realize_without_gil(func_pipeline(f), std::vector<int32_t>{x_size}, target);
                 },
                 py::arg("x_size"), py::arg("target") = Target())
 
@@ -148,7 +164,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, int y_size, const Target &target) -> py::object {
-                    return realization_to_object(f.realize(x_size, y_size, target));
+                    return realize_without_gil(func_pipeline(f), std::vector<int32_t>{x_size, y_size}, target);
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target())
 
@@ -156,7 +172,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, int y_size, int z_size, const Target &target) -> py::object {
-                    return realization_to_object(f.realize(x_size, y_size, z_size, target));
+                    return realize_without_gil(func_pipeline(f), std::vector<int32_t>{x_size, y_size, z_size}, target);
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target())
 
@@ -164,7 +180,7 @@ void define_func(py::module &m) {
             .def(
                 "realize",
                 [](Func &f, int x_size, int y_size, int z_size, int w_size, const Target &target) -> py::object {
-                    return realization_to_object(f.realize(x_size, y_size, z_size, w_size, target));
+                    return realize_without_gil(func_pipeline(f), std::vector<int32_t>{x_size, y_size, z_size, w_size}, target);
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target())
 
@@ -233,7 +249,11 @@ void define_func(py::module &m) {
             // TODO: useless until Module is defined.
             .def("compile_to_module", &Func::compile_to_module, py::arg("arguments"), py::arg("fn_name") = "", py::arg("target") = get_target_from_environment())
 
-            .def("compile_jit", &Func::compile_jit, py::arg("target") = get_jit_target_from_environment())
+            .def(
+                "compile_jit", [](Func &f, const Target &target) -> void {
+                    compile_jit_without_gil(func_pipeline(f), target);
+                },
+                py::arg("target") = get_jit_target_from_environment())
 
             .def("has_update_definition", &Func::has_update_definition)
             .def("num_update_definitions", &Func::num_update_definitions)
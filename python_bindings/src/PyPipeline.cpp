@@ -2,6 +2,7 @@
 
 #include <utility>
 
+#include "PyBuffer.h"
 #include "PyTuple.h"
 
 namespace Halide {
@@ -21,6 +22,43 @@ py::object realization_to_object(const Realization &r) {
 
 }  // namespace
 
+void compile_jit_without_gil(Pipeline p, const Target &target) {
+    py::gil_scoped_release release;
+    p.compile_jit(target);
+}
+
+py::object realize_without_gil(Pipeline p, std::vector<int32_t> sizes, const Target &target) {
+    Realization r = [&]() {
+        py::gil_scoped_release release;
+        return p.realize(std::move(sizes), target);
+    }();
+    return realization_to_object(r);
+}
+
+void realize_without_gil(Pipeline p, Realization dst, const Target &target) {
+    py::gil_scoped_release release;
+    p.realize(dst, target);
+}
+
+void realize_without_gil(Pipeline p, const std::vector<py::buffer> &dst, const Target &target) {
+    // The buffer_infos hold the Python objects' memory in place until
+    // we're done with it.
+    std::vector<py::buffer_info> infos;
+    std::vector<Buffer<>> buffers;
+    for (const py::buffer &b : dst) {
+        infos.push_back(b.request(/*writable*/ true));
+        buffers.push_back(pybufferinfo_to_halidebuffer(infos.back()));
+    }
+
+    py::gil_scoped_release release;
+    p.realize(Realization(buffers), target);
+    for (Buffer<> &b : buffers) {
+        // Any device allocation can't outlive these wrappers.
+        b.copy_to_host();
+        b.device_free();
+    }
+}
+
 void define_pipeline(py::module &m) {
 
     // Deliberately not supported, because they don't seem to make sense for Python:
@@ -92,52 +130,67 @@ void define_pipeline(py::module &m) {
             .def("compile_to_module", &Pipeline::compile_to_module,
                  py::arg("arguments"), py::arg("fn_name"), py::arg("target") = get_target_from_environment(), py::arg("linkage") = LinkageType::ExternalPlusMetadata)
 
-            .def("compile_jit", &Pipeline::compile_jit, py::arg("target") = get_jit_target_from_environment())
+            .def("compile_jit", &compile_jit_without_gil, py::arg("target") = get_jit_target_from_environment())
 
             .def(
                 "realize", [](Pipeline &p, Buffer<> buffer, const Target &target) -> void {
-                    p.realize(Realization(buffer), target);
+                    realize_without_gil(p, Realization(buffer), target);
                 },
                 py::arg("dst"), py::arg("target") = Target())
 
             // This will actually allow a list-of-buffers as well as a tuple-of-buffers, but that's OK.
             .def(
                 "realize", [](Pipeline &p, std::vector<Buffer<>> buffers, const Target &t) -> void {
-                    p.realize(Realization(buffers), t);
+                    realize_without_gil(p, Realization(buffers), t);
+                },
+                py::arg("dst"), py::arg("target") = Target())
+
+            // Anything supporting the buffer protocol (e.g. a numpy array), or a list of them,
+            // is realized into in place, without copying. Note that these must come before the
+            // sizes overloads, as a one-dimensional array of ints would otherwise be taken as sizes.
+            .def(
+                "realize", [](Pipeline &p, const py::buffer &buffer, const Target &target) -> void {
+                    realize_without_gil(p, std::vector<py::buffer>{buffer}, target);
+                },
+                py::arg("dst"), py::arg("target") = Target())
+
+            .def(
+                "realize", [](Pipeline &p, const std::vector<py::buffer> &buffers, const Target &target) -> void {
+                    realize_without_gil(p, buffers, target);
                 },
                 py::arg("dst"), py::arg("target") = Target())
 
             .def(
                 "realize", [](Pipeline &p, std::vector<int32_t> sizes, const Target &target) -> py::object {
-                    return realization_to_object(p.realize(std::move(sizes), target));
+                    return realize_without_gil(p, std::move(sizes), target);
                 },
                 py::arg("sizes") = std::vector<int32_t>{}, py::arg("target") = Target())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, const Target &target) -> py::object {
-                    return realization_to_object(p.realize(x_size, target));
+                    return realize_without_gil(p, std::vector<int32_t>{x_size}, target);
                 },
                 py::arg("x_size"), py::arg("target") = Target())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, int y_size, const Target &target) -> py::object {
-                    return realization_to_object(p.realize(x_size, y_size, target));
+                    return realize_without_gil(p, std::vector<int32_t>{x_size, y_size}, target);
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("target") = Target())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, int y_size, int z_size, const Target &target) -> py::object {
-                    return realization_to_object(p.realize(x_size, y_size, z_size, target));
+                    return realize_without_gil(p, std::vector<int32_t>{x_size, y_size, z_size}, target);
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("target") = Target())
 
             // TODO: deprecate in favor of std::vector<int32_t> size version?
             .def(
                 "realize", [](Pipeline &p, int x_size, int y_size, int z_size, int w_size, const Target &target) -> py::object {
-                    return realization_to_object(p.realize(x_size, y_size, z_size, w_size, target));
+                    return realize_without_gil(p, std::vector<int32_t>{x_size, y_size, z_size, w_size}, target);
                 },
                 py::arg("x_size"), py::arg("y_size"), py::arg("z_size"), py::arg("w_size"), py::arg("target") = Target())
 
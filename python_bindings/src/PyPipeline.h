@@ -8,6 +8,18 @@ namespace PythonBindings {
 
 void define_pipeline(py::module &m);
 
+// These release the GIL while compiling or running the Pipeline, so
+// that other Python threads (including ones realizing the same
+// Pipeline) can run meanwhile. They're shared by Func and Pipeline.
+void compile_jit_without_gil(Pipeline p, const Target &target);
+py::object realize_without_gil(Pipeline p, std::vector<int32_t> sizes, const Target &target);
+void realize_without_gil(Pipeline p, Realization dst, const Target &target);
+
+// Realize directly into the memory of buffer-like Python objects
+// (e.g. numpy arrays), without copying, then copy the results back to
+// the host.
+void realize_without_gil(Pipeline p, const std::vector<py::buffer> &dst, const Target &target);
+
 }  // namespace PythonBindings
 }  // namespace Halide
 
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
 #include "Bounds.h"
 #include "CSE.h"
+#include "CompilerLogger.h"
 #include "ConciseCasts.h"
 #include "Debug.h"
 #include "Deinterleave.h"
@@ -1511,6 +1513,7 @@ private:
 };
 
 Interval bounds_of_expr_in_scope(const Expr &expr, const Scope<Interval> &scope, const FuncValueBounds &fb, bool const_bound) {
+    ScopedCompilationTimer timer(CompilerLogger::Phase::BoundsInference);
     //debug(3) << "computing bounds_of_expr_in_scope " << expr << "\n";
     Bounds b(&scope, fb, const_bound);
     expr.accept(&b);
@@ -2563,8 +2566,8 @@ private:
     }
 };
 
-map<string, Box> boxes_touched(const Expr &e, Stmt s, bool consider_calls, bool consider_provides,
-                               const string &fn, const Scope<Interval> &scope, const FuncValueBounds &fb) {
+map<string, Box> compute_boxes_touched(const Expr &e, Stmt s, bool consider_calls, bool consider_provides,
+                                       const string &fn, const Scope<Interval> &scope, const FuncValueBounds &fb) {
     if (!fn.empty() && s.defined()) {
         // Filter things down to the relevant sub-Stmts, so we don't spend a
         // long time reasoning about lets and ifs that don't surround an
@@ -2677,6 +2680,240 @@ map<string, Box> boxes_touched(const Expr &e, Stmt s, bool consider_calls, bool
     return calls.boxes;
 }
 
+namespace {
+
+// The names of the variables, loops, and Funcs some IR refers to. The
+// boxes it touches only depend on the parts of the scope and of the
+// function value bounds with these names.
+class FindBoxDependencies : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) override {
+        vars.insert(op->name);
+    }
+
+    void visit(const For *op) override {
+        vars.insert(op->name + ".loop_min");
+        vars.insert(op->name + ".loop_max");
+        IRGraphVisitor::visit(op);
+    }
+
+    void visit(const Call *op) override {
+        funcs.insert(op->name);
+        IRGraphVisitor::visit(op);
+    }
+
+public:
+    set<string> vars, funcs;
+};
+
+bool same_interval(const Interval &a, const Interval &b) {
+    return ((a.min.same_as(b.min) || equal(a.min, b.min)) &&
+            (a.max.same_as(b.max) || equal(a.max, b.max)));
+}
+
+// The boxes can contain lets of made-up names. Rename them each time
+// a cached box is handed out again, so that the names stay unique.
+class FreshenLetNames : public IRMutator {
+    using IRMutator::visit;
+
+    Scope<string> renames;
+
+    Expr visit(const Let *op) override {
+        Expr value = mutate(op->value);
+        string name = unique_name('t');
+        ScopedBinding<string> bind(renames, op->name, name);
+        return Let::make(name, value, mutate(op->body));
+    }
+
+    Expr visit(const Variable *op) override {
+        if (renames.contains(op->name)) {
+            return Variable::make(op->type, renames.get(op->name));
+        }
+        return op;
+    }
+
+public:
+    void freshen(Box &b) {
+        if (b.used.defined()) {
+            b.used = mutate(b.used);
+        }
+        for (Interval &i : b.bounds) {
+            if (i.min.defined()) {
+                i.min = mutate(i.min);
+            }
+            if (i.max.defined()) {
+                i.max = mutate(i.max);
+            }
+        }
+    }
+};
+
+thread_local ScopedBoxesCache::Contents *active_boxes_cache = nullptr;
+
+}  // namespace
+
+struct ScopedBoxesCache::Contents {
+    struct Entry {
+        bool consider_calls, consider_provides;
+        string fn;
+        vector<pair<string, Interval>> scope;
+        vector<pair<pair<string, int>, Interval>> func_bounds;
+        map<string, Box> boxes;
+
+        bool matches(const Entry &other) const {
+            if (consider_calls != other.consider_calls ||
+                consider_provides != other.consider_provides ||
+                fn != other.fn ||
+                scope.size() != other.scope.size() ||
+                func_bounds.size() != other.func_bounds.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < scope.size(); i++) {
+                if (scope[i].first != other.scope[i].first ||
+                    !same_interval(scope[i].second, other.scope[i].second)) {
+                    return false;
+                }
+            }
+            for (size_t i = 0; i < func_bounds.size(); i++) {
+                if (func_bounds[i].first != other.func_bounds[i].first ||
+                    !same_interval(func_bounds[i].second, other.func_bounds[i].second)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    struct Node {
+        // Hold on to the IR, so that the addresses stay unique.
+        Expr e;
+        Stmt s;
+        vector<Entry> entries;
+    };
+
+    // Keyed on the addresses of the Expr and Stmt nodes.
+    map<pair<const IRNode *, const IRNode *>, Node> nodes;
+    size_t num_entries = 0;
+    int hits = 0, misses = 0;
+
+    // The IR stays alive as long as it is in the cache, so don't let
+    // it grow without bound.
+    static constexpr size_t max_entries = 1024;
+};
+
+ScopedBoxesCache::ScopedBoxesCache()
+    : contents(new Contents), previous(active_boxes_cache) {
+    active_boxes_cache = contents.get();
+}
+
+ScopedBoxesCache::~ScopedBoxesCache() {
+    debug(2) << "Boxes touched cache: " << contents->hits << " hits, "
+             << contents->misses << " misses\n";
+    active_boxes_cache = previous;
+}
+
+bool ScopedBoxesCache::active() {
+    return active_boxes_cache != nullptr;
+}
+
+int ScopedBoxesCache::hits() const {
+    return contents->hits;
+}
+
+int ScopedBoxesCache::misses() const {
+    return contents->misses;
+}
+
+map<string, Box> boxes_touched(const Expr &e, Stmt s, bool consider_calls, bool consider_provides,
+                               const string &fn, const Scope<Interval> &scope, const FuncValueBounds &fb) {
+    ScopedCompilationTimer timer(CompilerLogger::Phase::BoundsInference);
+    if (!active_boxes_cache) {
+        return compute_boxes_touched(e, std::move(s), consider_calls, consider_provides, fn, scope, fb);
+    }
+    ScopedBoxesCache::Contents &cache = *active_boxes_cache;
+
+    ScopedBoxesCache::Contents::Entry key;
+    key.consider_calls = consider_calls;
+    key.consider_provides = consider_provides;
+    key.fn = fn;
+
+    FindBoxDependencies deps;
+    if (e.defined()) {
+        e.accept(&deps);
+    }
+    if (s.defined()) {
+        s.accept(&deps);
+    }
+
+    // The bounds of the vars in scope may refer to other vars in
+    // scope, so take the closure.
+    vector<string> pending(deps.vars.begin(), deps.vars.end());
+    while (!pending.empty()) {
+        string name = std::move(pending.back());
+        pending.pop_back();
+        if (!scope.contains(name)) {
+            continue;
+        }
+        Interval i = scope.get(name);
+        FindBoxDependencies inner;
+        if (i.min.defined()) {
+            i.min.accept(&inner);
+        }
+        if (i.max.defined()) {
+            i.max.accept(&inner);
+        }
+        for (const string &v : inner.vars) {
+            if (deps.vars.insert(v).second) {
+                pending.push_back(v);
+            }
+        }
+        deps.funcs.insert(inner.funcs.begin(), inner.funcs.end());
+        key.scope.emplace_back(name, std::move(i));
+    }
+    std::sort(key.scope.begin(), key.scope.end(),
+              [](const pair<string, Interval> &a, const pair<string, Interval> &b) {
+                  return a.first < b.first;
+              });
+
+    for (const string &f : deps.funcs) {
+        for (auto it = fb.lower_bound({f, 0}); it != fb.end() && it->first.first == f; ++it) {
+            key.func_bounds.emplace_back(it->first, it->second);
+        }
+    }
+
+    auto node_key = std::make_pair((const IRNode *)e.get(), (const IRNode *)s.get());
+    auto it = cache.nodes.find(node_key);
+    if (it != cache.nodes.end()) {
+        for (const auto &entry : it->second.entries) {
+            if (entry.matches(key)) {
+                cache.hits++;
+                map<string, Box> boxes = entry.boxes;
+                FreshenLetNames freshener;
+                for (auto &p : boxes) {
+                    freshener.freshen(p.second);
+                }
+                return boxes;
+            }
+        }
+    }
+    cache.misses++;
+
+    key.boxes = compute_boxes_touched(e, s, consider_calls, consider_provides, fn, scope, fb);
+
+    if (cache.num_entries >= ScopedBoxesCache::Contents::max_entries) {
+        cache.nodes.clear();
+        cache.num_entries = 0;
+    }
+    auto &node = cache.nodes[node_key];
+    node.e = e;
+    node.s = s;
+    node.entries.push_back(key);
+    cache.num_entries++;
+
+    return key.boxes;
+}
+
 Box box_touched(const Expr &e, Stmt s, bool consider_calls, bool consider_provides,
                 const string &fn, const Scope<Interval> &scope, const FuncValueBounds &fb) {
     map<string, Box> boxes = boxes_touched(e, std::move(s), consider_calls, consider_provides, fn, scope, fb);
@@ -6,6 +6,8 @@
  * and the regions of a function read or written by a statement.
  */
 
+#include <memory>
+
 #include "Interval.h"
 #include "Scope.h"
 
@@ -166,6 +168,38 @@ Box box_touched(Stmt s, const std::string &fn,
                 const FuncValueBounds &func_bounds = empty_func_value_bounds());
 // @}
 
+/** While one of these is alive, the functions above remember the
+ * boxes they compute on this thread, and reuse them when asked about
+ * the same IR node again with the same flavor of box and the same
+ * bounds for the vars and Funcs it refers to. lower() holds one for
+ * the duration of lowering, so that the passes that call them share
+ * the results, unless one is already active on the thread or the
+ * HL_BOXES_CACHE environment variable is 0. */
+class ScopedBoxesCache {
+public:
+    struct Contents;
+
+    ScopedBoxesCache();
+    ~ScopedBoxesCache();
+
+    /** Whether a cache is active on this thread. */
+    static bool active();
+
+    /** The number of queries that were answered from this cache, and
+     * the number that had to be computed. */
+    // @{
+    int hits() const;
+    int misses() const;
+    // @}
+
+    ScopedBoxesCache(const ScopedBoxesCache &) = delete;
+    ScopedBoxesCache &operator=(const ScopedBoxesCache &) = delete;
+
+private:
+    std::unique_ptr<Contents> contents;
+    Contents *previous;
+};
+
 /** Compute the maximum and minimum possible value for each function
  * in an environment. */
 FuncValueBounds compute_function_value_bounds(const std::vector<std::string> &order,
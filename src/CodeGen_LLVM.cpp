@@ -1217,6 +1217,7 @@ void CodeGen_LLVM::optimize_module() {
     debug(3) << "Optimizing module\n";
 
     auto time_start = std::chrono::high_resolution_clock::now();
+    ScopedCompilationTimer timer(CompilerLogger::Phase::LLVMOptimization);
 
     if (debug::debug_level() >= 3) {
         module->print(dbgs(), nullptr, false, true);
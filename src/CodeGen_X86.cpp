@@ -26,6 +26,16 @@ namespace {
 // existing flags, so that instruction patterns can just check for the
 // oldest feature flag that supports an instruction.
 Target complete_x86_target(Target t) {
+    if (t.has_feature(Target::AVX512_SapphireRapids)) {
+        t.set_feature(Target::AVX512_Cooperlake);
+        t.set_feature(Target::AVX512_Cannonlake);
+    }
+    if (t.has_feature(Target::AVX512_Cooperlake)) {
+        t.set_feature(Target::AVX512_Cascadelake);
+    }
+    if (t.has_feature(Target::AVX512_Cascadelake)) {
+        t.set_feature(Target::AVX512_Skylake);
+    }
     if (t.has_feature(Target::AVX512_Cannonlake) ||
         t.has_feature(Target::AVX512_Skylake) ||
         t.has_feature(Target::AVX512_KNL)) {
@@ -422,6 +432,61 @@ void CodeGen_X86::visit(const Call *op) {
 void CodeGen_X86::codegen_vector_reduce(const VectorReduce *op, const Expr &init) {
     const int factor = op->value.type().lanes() / op->type.lanes();
 
+    // Pattern-match the dot product instructions from the AVX512-VNNI
+    // and AVX512-BF16 extensions. These sum adjacent groups of lanes
+    // of a widening multiply, and accumulate into the initial value.
+    const Mul *mul = op->value.as<Mul>();
+    if (mul && op->op == VectorReduce::Add) {
+        const int input_lanes = mul->type.lanes();
+        const bool vnni = (target.has_feature(Target::AVX512_Cascadelake) &&
+                           op->type.element_of() == Int(32));
+        const bool bf16 = (target.has_feature(Target::AVX512_Cooperlake) &&
+                           op->type.element_of() == Float(32));
+        string intrin;
+        int intrin_factor = 0;
+        Expr a, b;
+        if (vnni && factor % 4 == 0) {
+            // vpdpbusd multiplies unsigned 8-bit values by signed 8-bit values.
+            intrin = "dpbusd";
+            intrin_factor = 4;
+            a = lossless_cast(UInt(8, input_lanes), mul->a);
+            b = lossless_cast(Int(8, input_lanes), mul->b);
+            if (!a.defined() || !b.defined()) {
+                a = lossless_cast(UInt(8, input_lanes), mul->b);
+                b = lossless_cast(Int(8, input_lanes), mul->a);
+            }
+        } else if (vnni && factor == 2 && init.defined()) {
+            // vpdpwssd is pmaddwd with the accumulation folded in, so
+            // it only helps if there is something to accumulate into.
+            intrin = "dpwssd";
+            intrin_factor = 2;
+            a = lossless_cast(Int(16, input_lanes), mul->a);
+            b = lossless_cast(Int(16, input_lanes), mul->b);
+        } else if (bf16 && factor % 2 == 0) {
+            // Note that vdpbf16ps flushes denormals to zero.
+            intrin = "dpbf16ps";
+            intrin_factor = 2;
+            a = lossless_cast(BFloat(16, input_lanes), mul->a);
+            b = lossless_cast(BFloat(16, input_lanes), mul->b);
+        }
+        if (a.defined() && b.defined()) {
+            if (factor != intrin_factor) {
+                Expr equiv = VectorReduce::make(op->op, op->value, input_lanes / intrin_factor);
+                equiv = VectorReduce::make(op->op, equiv, op->type.lanes());
+                codegen_vector_reduce(equiv.as<VectorReduce>(), init);
+                return;
+            }
+            Expr i = init;
+            if (!i.defined()) {
+                i = make_zero(op->type);
+            }
+            const int lanes = op->type.lanes();
+            const int intrin_lanes = lanes > 8 ? 16 : lanes > 4 ? 8 : 4;
+            value = call_intrin(op->type, intrin_lanes, intrin + "x" + std::to_string(intrin_lanes), {i, a, b});
+            return;
+        }
+    }
+
     if (op->type.is_int() &&
         op->type.bits() == 32 &&
         factor == 2 &&
@@ -463,7 +528,18 @@ void CodeGen_X86::codegen_vector_reduce(const VectorReduce *op, const Expr &init
 }
 
 string CodeGen_X86::mcpu() const {
-    if (target.has_feature(Target::AVX512_Cannonlake)) {
+    if (target.has_feature(Target::AVX512_SapphireRapids)) {
+#if LLVM_VERSION >= 120
+        return "sapphirerapids";
+#else
+        // The missing features are added by mattrs()
+        return "cooperlake";
+#endif
+    } else if (target.has_feature(Target::AVX512_Cooperlake)) {
+        return "cooperlake";
+    } else if (target.has_feature(Target::AVX512_Cascadelake)) {
+        return "cascadelake";
+    } else if (target.has_feature(Target::AVX512_Cannonlake)) {
         return "cannonlake";
     } else if (target.has_feature(Target::AVX512_Skylake)) {
         return "skylake-avx512";
@@ -513,6 +589,15 @@ string CodeGen_X86::mattrs() const {
         if (target.has_feature(Target::AVX512_Cannonlake)) {
             features += ",+avx512ifma,+avx512vbmi";
         }
+        if (target.has_feature(Target::AVX512_Cascadelake)) {
+            features += ",+avx512vnni";
+        }
+        if (target.has_feature(Target::AVX512_Cooperlake)) {
+            features += ",+avx512bf16";
+        }
+        if (target.has_feature(Target::AVX512_SapphireRapids)) {
+            features += ",+avx512vbmi2,+avx512bitalg,+avx512vpopcntdq";
+        }
     }
     return features;
 }
@@ -16,7 +16,13 @@ namespace {
 // TODO: for now we are just going to ignore potential issues with
 // static-initialization-order-fiasco, as CompilerLogger isn't currently used
 // from any static-initialization execution scope.
-std::unique_ptr<CompilerLogger> active_compiler_logger;
+//
+// This is per-thread so that compile_multitarget() can compile several
+// targets at once, each with its own logger.
+thread_local std::unique_ptr<CompilerLogger> active_compiler_logger;
+
+// How many ScopedCompilationTimers for each phase are alive on this thread.
+thread_local int active_compilation_timers[(int)CompilerLogger::Phase::LLVMOptimization + 1] = {};
 
 class ObfuscateNames : public IRMutator {
     using IRMutator::visit;
@@ -85,6 +91,29 @@ CompilerLogger *get_compiler_logger() {
     return active_compiler_logger.get();
 }
 
+ScopedCompilationTimer::ScopedCompilationTimer(CompilerLogger::Phase phase)
+    : phase(phase) {
+    // Don't even read the clock unless someone is listening.
+    if (active_compiler_logger) {
+        counted = true;
+        outermost = active_compilation_timers[(int)phase]++ == 0;
+        if (outermost) {
+            start = std::chrono::high_resolution_clock::now();
+        }
+    }
+}
+
+ScopedCompilationTimer::~ScopedCompilationTimer() {
+    if (!counted) {
+        return;
+    }
+    active_compilation_timers[(int)phase]--;
+    if (outermost && active_compiler_logger) {
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        active_compiler_logger->record_compilation_time(phase, diff.count());
+    }
+}
+
 JSONCompilerLogger::JSONCompilerLogger(
     const std::string &generator_name,
     const std::string &function_name,
@@ -119,6 +148,10 @@ void JSONCompilerLogger::record_compilation_time(Phase phase, double duration) {
     compilation_time[phase] += duration;
 }
 
+void JSONCompilerLogger::record_lowering_pass(const std::string &pass, double duration, uint64_t ir_nodes) {
+    lowering_passes.push_back({pass, duration, ir_nodes});
+}
+
 void JSONCompilerLogger::obfuscate() {
     {
         std::map<std::string, std::vector<Expr>> n;
@@ -280,6 +313,31 @@ std::ostream &JSONCompilerLogger::emit_to_stream(std::ostream &o) {
     if (compilation_time.count(Phase::LLVM)) {
         emit_key_value(o, indent, "compilation_time_llvm", compilation_time[Phase::LLVM]);
     }
+    if (compilation_time.count(Phase::Simplifier)) {
+        emit_key_value(o, indent, "compilation_time_simplifier", compilation_time[Phase::Simplifier]);
+    }
+    if (compilation_time.count(Phase::BoundsInference)) {
+        emit_key_value(o, indent, "compilation_time_bounds_inference", compilation_time[Phase::BoundsInference]);
+    }
+    if (compilation_time.count(Phase::LLVMOptimization)) {
+        emit_key_value(o, indent, "compilation_time_llvm_optimization", compilation_time[Phase::LLVMOptimization]);
+    }
+
+    if (!lowering_passes.empty()) {
+        emit_key(o, indent, "lowering_passes");
+        o << "[\n";
+        int commas_to_emit = (int)lowering_passes.size() - 1;
+        for (const auto &pass : lowering_passes) {
+            o << std::string(indent + 1, ' ') << "{\n";
+            emit_key_value(o, indent + 2, "name", pass.name);
+            emit_key_value(o, indent + 2, "time", pass.duration);
+            emit_key_value(o, indent + 2, "ir_nodes", pass.ir_nodes, false);
+            o << std::string(indent + 1, ' ') << "}";
+            emit_eol(o, commas_to_emit-- > 0);
+        }
+        o << std::string(indent, ' ') << "]";
+        emit_eol(o);
+    }
 
     if (!matched_simplifier_rules.empty()) {
         emit_object_key_open(o, indent, "matched_simplifier_rules");
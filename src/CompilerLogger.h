@@ -10,12 +10,14 @@
  * replaced by custom definitions if you have unusual logging needs.
  */
 
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Expr.h"
 #include "Target.h"
@@ -29,6 +31,13 @@ public:
     enum class Phase {
         HalideLowering,
         LLVM,
+        // These overlap with the phases above: they accumulate the
+        // time spent in simplify() and in bounds queries wherever they
+        // are called from, and the time spent in LLVM's optimization
+        // passes.
+        Simplifier,
+        BoundsInference,
+        LLVMOptimization,
     };
 
     CompilerLogger() = default;
@@ -54,15 +63,22 @@ public:
      */
     virtual void record_compilation_time(Phase phase, double duration) = 0;
 
+    /** Record the time (in seconds) taken by a lowering pass, and the
+     * number of distinct IR nodes in the Stmt it produced. A pass may be
+     * recorded more than once. Does nothing by default.
+     */
+    virtual void record_lowering_pass(const std::string &pass, double duration, uint64_t ir_nodes) {
+    }
+
     /**
      * Emit all the gathered data to the given stream. This may be called multiple times.
      */
     virtual std::ostream &emit_to_stream(std::ostream &o) = 0;
 };
 
-/** Set the active CompilerLogger object, replacing any existing one.
- * It is legal to pass in a nullptr (which means "don't do any compiler logging").
- * Returns the previous CompilerLogger (if any). */
+/** Set the active CompilerLogger object for the current thread, replacing
+ * any existing one. It is legal to pass in a nullptr (which means "don't do
+ * any compiler logging"). Returns the previous CompilerLogger (if any). */
 std::unique_ptr<CompilerLogger> set_compiler_logger(std::unique_ptr<CompilerLogger> compiler_logger);
 
 /** Return the currently active CompilerLogger object. If set_compiler_logger()
@@ -71,6 +87,23 @@ std::unique_ptr<CompilerLogger> set_compiler_logger(std::unique_ptr<CompilerLogg
  * calls only. */
 CompilerLogger *get_compiler_logger();
 
+/** Adds the time spent in its scope to the given phase of the active
+ * CompilerLogger, if there is one. Nested timers for the same phase on
+ * the same thread only count the outermost one, so recursive calls
+ * aren't counted twice. */
+class ScopedCompilationTimer {
+    CompilerLogger::Phase phase;
+    bool counted = false, outermost = false;
+    std::chrono::high_resolution_clock::time_point start;
+
+public:
+    explicit ScopedCompilationTimer(CompilerLogger::Phase phase);
+    ~ScopedCompilationTimer();
+
+    ScopedCompilationTimer(const ScopedCompilationTimer &) = delete;
+    ScopedCompilationTimer &operator=(const ScopedCompilationTimer &) = delete;
+};
+
 /** JSONCompilerLogger is a basic implementation of the CompilerLogger interface
  * that saves logged data, then logs it all in JSON format in emit_to_stream().
  */
@@ -91,6 +124,7 @@ public:
     void record_failed_to_prove(Expr failed_to_prove, Expr original_expr) override;
     void record_object_code_size(uint64_t bytes) override;
     void record_compilation_time(Phase phase, double duration) override;
+    void record_lowering_pass(const std::string &pass, double duration, uint64_t ir_nodes) override;
 
     std::ostream &emit_to_stream(std::ostream &o) override;
 
@@ -117,6 +151,15 @@ protected:
     // Map of the time take for each phase of compilation.
     std::map<Phase, double> compilation_time;
 
+    struct LoweringPass {
+        std::string name;
+        double duration;
+        uint64_t ir_nodes;
+    };
+
+    // The lowering passes, in the order they ran.
+    std::vector<LoweringPass> lowering_passes;
+
     void obfuscate();
     void emit();
 };
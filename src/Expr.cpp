@@ -1,4 +1,5 @@
 #include "Expr.h"
+#include "IR.h"
 #include "IROperator.h"  // for lossless_cast()
 
 namespace Halide {
@@ -18,6 +19,10 @@ const IntImm *IntImm::make(Type t, int64_t value) {
     // Then sign-extending to get them back
     value >>= (64 - t.bits());
 
+    if (const IntImm *interned = ScopedIRInterning::int_imm(t, value)) {
+        return interned;
+    }
+
     IntImm *node = new IntImm;
     node->type = t;
     node->value = value;
@@ -34,6 +39,10 @@ const UIntImm *UIntImm::make(Type t, uint64_t value) {
     value <<= (64 - t.bits());
     value >>= (64 - t.bits());
 
+    if (const UIntImm *interned = ScopedIRInterning::uint_imm(t, value)) {
+        return interned;
+    }
+
     UIntImm *node = new UIntImm;
     node->type = t;
     node->value = value;
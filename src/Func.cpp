@@ -3271,4 +3271,8 @@ void Func::compile_jit(const Target &target) {
     pipeline().compile_jit(target);
 }
 
+std::shared_future<void> Func::compile_jit_async(const Target &target, const Target &fallback) {
+    return pipeline().compile_jit_async(target, fallback);
+}
+
 }  // namespace Halide
@@ -1011,6 +1011,11 @@ public:
      */
     void compile_jit(const Target &target = get_jit_target_from_environment());
 
+    /** Start jit compiling the function on a background thread. See
+     * Pipeline::compile_jit_async() for details. */
+    std::shared_future<void> compile_jit_async(const Target &target = get_jit_target_from_environment(),
+                                               const Target &fallback = Target());
+
     /** Set the error handler function that be called in the case of
      * runtime errors during halide pipelines. If you are compiling
      * statically, you can also just define your own function with
@@ -2215,7 +2220,8 @@ public:
 
     /** Use the halide_memoization_cache_... interface to store a
      *  computed version of this function across invocations of the
-     *  Func.
+     *  Func. See halide_memoization_cache_set_disk_tier to also keep
+     *  results across runs of the process.
      */
     Func &memoize();
 
@@ -2330,6 +2336,14 @@ public:
      * improves locality by reusing recently-accessed memory instead
      * of pulling new memory into cache.
      *
+     * If there is a parallel loop between the store_at and compute_at
+     * levels, the storage is moved into the innermost such loop, which
+     * is the same as writing store_at at that loop by hand. For
+     * example, if f is split into strips yo that are computed in
+     * parallel, g.store_root().compute_at(f, yi) behaves as
+     * g.store_at(f, yo).compute_at(f, yi). This is an error for GPU
+     * loops.
+     *
      */
     Func &store_at(const Func &f, const Var &var);
 
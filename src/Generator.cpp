@@ -1,4 +1,5 @@
 #include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <unordered_map>
 #include <utility>
@@ -760,6 +761,7 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
         "gengen \n"
         "  [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-r RUNTIME_NAME] [-d 1|0]\n"
         "  [-e EMIT_OPTIONS] [-n FILE_BASE_NAME] [-p PLUGIN_NAME] [-s AUTOSCHEDULER_NAME]\n"
+        "  [-j NUM_JOBS]\n"
         "       target=target-string[,target-string...] [generator_arg=value [...]]\n"
         "\n"
         " -d  Build a module that is suitable for using for gradient descent calculationn\n"
@@ -771,6 +773,9 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
         "      schedule, static_library, stmt, stmt_html, compiler_log].\n"
         "     If omitted, default value is [c_header, static_library, registration].\n"
         "\n"
+        " -j  The number of targets to compile concurrently when multiple targets are\n"
+        "     specified. If omitted or 0, one per core.\n"
+        "\n"
         " -p  A comma-separated list of shared libraries that will be loaded before the\n"
         "     generator is run. Useful for custom auto-schedulers. The generator must\n"
         "     either be linked against a shared libHalide or compiled with -rdynamic\n"
@@ -791,6 +796,7 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
         {"-e", ""},
         {"-f", ""},
         {"-g", ""},
+        {"-j", "0"},
         {"-n", ""},
         {"-o", ""},
         {"-p", ""},
@@ -839,6 +845,14 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
     }
     const int build_gradient_module = flags_info["-d"] == "1";
 
+    char *num_jobs_end = nullptr;
+    const long num_jobs = std::strtol(flags_info["-j"].c_str(), &num_jobs_end, 10);
+    if (flags_info["-j"].empty() || *num_jobs_end != '\0' || num_jobs < 0) {
+        cerr << "-j must be a non-negative integer\n";
+        cerr << kUsage;
+        return 1;
+    }
+
     std::string autoscheduler_name = flags_info["-s"];
     if (!autoscheduler_name.empty()) {
         Pipeline::set_default_autoscheduler_name(autoscheduler_name);
@@ -1025,7 +1039,7 @@ int generate_filter_main_inner(int argc, char **argv, std::ostream &cerr) {
                 gen->set_generator_param_values(sub_generator_args);
                 return build_gradient_module ? gen->build_gradient_module(name) : gen->build_module(name);
             };
-            compile_multitarget(function_name, output_files, targets, target_strings, module_factory, compiler_logger_factory);
+            compile_multitarget(function_name, output_files, targets, target_strings, module_factory, compiler_logger_factory, (int)num_jobs);
         }
     }
 
@@ -983,6 +983,11 @@ Stmt inject_hexagon_rpc(Stmt s, const Target &host_target,
             target = target.with_feature(i);
         }
     }
+    // The device side doesn't record events, but does update the
+    // remote profiler state like Target::Profile does.
+    if (host_target.has_feature(Target::ProfileEvents)) {
+        target = target.with_feature(Target::Profile);
+    }
 
     Module shared_runtime(runtime_module_name, target);
     Module hexagon_module(pipeline_module_name, target.with_feature(Target::NoRuntime));
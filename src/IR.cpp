@@ -3,6 +3,7 @@
 #include "IRMutator.h"
 #include "IRPrinter.h"
 #include "IRVisitor.h"
+#include <map>
 #include <numeric>
 #include <utility>
 
@@ -692,6 +693,11 @@ Expr Call::make(Type type, const std::string &name, const std::vector<Expr> &arg
 
 Expr Variable::make(Type type, const std::string &name, Buffer<> image, Parameter param, ReductionDomain reduction_domain) {
     internal_assert(!name.empty());
+    if (!image.defined() && !param.defined() && !reduction_domain.defined()) {
+        if (const Variable *interned = ScopedIRInterning::variable(type, name)) {
+            return interned;
+        }
+    }
     Variable *node = new Variable;
     node->type = type;
     node->name = name;
@@ -701,6 +707,77 @@ Expr Variable::make(Type type, const std::string &name, Buffer<> image, Paramete
     return node;
 }
 
+namespace {
+
+// A key for the scalar, non-handle Types of the nodes we intern.
+uint32_t type_key(Type t) {
+    return ((uint32_t)t.code() << 8) | (uint32_t)t.bits();
+}
+
+}  // namespace
+
+struct ScopedIRInterning::Contents {
+    std::map<std::pair<uint32_t, uint64_t>, Expr> constants;
+    std::map<std::pair<std::string, uint32_t>, Expr> variables;
+};
+
+namespace {
+thread_local ScopedIRInterning::Contents *active_interning = nullptr;
+}  // namespace
+
+ScopedIRInterning::ScopedIRInterning()
+    : contents(new Contents), previous(active_interning) {
+    active_interning = contents.get();
+}
+
+ScopedIRInterning::~ScopedIRInterning() {
+    debug(2) << "Interned " << contents->constants.size() << " constants and "
+             << contents->variables.size() << " variables\n";
+    active_interning = previous;
+}
+
+const IntImm *ScopedIRInterning::int_imm(Type t, int64_t value) {
+    if (!active_interning) {
+        return nullptr;
+    }
+    Expr &e = active_interning->constants[{type_key(t), (uint64_t)value}];
+    if (!e.defined()) {
+        IntImm *node = new IntImm;
+        node->type = t;
+        node->value = value;
+        e = node;
+    }
+    return e.as<IntImm>();
+}
+
+const UIntImm *ScopedIRInterning::uint_imm(Type t, uint64_t value) {
+    if (!active_interning) {
+        return nullptr;
+    }
+    Expr &e = active_interning->constants[{type_key(t), value}];
+    if (!e.defined()) {
+        UIntImm *node = new UIntImm;
+        node->type = t;
+        node->value = value;
+        e = node;
+    }
+    return e.as<UIntImm>();
+}
+
+const Variable *ScopedIRInterning::variable(Type t, const std::string &name) {
+    if (!active_interning || !t.is_scalar() || t.is_handle()) {
+        return nullptr;
+    }
+    Expr &e = active_interning->variables[{name, type_key(t)}];
+    if (!e.defined()) {
+        Variable *node = new Variable;
+        node->type = t;
+        node->name = name;
+        e = node;
+    }
+    return e.as<Variable>();
+}
+
 Expr Shuffle::make(const std::vector<Expr> &vectors,
                    const std::vector<int> &indices) {
     internal_assert(!vectors.empty()) << "Shuffle of zero vectors.\n";
@@ -5,6 +5,7 @@
  * Subtypes for Halide expressions (\ref Halide::Expr) and statements (\ref Halide::Internal::Stmt)
  */
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -683,6 +684,36 @@ struct Variable : public ExprNode<Variable> {
     static const IRNodeType _node_type = IRNodeType::Variable;
 };
 
+/** While one of these is alive, IntImm::make, UIntImm::make, and
+ * Variable::make on this thread return the same node each time they
+ * are asked for the same constant or the same plain Variable (one
+ * with no param, image, or reduction domain). Lowering makes many
+ * millions of these leaves, so this saves a lot of allocations and
+ * memory. lower() holds one if HL_INTERN_IR=1. */
+class ScopedIRInterning {
+public:
+    struct Contents;
+
+    ScopedIRInterning();
+    ~ScopedIRInterning();
+
+    ScopedIRInterning(const ScopedIRInterning &) = delete;
+    ScopedIRInterning &operator=(const ScopedIRInterning &) = delete;
+
+    /** The interned node for the given leaf, made if necessary. These
+     * return nullptr if there is no ScopedIRInterning alive on this
+     * thread. */
+    // @{
+    static const IntImm *int_imm(Type t, int64_t value);
+    static const UIntImm *uint_imm(Type t, uint64_t value);
+    static const Variable *variable(Type t, const std::string &name);
+    // @}
+
+private:
+    std::unique_ptr<Contents> contents;
+    Contents *previous;
+};
+
 /** A for loop. Execute the 'body' statement for all values of the
  * variable 'name' from 'min' to 'min + extent'. There are four
  * types of For nodes. A 'Serial' for loop is a conventional
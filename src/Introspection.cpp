@@ -9,6 +9,7 @@
 
 #include <cstdio>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 
@@ -2217,9 +2218,18 @@ private:
 
 namespace {
 DebugSections *debug_sections = nullptr;
+
+// Guards debug_sections, as GenGen may construct Generators for several
+// targets at once. Recursive because the test routine run by
+// test_compilation_unit looks up variable names.
+std::recursive_mutex &debug_sections_mutex() {
+    static std::recursive_mutex mutex;
+    return mutex;
 }
+}  // namespace
 
 bool dump_stack_frame() {
+    std::lock_guard<std::recursive_mutex> lock(debug_sections_mutex());
     if (!debug_sections || !debug_sections->working) {
         return false;
     }
@@ -2228,6 +2238,7 @@ bool dump_stack_frame() {
 }
 
 std::string get_variable_name(const void *var, const std::string &expected_type) {
+    std::lock_guard<std::recursive_mutex> lock(debug_sections_mutex());
     if (!debug_sections ||
         !debug_sections->working) {
         return "";
@@ -2246,6 +2257,7 @@ std::string get_variable_name(const void *var, const std::string &expected_type)
 }
 
 std::string get_source_location() {
+    std::lock_guard<std::recursive_mutex> lock(debug_sections_mutex());
     if (!debug_sections ||
         !debug_sections->working) {
         return "";
@@ -2254,6 +2266,7 @@ std::string get_source_location() {
 }
 
 void register_heap_object(const void *obj, size_t size, const void *helper) {
+    std::lock_guard<std::recursive_mutex> lock(debug_sections_mutex());
     if (!debug_sections ||
         !debug_sections->working ||
         !helper) {
@@ -2263,6 +2276,7 @@ void register_heap_object(const void *obj, size_t size, const void *helper) {
 }
 
 void deregister_heap_object(const void *obj, size_t size) {
+    std::lock_guard<std::recursive_mutex> lock(debug_sections_mutex());
     if (!debug_sections ||
         !debug_sections->working) {
         return;
@@ -2294,6 +2308,8 @@ void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string
         return;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(debug_sections_mutex());
+
     debug(5) << "Testing compilation unit with offset_marker at " << reinterpret_bits<void *>(calib) << "\n";
 
     if (!debug_sections) {
@@ -1,6 +1,11 @@
 #include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
 #include <mutex>
+#include <random>
 #include <set>
+#include <sstream>
 #include <string>
 
 #ifdef _WIN32
@@ -16,6 +21,8 @@
 #include "CodeGen_Internal.h"
 #include "CodeGen_LLVM.h"
 #include "Debug.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
 #include "JITModule.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
@@ -210,6 +217,218 @@ public:
     }
 };
 
+// Mixes the details of the lowered IR that printing it doesn't capture
+// exactly into a JIT cache key.
+class JITCacheKeyVisitor : public IRGraphVisitor {
+    std::ostream &key;
+
+    using IRGraphVisitor::visit;
+
+    void include(const Expr &e) override {
+        key << e.type() << " ";
+        IRGraphVisitor::include(e);
+    }
+
+    void visit(const FloatImm *op) override {
+        key << reinterpret_bits<uint64_t>(op->value) << " ";
+    }
+
+    void visit(const Load *op) override {
+        key << op->alignment.modulus << " " << op->alignment.remainder << " ";
+        if (op->image.defined()) {
+            // When jitting, codegen uses the alignment of the host
+            // pointer of an embedded buffer.
+            uintptr_t address = (uintptr_t)op->image.data();
+            key << (address & (~address + 1)) << " ";
+        }
+        IRGraphVisitor::visit(op);
+    }
+
+    void visit(const Store *op) override {
+        key << op->alignment.modulus << " " << op->alignment.remainder << " ";
+        IRGraphVisitor::visit(op);
+    }
+
+public:
+    JITCacheKeyVisitor(std::ostream &key)
+        : key(key) {
+    }
+};
+
+const char *const jit_cache_header = "halide_jit_cache 1";
+
+// A persistent cache of the object code of jitted pipelines, enabled
+// by setting HL_JIT_CACHE_DIR to a directory. Entries are keyed by a
+// hash of the lowered Module and the Halide and LLVM versions, so a
+// later process that lowers an identical pipeline for the same target
+// skips LLVM code generation, optimization, and instruction selection.
+//
+// An entry holds the object code, preceded by the bitcode of an llvm
+// module with no real code in it. That module carries the triple, data
+// layout and module flags the execution engine and the shared runtime
+// need, and a stub definition of each entrypoint, so that MCJIT knows
+// to ask the cache for the object code that defines them.
+class JITObjectCache : public llvm::ObjectCache {
+    std::string path, key, function_name;
+    std::unique_ptr<llvm::MemoryBuffer> object;
+
+    void discard(const char *reason) {
+        debug(1) << "Discarding JIT cache entry " << path << ": " << reason << "\n";
+        std::remove(path.c_str());
+    }
+
+public:
+    JITObjectCache(const std::string &path, const std::string &key, const std::string &function_name)
+        : path(path), key(key), function_name(function_name) {
+    }
+
+    // Returns nullptr if the JIT cache is off, or if the module
+    // depends on something the key doesn't capture.
+    static std::unique_ptr<JITObjectCache> make(const Module &m, const std::string &function_name) {
+        std::string dir = get_env_variable("HL_JIT_CACHE_DIR");
+        if (dir.empty()) {
+            return nullptr;
+        }
+        if (!m.buffers().empty() || !m.external_code().empty() || !m.submodules().empty()) {
+            debug(1) << "Not using the JIT cache for " << function_name
+                     << " because it embeds buffers or external code\n";
+            return nullptr;
+        }
+
+        std::ostringstream key;
+        key << jit_cache_header << "\n"
+            << "llvm " << LLVM_VERSION << "\n";
+#ifdef HALIDE_VERSION_MAJOR
+        key << "halide " << HALIDE_VERSION_MAJOR << "." << HALIDE_VERSION_MINOR << "." << HALIDE_VERSION_PATCH << "\n";
+#endif
+        key << "llvm args " << get_env_variable("HL_LLVM_ARGS") << "\n"
+            << "entrypoint " << function_name << "\n";
+        for (const LoweredFunc &f : m.functions()) {
+            key << f.name << "(";
+            for (const LoweredArgument &arg : f.args) {
+                key << arg.name << " " << (int)arg.kind << " " << arg.type << " " << (int)arg.dimensions
+                    << " " << arg.alignment.modulus << " " << arg.alignment.remainder << ", ";
+            }
+            key << ")\n";
+        }
+        key << m;
+        JITCacheKeyVisitor visitor(key);
+        for (const LoweredFunc &f : m.functions()) {
+            f.body.accept(&visitor);
+        }
+
+        std::string k = key.str();
+        auto digest = llvm::SHA1::hash(llvm::ArrayRef<uint8_t>((const uint8_t *)k.data(), k.size()));
+        std::ostringstream name;
+        name << std::hex << std::setfill('0');
+        for (uint8_t b : digest) {
+            name << std::setw(2) << (int)b;
+        }
+        return std::make_unique<JITObjectCache>(dir + "/" + name.str() + ".jitcache", name.str(), function_name);
+    }
+
+    // Returns the module to hand the execution engine in place of the
+    // real one, or nullptr on a miss.
+    std::unique_ptr<llvm::Module> load(llvm::LLVMContext &context) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            debug(1) << "JIT cache miss for " << function_name << ": " << path << "\n";
+            return nullptr;
+        }
+        in.seekg(0, std::ios::end);
+        uint64_t file_size = in.tellg();
+        in.seekg(0, std::ios::beg);
+
+        std::string h, k;
+        uint64_t bitcode_size = 0, object_size = 0;
+        std::getline(in, h);
+        std::getline(in, k);
+        in >> bitcode_size >> object_size;
+        in.get();
+        if (!in || h != jit_cache_header || k != key ||
+            (uint64_t)in.tellg() + bitcode_size + object_size != file_size) {
+            discard("bad header");
+            return nullptr;
+        }
+        std::vector<char> bitcode(bitcode_size), object_code(object_size);
+        in.read(bitcode.data(), bitcode_size);
+        in.read(object_code.data(), object_size);
+        if (!in) {
+            discard("truncated");
+            return nullptr;
+        }
+
+        auto skeleton = llvm::parseBitcodeFile(llvm::MemoryBufferRef(llvm::StringRef(bitcode.data(), bitcode_size), path), context);
+        if (!skeleton) {
+            llvm::consumeError(skeleton.takeError());
+            discard("bad bitcode");
+            return nullptr;
+        }
+        if (!(*skeleton)->getFunction(function_name)) {
+            discard("missing entrypoint");
+            return nullptr;
+        }
+        auto buffer = llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(object_code.data(), object_size), path);
+        auto object_file = llvm::object::ObjectFile::createObjectFile(buffer->getMemBufferRef());
+        if (!object_file) {
+            llvm::consumeError(object_file.takeError());
+            discard("bad object code");
+            return nullptr;
+        }
+
+        debug(1) << "JIT cache hit for " << function_name << ": " << path << "\n";
+        object = std::move(buffer);
+        return std::move(*skeleton);
+    }
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *) override {
+        return std::move(object);
+    }
+
+    void notifyObjectCompiled(const llvm::Module *m, llvm::MemoryBufferRef object_code) override {
+        llvm::LLVMContext &context = m->getContext();
+        llvm::Module skeleton(m->getModuleIdentifier(), context);
+        skeleton.setTargetTriple(m->getTargetTriple());
+        skeleton.setDataLayout(m->getDataLayout());
+        llvm::SmallVector<llvm::Module::ModuleFlagEntry, 8> flags;
+        m->getModuleFlagsMetadata(flags);
+        for (const auto &flag : flags) {
+            skeleton.addModuleFlag(flag.Behavior, flag.Key->getString(), flag.Val);
+        }
+        llvm::FunctionType *stub_type = llvm::FunctionType::get(llvm::Type::getVoidTy(context), false);
+        for (const std::string &name : {function_name, function_name + "_argv"}) {
+            llvm::Function *stub = llvm::Function::Create(stub_type, llvm::Function::ExternalLinkage, name, &skeleton);
+            new llvm::UnreachableInst(context, llvm::BasicBlock::Create(context, "", stub));
+        }
+        llvm::SmallVector<char, 0> bitcode;
+        llvm::raw_svector_ostream bitcode_stream(bitcode);
+        llvm::WriteBitcodeToFile(skeleton, bitcode_stream);
+
+        // Write to a temporary file and rename it into place, so that
+        // other processes never see a partially-written entry.
+        std::string temp_path = path + "." + std::to_string(std::random_device()()) + ".tmp";
+        bool ok;
+        {
+            std::ofstream out(temp_path, std::ios::binary);
+            out << jit_cache_header << "\n"
+                << key << "\n"
+                << bitcode.size() << " " << object_code.getBufferSize() << "\n";
+            out.write(bitcode.data(), bitcode.size());
+            out.write(object_code.getBufferStart(), object_code.getBufferSize());
+            ok = (bool)out;
+        }
+        if (ok) {
+            ok = std::rename(temp_path.c_str(), path.c_str()) == 0;
+        }
+        if (ok) {
+            debug(1) << "Wrote JIT cache entry for " << function_name << ": " << path << "\n";
+        } else {
+            debug(1) << "Could not write JIT cache entry " << path << "\n";
+            std::remove(temp_path.c_str());
+        }
+    }
+};
+
 }  // namespace
 
 JITModule::JITModule() {
@@ -219,18 +438,26 @@ JITModule::JITModule() {
 JITModule::JITModule(const Module &m, const LoweredFunc &fn,
                      const std::vector<JITModule> &dependencies) {
     jit_module = new JITModuleContents();
-    std::unique_ptr<llvm::Module> llvm_module(compile_module_to_llvm_module(m, jit_module->context));
+    std::unique_ptr<JITObjectCache> object_cache = JITObjectCache::make(m, fn.name);
+    std::unique_ptr<llvm::Module> llvm_module;
+    if (object_cache) {
+        llvm_module = object_cache->load(jit_module->context);
+    }
+    if (!llvm_module) {
+        llvm_module = compile_module_to_llvm_module(m, jit_module->context);
+    }
     std::vector<JITModule> deps_with_runtime = dependencies;
     std::vector<JITModule> shared_runtime = JITSharedRuntime::get(llvm_module.get(), m.target());
     deps_with_runtime.insert(deps_with_runtime.end(), shared_runtime.begin(), shared_runtime.end());
-    compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime);
+    compile_module(std::move(llvm_module), fn.name, m.target(), deps_with_runtime, {}, object_cache.get());
     // If -time-passes is in HL_LLVM_ARGS, this will print llvm passes time statstics otherwise its no-op.
     llvm::reportAndResetTimings();
 }
 
 void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &function_name, const Target &target,
                                const std::vector<JITModule> &dependencies,
-                               const std::vector<std::string> &requested_exports) {
+                               const std::vector<std::string> &requested_exports,
+                               llvm::ObjectCache *object_cache) {
 
     // Ensure that LLVM is initialized
     CodeGen_LLVM::initialize_llvm();
@@ -278,6 +505,10 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
     }
     internal_assert(ee) << "Couldn't create execution engine\n";
 
+    if (object_cache) {
+        ee->setObjectCache(object_cache);
+    }
+
     // Do any target-specific initialization
     std::vector<llvm::JITEventListener *> listeners;
 
@@ -313,6 +544,8 @@ void JITModule::compile_module(std::unique_ptr<llvm::Module> m, const string &fu
 
     debug(2) << "Finalizing object\n";
     ee->finalizeObject();
+    // The object cache doesn't outlive this call.
+    ee->setObjectCache(nullptr);
     // Do any target-specific post-compilation module meddling
     for (size_t i = 0; i < listeners.size(); i++) {
         ee->UnregisterJITEventListener(listeners[i]);
@@ -435,6 +668,33 @@ void JITModule::memoization_cache_set_size(int64_t size) const {
     }
 }
 
+void JITModule::memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_set_eviction_policy");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(halide_memoization_cache_eviction_policy_t)>(f->second.address))(policy);
+    }
+}
+
+halide_memoization_cache_stats_t JITModule::memoization_cache_get_stats() const {
+    halide_memoization_cache_stats_t stats = {};
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_get_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(halide_memoization_cache_stats_t *)>(f->second.address))(&stats);
+    }
+    return stats;
+}
+
+int JITModule::memoization_cache_set_disk_tier(const char *directory, int64_t max_size) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_memoization_cache_set_disk_tier");
+    if (f != exports().end()) {
+        return (reinterpret_bits<int (*)(const char *, int64_t)>(f->second.address))(directory, max_size);
+    }
+    return halide_error_code_generic_error;
+}
+
 void JITModule::reuse_device_allocations(bool b) const {
     std::map<std::string, Symbol>::const_iterator f =
         exports().find("halide_reuse_device_allocations");
@@ -443,6 +703,33 @@ void JITModule::reuse_device_allocations(bool b) const {
     }
 }
 
+bool JITModule::set_host_allocation_pooling(bool b) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_set_host_allocation_pooling");
+    if (f != exports().end()) {
+        return (reinterpret_bits<bool (*)(bool)>(f->second.address))(b);
+    }
+    return false;
+}
+
+void JITModule::trim_host_allocation_pool(uint64_t max_cached_bytes) const {
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_trim_host_allocation_pool");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(void *, uint64_t)>(f->second.address))(nullptr, max_cached_bytes);
+    }
+}
+
+halide_host_allocation_pool_stats JITModule::get_host_allocation_pool_stats() const {
+    halide_host_allocation_pool_stats stats = {};
+    std::map<std::string, Symbol>::const_iterator f =
+        exports().find("halide_get_host_allocation_pool_stats");
+    if (f != exports().end()) {
+        (reinterpret_bits<void (*)(void *, halide_host_allocation_pool_stats *)>(f->second.address))(nullptr, &stats);
+    }
+    return stats;
+}
+
 bool JITModule::compiled() const {
     return jit_module->execution_engine != nullptr;
 }
@@ -921,10 +1208,40 @@ void JITSharedRuntime::memoization_cache_set_size(int64_t size) {
     }
 }
 
+void JITSharedRuntime::memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    shared_runtimes(MainShared).memoization_cache_set_eviction_policy(policy);
+}
+
+halide_memoization_cache_stats_t JITSharedRuntime::memoization_cache_get_stats() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    return shared_runtimes(MainShared).memoization_cache_get_stats();
+}
+
+int JITSharedRuntime::memoization_cache_set_disk_tier(const char *directory, int64_t max_size) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    return shared_runtimes(MainShared).memoization_cache_set_disk_tier(directory, max_size);
+}
+
 void JITSharedRuntime::reuse_device_allocations(bool b) {
     std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
     shared_runtimes(MainShared).reuse_device_allocations(b);
 }
 
+bool JITSharedRuntime::set_host_allocation_pooling(bool b) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    return shared_runtimes(MainShared).set_host_allocation_pooling(b);
+}
+
+void JITSharedRuntime::trim_host_allocation_pool(uint64_t max_cached_bytes) {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    shared_runtimes(MainShared).trim_host_allocation_pool(max_cached_bytes);
+}
+
+halide_host_allocation_pool_stats JITSharedRuntime::get_host_allocation_pool_stats() {
+    std::lock_guard<std::mutex> lock(shared_runtimes_mutex);
+    return shared_runtimes(MainShared).get_host_allocation_pool_stats();
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -15,6 +15,7 @@
 
 namespace llvm {
 class Module;
+class ObjectCache;
 }
 
 namespace Halide {
@@ -118,18 +119,39 @@ struct JITModule {
     Symbol find_symbol_by_name(const std::string &) const;
 
     /** Take an llvm module and compile it. The requested exports will
-        be available via the exports method. */
+        be available via the exports method. If an object cache is
+        given, the execution engine asks it for the object code before
+        generating any, and hands it any object code it does generate. */
     void compile_module(std::unique_ptr<llvm::Module> mod,
                         const std::string &function_name, const Target &target,
                         const std::vector<JITModule> &dependencies = std::vector<JITModule>(),
-                        const std::vector<std::string> &requested_exports = std::vector<std::string>());
+                        const std::vector<std::string> &requested_exports = std::vector<std::string>(),
+                        llvm::ObjectCache *object_cache = nullptr);
 
     /** See JITSharedRuntime::memoization_cache_set_size */
     void memoization_cache_set_size(int64_t size) const;
 
+    /** See JITSharedRuntime::memoization_cache_set_eviction_policy */
+    void memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) const;
+
+    /** See JITSharedRuntime::memoization_cache_get_stats */
+    halide_memoization_cache_stats_t memoization_cache_get_stats() const;
+
+    /** See JITSharedRuntime::memoization_cache_set_disk_tier */
+    int memoization_cache_set_disk_tier(const char *directory, int64_t max_size) const;
+
     /** See JITSharedRuntime::reuse_device_allocations */
     void reuse_device_allocations(bool) const;
 
+    /** See JITSharedRuntime::set_host_allocation_pooling */
+    bool set_host_allocation_pooling(bool) const;
+
+    /** See JITSharedRuntime::trim_host_allocation_pool */
+    void trim_host_allocation_pool(uint64_t max_cached_bytes) const;
+
+    /** See JITSharedRuntime::get_host_allocation_pool_stats */
+    halide_host_allocation_pool_stats get_host_allocation_pool_stats() const;
+
     /** Return true if compile_module has been called on this module. */
     bool compiled() const;
 };
@@ -167,6 +189,28 @@ public:
      */
     static void memoization_cache_set_size(int64_t size);
 
+    /** Set the policy the memoization cache uses to choose entries to
+     * evict. If you are compiling statically, you should include
+     * HalideRuntime.h and call
+     * halide_memoization_cache_set_eviction_policy() instead. */
+    static void memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy);
+
+    /** Get the hit, miss and eviction counts and current size of the
+     * memoization cache. If you are compiling statically, you should
+     * include HalideRuntime.h and call
+     * halide_memoization_cache_get_stats() instead. */
+    static halide_memoization_cache_stats_t memoization_cache_get_stats();
+
+    /** Keep memoized results evicted from memory, or still cached when
+     * the JIT runtime is released, in files in the given directory,
+     * and map them back in on a miss, so that a later process starts
+     * with a warm cache. At most max_size bytes of files are kept. Pass
+     * nullptr to turn this off and remove the files. Returns zero on
+     * success. If you are
+     * compiling statically, you should include HalideRuntime.h and
+     * call halide_memoization_cache_set_disk_tier() instead. */
+    static int memoization_cache_set_disk_tier(const char *directory, int64_t max_size);
+
     /** Set whether or not Halide may hold onto and reuse device
      * allocations to avoid calling expensive device API allocation
      * functions. If you are compiling statically, you should include
@@ -174,6 +218,24 @@ public:
      * instead. */
     static void reuse_device_allocations(bool);
 
+    /** Set whether host allocations freed by pipelines are kept in a
+     * pool for reuse. Returns the old setting. If you are compiling
+     * statically, you should include HalideRuntime.h and call
+     * halide_set_host_allocation_pooling() instead. */
+    static bool set_host_allocation_pooling(bool);
+
+    /** Release blocks cached by the host allocation pool until it holds
+     * at most max_cached_bytes. If you are compiling statically, you
+     * should include HalideRuntime.h and call
+     * halide_trim_host_allocation_pool() instead. */
+    static void trim_host_allocation_pool(uint64_t max_cached_bytes);
+
+    /** Get the allocation and hit counts, and the cached blocks, of the
+     * host allocation pool. If you are compiling statically, you should
+     * include HalideRuntime.h and call
+     * halide_get_host_allocation_pool_stats() instead. */
+    static halide_host_allocation_pool_stats get_host_allocation_pool_stats();
+
     static void release_all();
 };
 
@@ -5,6 +5,7 @@
 #include "CompilerLogger.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Runtime_Linker.h"
+#include "ThreadPool.h"
 
 #include <fstream>
 #include <iostream>
@@ -403,6 +404,175 @@ void compile_llvm_module_to_object(llvm::Module &module, Internal::LLVMOStream &
     emit_file(module, out, llvm::CGFT_ObjectFile);
 }
 
+void compile_llvm_module_to_objects(llvm::Module &module, const std::vector<Internal::LLVMOStream *> &outs) {
+    internal_assert(!outs.empty());
+    if (outs.size() == 1) {
+        compile_llvm_module_to_object(module, *outs[0]);
+        return;
+    }
+
+    Internal::debug(1) << "Compiling to native code in " << outs.size() << " partitions...\n";
+
+    auto time_start = std::chrono::high_resolution_clock::now();
+
+    std::unique_ptr<llvm::Module> split_module = clone_module(module);
+
+    // emit_file inlines always-inline functions, but can't once they
+    // might be in another partition.
+    {
+        llvm::legacy::PassManager pass_manager;
+        pass_manager.add(llvm::createAlwaysInlinerLegacyPass());
+        pass_manager.run(*split_module);
+    }
+
+    // A partition can only refer to things in other partitions by name,
+    // so nothing can have local linkage. Prefix the names so that they
+    // don't collide with the same symbols from other Halide pipelines.
+    const std::string prefix = split_module->getModuleIdentifier() + ".";
+    int unnamed = 0;
+    auto externalize = [&](llvm::GlobalValue &v) {
+        if (v.hasLocalLinkage()) {
+            v.setName(prefix + (v.hasName() ? v.getName().str() : "unnamed." + std::to_string(unnamed++)));
+            v.setLinkage(llvm::GlobalValue::ExternalLinkage);
+            v.setVisibility(llvm::GlobalValue::HiddenVisibility);
+        }
+    };
+    for (auto &f : split_module->functions()) {
+        externalize(f);
+    }
+    for (auto &g : split_module->globals()) {
+        externalize(g);
+    }
+    for (auto &a : split_module->aliases()) {
+        externalize(a);
+    }
+
+    // A static library member is only linked if something refers to one
+    // of its symbols, so the global constructors and destructors (e.g.
+    // halide_cache_cleanup) would be dropped if they landed in a
+    // partition of their own. Take them out of the module, and register
+    // them again in the first partition below.
+    struct Structor {
+        std::string name;
+        llvm::FunctionType *type;
+        int priority;
+    };
+    std::vector<Structor> ctors, dtors;
+    auto take_structors = [&](const char *name, std::vector<Structor> &result) {
+        llvm::GlobalVariable *g = split_module->getNamedGlobal(name);
+        if (!g) {
+            return;
+        }
+        if (g->hasInitializer()) {
+            if (auto *array = llvm::dyn_cast<llvm::ConstantArray>(g->getInitializer())) {
+                for (auto &op : array->operands()) {
+                    auto *entry = llvm::dyn_cast<llvm::ConstantStruct>(op);
+                    if (!entry) {
+                        continue;
+                    }
+                    auto *priority = llvm::dyn_cast<llvm::ConstantInt>(entry->getOperand(0));
+                    auto *fn = llvm::dyn_cast<llvm::Function>(entry->getOperand(1)->stripPointerCasts());
+                    internal_assert(priority && fn) << "Unexpected entry in " << name << "\n";
+                    result.push_back({fn->getName().str(), fn->getFunctionType(), (int)priority->getSExtValue()});
+                }
+            }
+        }
+        g->eraseFromParent();
+    };
+    take_structors("llvm.global_ctors", ctors);
+    take_structors("llvm.global_dtors", dtors);
+
+    // Every other partition refers to a symbol defined in the first one,
+    // so that linking any member of the library links the first member
+    // too, along with the constructors and destructors it registers.
+    const std::string anchor_name = prefix + "partition_anchor";
+
+    // The partitions share the split module's context, so serialize
+    // them, and parse each one into a context of its own on its thread.
+    std::vector<llvm::SmallVector<char, 0>> partitions;
+    auto add_partition = [&](std::unique_ptr<llvm::Module> partition) {
+        llvm::Type *i8_t = llvm::Type::getInt8Ty(partition->getContext());
+        if (partitions.empty()) {
+            auto *anchor = new llvm::GlobalVariable(*partition, i8_t, true, llvm::GlobalValue::ExternalLinkage,
+                                                    llvm::ConstantInt::get(i8_t, 0), anchor_name);
+            anchor->setVisibility(llvm::GlobalValue::HiddenVisibility);
+            for (const auto &s : ctors) {
+                auto *fn = llvm::cast<llvm::Function>(partition->getOrInsertFunction(s.name, s.type).getCallee());
+                llvm::appendToGlobalCtors(*partition, fn, s.priority);
+            }
+            for (const auto &s : dtors) {
+                auto *fn = llvm::cast<llvm::Function>(partition->getOrInsertFunction(s.name, s.type).getCallee());
+                llvm::appendToGlobalDtors(*partition, fn, s.priority);
+            }
+        } else {
+            auto *anchor = new llvm::GlobalVariable(*partition, i8_t, true, llvm::GlobalValue::ExternalLinkage,
+                                                    nullptr, anchor_name);
+            anchor->setVisibility(llvm::GlobalValue::HiddenVisibility);
+            auto *ref = new llvm::GlobalVariable(*partition, anchor->getType(), true, llvm::GlobalValue::PrivateLinkage,
+                                                 anchor, anchor_name + ".ref");
+            llvm::appendToCompilerUsed(*partition, {ref});
+        }
+
+        partitions.emplace_back();
+        llvm::raw_svector_ostream out(partitions.back());
+        WriteBitcodeToFile(*partition, out);
+    };
+#if LLVM_VERSION >= 130
+    llvm::SplitModule(*split_module, outs.size(), add_partition, /* PreserveLocals */ true);
+#else
+    llvm::SplitModule(std::move(split_module), outs.size(), add_partition, /* PreserveLocals */ true);
+#endif
+    internal_assert(partitions.size() == outs.size());
+
+    auto compile_partition = [&](size_t i) {
+        llvm::LLVMContext context;
+        llvm::MemoryBufferRef buffer_ref(llvm::StringRef(partitions[i].data(), partitions[i].size()), "partition");
+        auto partition = llvm::parseBitcodeFile(buffer_ref, context);
+        internal_assert(partition);
+        emit_file(*partition.get(), *outs[i], llvm::CGFT_ObjectFile);
+    };
+
+#ifdef HALIDE_WITH_EXCEPTIONS
+    std::vector<std::exception_ptr> errors(outs.size());
+#endif
+    {
+        Internal::ThreadPool<void> pool(outs.size());
+        std::vector<std::future<void>> futures;
+        for (size_t i = 0; i < outs.size(); i++) {
+            futures.push_back(pool.async([&, i]() {
+#ifdef HALIDE_WITH_EXCEPTIONS
+                try {
+                    compile_partition(i);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+#else
+                compile_partition(i);
+#endif
+            }));
+        }
+        for (auto &f : futures) {
+            f.wait();
+        }
+    }
+#ifdef HALIDE_WITH_EXCEPTIONS
+    for (const auto &e : errors) {
+        if (e) {
+            std::rethrow_exception(e);
+        }
+    }
+#endif
+
+    // The partitions were compiled on other threads, which have no
+    // compiler logger.
+    auto *logger = Internal::get_compiler_logger();
+    if (logger) {
+        auto time_end = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> diff = time_end - time_start;
+        logger->record_compilation_time(Internal::CompilerLogger::Phase::LLVM, diff.count());
+    }
+}
+
 void compile_llvm_module_to_assembly(llvm::Module &module, Internal::LLVMOStream &out) {
     emit_file(module, out, llvm::CGFT_AssemblyFile);
 }
@@ -39,6 +39,14 @@ void compile_llvm_module_to_object(llvm::Module &module, Internal::LLVMOStream &
 void compile_llvm_module_to_assembly(llvm::Module &module, Internal::LLVMOStream &out);
 // @}
 
+/** Compile an LLVM module to one object file per output stream, which
+ * together define what compile_llvm_module_to_object() would. The module
+ * is split into one partition per output, and the partitions are
+ * compiled in parallel. Symbols with local linkage become hidden symbols
+ * prefixed with the module name, so that the partitions can refer to
+ * each other. */
+void compile_llvm_module_to_objects(llvm::Module &module, const std::vector<Internal::LLVMOStream *> &outs);
+
 /** Compile an LLVM module to LLVM targets (bitcode, LLVM assembly). */
 // @{
 void compile_llvm_module_to_llvm_bitcode(llvm::Module &module, Internal::LLVMOStream &out);
@@ -49,6 +49,7 @@
 #include "RemoveDeadAllocations.h"
 #include "RemoveExternLoops.h"
 #include "RemoveUndef.h"
+#include "ReuseHeapAllocations.h"
 #include "ScheduleFunctions.h"
 #include "SelectGPUAPI.h"
 #include "Simplify.h"
@@ -80,6 +81,55 @@ using std::ostringstream;
 using std::string;
 using std::vector;
 
+namespace {
+
+// Reports the time taken by each lowering pass, and the number of IR
+// nodes it leaves behind, to the active CompilerLogger.
+class LoweringPassLogger {
+    CompilerLogger *logger;
+    std::chrono::high_resolution_clock::time_point start;
+
+    class CountNodes : public IRGraphVisitor {
+        std::set<const IRNode *> seen;
+
+        void include(const Expr &e) override {
+            if (seen.insert(e.get()).second) {
+                e.accept(this);
+            }
+        }
+
+        void include(const Stmt &s) override {
+            if (seen.insert(s.get()).second) {
+                s.accept(this);
+            }
+        }
+
+    public:
+        uint64_t count(const Stmt &s) {
+            include(s);
+            return seen.size();
+        }
+    };
+
+public:
+    LoweringPassLogger(std::chrono::high_resolution_clock::time_point start)
+        : logger(get_compiler_logger()), start(start) {
+    }
+
+    // Each pass is considered to start where the previous one ended.
+    void operator()(const string &pass, const Stmt &s) {
+        if (!logger) {
+            return;
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+        logger->record_lowering_pass(pass, diff.count(), CountNodes().count(s));
+        // Don't charge the counting to the next pass.
+        start = std::chrono::high_resolution_clock::now();
+    }
+};
+
+}  // namespace
+
 Module lower(const vector<Function> &output_funcs,
              const string &pipeline_name,
              const Target &t,
@@ -89,6 +139,21 @@ Module lower(const vector<Function> &output_funcs,
              bool trace_pipeline,
              const vector<IRMutator *> &custom_passes) {
     auto time_start = std::chrono::high_resolution_clock::now();
+    LoweringPassLogger log_pass(time_start);
+
+    // Let the passes that compute the boxes touched by the same IR
+    // share the results, unless the caller already has a cache going.
+    std::unique_ptr<ScopedBoxesCache> boxes_cache;
+    if (!ScopedBoxesCache::active() && get_env_variable("HL_BOXES_CACHE") != "0") {
+        boxes_cache = std::make_unique<ScopedBoxesCache>();
+    }
+
+    // Optionally share the constants and Variables we make along the
+    // way.
+    std::unique_ptr<ScopedIRInterning> interning;
+    if (get_env_variable("HL_INTERN_IR") == "1") {
+        interning = std::make_unique<ScopedIRInterning>();
+    }
 
     std::vector<std::string> namespaces;
     std::string simple_pipeline_name = extract_namespaces(pipeline_name, namespaces);
@@ -134,12 +199,14 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Creating initial loop nests...\n";
     bool any_memoized = false;
     Stmt s = schedule_functions(outputs, fused_groups, env, t, any_memoized);
+    log_pass("creating initial loop nests", s);
     debug(2) << "Lowering after creating initial loop nests:\n"
              << s << "\n";
 
     if (any_memoized) {
         debug(1) << "Injecting memoization...\n";
         s = inject_memoization(s, env, pipeline_name, outputs);
+        log_pass("injecting memoization", s);
         debug(2) << "Lowering after injecting memoization:\n"
                  << s << "\n";
     } else {
@@ -148,11 +215,13 @@ Module lower(const vector<Function> &output_funcs,
 
     debug(1) << "Injecting tracing...\n";
     s = inject_tracing(s, pipeline_name, trace_pipeline, env, outputs, t);
+    log_pass("injecting tracing", s);
     debug(2) << "Lowering after injecting tracing:\n"
              << s << "\n";
 
     debug(1) << "Adding checks for parameters\n";
     s = add_parameter_checks(requirements, s, t);
+    log_pass("injecting parameter checks", s);
     debug(2) << "Lowering after injecting parameter checks:\n"
              << s << "\n";
 
@@ -166,16 +235,19 @@ Module lower(const vector<Function> &output_funcs,
     // can still simplify Exprs).
     debug(1) << "Performing computation bounds inference...\n";
     s = bounds_inference(s, outputs, order, fused_groups, env, func_bounds, t);
+    log_pass("computation bounds inference", s);
     debug(2) << "Lowering after computation bounds inference:\n"
              << s << "\n";
 
     debug(1) << "Removing extern loops...\n";
     s = remove_extern_loops(s);
+    log_pass("removing extern loops", s);
     debug(2) << "Lowering after removing extern loops:\n"
              << s << "\n";
 
     debug(1) << "Performing sliding window optimization...\n";
     s = sliding_window(s, env);
+    log_pass("sliding window", s);
     debug(2) << "Lowering after sliding window:\n"
              << s << "\n";
 
@@ -184,21 +256,25 @@ Module lower(const vector<Function> &output_funcs,
     // equivalence means semantic equivalence.
     debug(1) << "Uniquifying variable names...\n";
     s = uniquify_variable_names(s);
+    log_pass("uniquifying variable names", s);
     debug(2) << "Lowering after uniquifying variable names:\n"
              << s << "\n\n";
 
     debug(1) << "Simplifying...\n";
     s = simplify(s, false);  // Storage folding and allocation bounds inference needs .loop_max symbols
+    log_pass("first simplification", s);
     debug(2) << "Lowering after first simplification:\n"
              << s << "\n\n";
 
     debug(1) << "Simplifying correlated differences...\n";
     s = simplify_correlated_differences(s);
+    log_pass("simplifying correlated differences", s);
     debug(2) << "Lowering after simplifying correlated differences:\n"
              << s << "\n";
 
     debug(1) << "Performing allocation bounds inference...\n";
     s = allocation_bounds_inference(s, env, func_bounds);
+    log_pass("allocation bounds inference", s);
     debug(2) << "Lowering after allocation bounds inference:\n"
              << s << "\n";
 
@@ -211,46 +287,55 @@ Module lower(const vector<Function> &output_funcs,
 
     debug(1) << "Adding checks for images\n";
     s = add_image_checks(s, outputs, t, order, env, func_bounds, will_inject_host_copies);
+    log_pass("injecting image checks", s);
     debug(2) << "Lowering after injecting image checks:\n"
              << s << '\n';
 
     debug(1) << "Removing code that depends on undef values...\n";
     s = remove_undef(s);
+    log_pass("removing code that depends on undef values", s);
     debug(2) << "Lowering after removing code that depends on undef values:\n"
              << s << "\n\n";
 
     debug(1) << "Performing storage folding optimization...\n";
     s = storage_folding(s, env);
+    log_pass("storage folding", s);
     debug(2) << "Lowering after storage folding:\n"
              << s << "\n";
 
     debug(1) << "Injecting debug_to_file calls...\n";
     s = debug_to_file(s, outputs, env);
+    log_pass("injecting debug_to_file calls", s);
     debug(2) << "Lowering after injecting debug_to_file calls:\n"
              << s << "\n";
 
     debug(1) << "Injecting prefetches...\n";
     s = inject_prefetch(s, env);
+    log_pass("injecting prefetches", s);
     debug(2) << "Lowering after injecting prefetches:\n"
              << s << "\n\n";
 
     debug(1) << "Discarding safe promises...\n";
     s = lower_safe_promises(s);
+    log_pass("discarding safe promises", s);
     debug(2) << "Lowering after discarding safe promises:\n"
              << s << "\n\n";
 
     debug(1) << "Dynamically skipping stages...\n";
     s = skip_stages(s, order);
+    log_pass("dynamically skipping stages", s);
     debug(2) << "Lowering after dynamically skipping stages:\n"
              << s << "\n\n";
 
     debug(1) << "Forking asynchronous producers...\n";
     s = fork_async_producers(s, env);
+    log_pass("forking asynchronous producers", s);
     debug(2) << "Lowering after forking asynchronous producers:\n"
              << s << "\n";
 
     debug(1) << "Destructuring tuple-valued realizations...\n";
     s = split_tuples(s, env);
+    log_pass("destructuring tuple-valued realizations", s);
     debug(2) << "Lowering after destructuring tuple-valued realizations:\n"
              << s << "\n\n";
 
@@ -261,6 +346,7 @@ Module lower(const vector<Function> &output_funcs,
         t.has_feature(Target::OpenGL)) {
         debug(1) << "Canonicalizing GPU var names...\n";
         s = canonicalize_gpu_vars(s);
+        log_pass("canonicalizing GPU var names", s);
         debug(2) << "Lowering after canonicalizing GPU var names:\n"
                  << s << "\n";
     }
@@ -268,27 +354,32 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Bounding small realizations...\n";
     s = simplify_correlated_differences(s);
     s = bound_small_allocations(s);
+    log_pass("bounding small realizations", s);
     debug(2) << "Lowering after bounding small realizations:\n"
              << s << "\n\n";
 
     debug(1) << "Performing storage flattening...\n";
     s = storage_flattening(s, outputs, env, t);
+    log_pass("storage flattening", s);
     debug(2) << "Lowering after storage flattening:\n"
              << s << "\n\n";
 
     debug(1) << "Adding atomic mutex allocation...\n";
     s = add_atomic_mutex(s, env);
+    log_pass("adding atomic mutex allocation", s);
     debug(2) << "Lowering after adding atomic mutex allocation:\n"
              << s << "\n\n";
 
     debug(1) << "Unpacking buffer arguments...\n";
     s = unpack_buffers(s);
+    log_pass("unpacking buffer arguments", s);
     debug(2) << "Lowering after unpacking buffer arguments...\n"
              << s << "\n\n";
 
     if (any_memoized) {
         debug(1) << "Rewriting memoized allocations...\n";
         s = rewrite_memoized_allocations(s, env);
+        log_pass("rewriting memoized allocations", s);
         debug(2) << "Lowering after rewriting memoized allocations:\n"
                  << s << "\n\n";
     } else {
@@ -298,16 +389,19 @@ Module lower(const vector<Function> &output_funcs,
     if (will_inject_host_copies) {
         debug(1) << "Selecting a GPU API for GPU loops...\n";
         s = select_gpu_api(s, t);
+        log_pass("selecting a GPU API", s);
         debug(2) << "Lowering after selecting a GPU API:\n"
                  << s << "\n\n";
 
         debug(1) << "Injecting host <-> dev buffer copies...\n";
         s = inject_host_dev_buffer_copies(s, t);
+        log_pass("injecting host <-> dev buffer copies", s);
         debug(2) << "Lowering after injecting host <-> dev buffer copies:\n"
                  << s << "\n\n";
 
         debug(1) << "Selecting a GPU API for extern stages...\n";
         s = select_gpu_api(s, t);
+        log_pass("selecting a GPU API for extern stages", s);
         debug(2) << "Lowering after selecting a GPU API for extern stages:\n"
                  << s << "\n\n";
     }
@@ -315,6 +409,7 @@ Module lower(const vector<Function> &output_funcs,
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Injecting OpenGL texture intrinsics...\n";
         s = inject_opengl_intrinsics(s);
+        log_pass("OpenGL intrinsics", s);
         debug(2) << "Lowering after OpenGL intrinsics:\n"
                  << s << "\n\n";
     }
@@ -322,28 +417,41 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Simplifying...\n";
     s = simplify(s);
     s = unify_duplicate_lets(s);
+    log_pass("second simplification", s);
     debug(2) << "Lowering after second simplifcation:\n"
              << s << "\n\n";
 
+    if (t.has_feature(Target::AutoPrefetch)) {
+        debug(1) << "Injecting automatic prefetches...\n";
+        s = inject_auto_prefetch(s, t);
+        log_pass("injecting automatic prefetches", s);
+        debug(2) << "Lowering after injecting automatic prefetches:\n"
+                 << s << "\n\n";
+    }
+
     debug(1) << "Reduce prefetch dimension...\n";
     s = reduce_prefetch_dimension(s, t);
+    log_pass("reduce prefetch dimension", s);
     debug(2) << "Lowering after reduce prefetch dimension:\n"
              << s << "\n";
 
     debug(1) << "Simplifying correlated differences...\n";
     s = simplify_correlated_differences(s);
+    log_pass("simplifying correlated differences", s);
     debug(2) << "Lowering after simplifying correlated differences:\n"
              << s << "\n";
 
     debug(1) << "Unrolling...\n";
     s = unroll_loops(s);
     s = simplify(s);
+    log_pass("unrolling", s);
     debug(2) << "Lowering after unrolling:\n"
              << s << "\n\n";
 
     debug(1) << "Vectorizing...\n";
     s = vectorize_loops(s, env, t);
     s = simplify(s);
+    log_pass("vectorizing", s);
     debug(2) << "Lowering after vectorizing:\n"
              << s << "\n\n";
 
@@ -351,6 +459,7 @@ Module lower(const vector<Function> &output_funcs,
         t.has_feature(Target::OpenGLCompute)) {
         debug(1) << "Injecting per-block gpu synchronization...\n";
         s = fuse_gpu_thread_loops(s);
+        log_pass("injecting per-block gpu synchronization", s);
         debug(2) << "Lowering after injecting per-block gpu synchronization:\n"
                  << s << "\n\n";
     }
@@ -358,50 +467,65 @@ Module lower(const vector<Function> &output_funcs,
     debug(1) << "Detecting vector interleavings...\n";
     s = rewrite_interleavings(s);
     s = simplify(s);
+    log_pass("rewriting vector interleavings", s);
     debug(2) << "Lowering after rewriting vector interleavings:\n"
              << s << "\n\n";
 
     debug(1) << "Partitioning loops to simplify boundary conditions...\n";
     s = partition_loops(s);
     s = simplify(s);
+    log_pass("partitioning loops", s);
     debug(2) << "Lowering after partitioning loops:\n"
              << s << "\n\n";
 
     debug(1) << "Trimming loops to the region over which they do something...\n";
     s = trim_no_ops(s);
+    log_pass("loop trimming", s);
     debug(2) << "Lowering after loop trimming:\n"
              << s << "\n\n";
 
     debug(1) << "Hoisting loop invariant if statements...\n";
     s = hoist_loop_invariant_if_statements(s);
+    log_pass("hoisting loop invariant if statements", s);
     debug(2) << "Lowering after hoisting loop invariant if statements:\n"
              << s << "\n\n";
 
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
+    log_pass("injecting early frees", s);
     debug(2) << "Lowering after injecting early frees:\n"
              << s << "\n\n";
 
     if (t.has_feature(Target::FuzzFloatStores)) {
         debug(1) << "Fuzzing floating point stores...\n";
         s = fuzz_float_stores(s);
+        log_pass("fuzzing floating point stores", s);
         debug(2) << "Lowering after fuzzing floating point stores:\n"
                  << s << "\n\n";
     }
 
     debug(1) << "Simplifying correlated differences...\n";
     s = simplify_correlated_differences(s);
+    log_pass("simplifying correlated differences", s);
     debug(2) << "Lowering after simplifying correlated differences:\n"
              << s << "\n";
 
     debug(1) << "Bounding small allocations...\n";
     s = bound_small_allocations(s);
+    log_pass("bounding small allocations", s);
     debug(2) << "Lowering after bounding small allocations:\n"
              << s << "\n\n";
 
-    if (t.has_feature(Target::Profile)) {
+    debug(1) << "Reusing heap allocations...\n";
+    s = reuse_heap_allocations(s);
+    log_pass("reusing heap allocations", s);
+    debug(2) << "Lowering after reusing heap allocations:\n"
+             << s << "\n\n";
+
+    if (t.has_feature(Target::Profile) || t.has_feature(Target::ProfileEvents)) {
         debug(1) << "Injecting profiling...\n";
-        s = inject_profiling(s, pipeline_name);
+        s = inject_profiling(s, pipeline_name, t.has_feature(Target::ProfileEvents));
+        log_pass("injecting profiling", s);
         debug(2) << "Lowering after injecting profiling:\n"
                  << s << "\n\n";
     }
@@ -409,32 +533,38 @@ Module lower(const vector<Function> &output_funcs,
     if (t.has_feature(Target::CUDA)) {
         debug(1) << "Injecting warp shuffles...\n";
         s = lower_warp_shuffles(s);
+        log_pass("injecting warp shuffles", s);
         debug(2) << "Lowering after injecting warp shuffles:\n"
                  << s << "\n\n";
     }
 
     debug(1) << "Simplifying...\n";
     s = common_subexpression_elimination(s);
+    log_pass("common subexpression elimination", s);
 
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Detecting varying attributes...\n";
         s = find_linear_expressions(s);
+        log_pass("detecting varying attributes", s);
         debug(2) << "Lowering after detecting varying attributes:\n"
                  << s << "\n\n";
 
         debug(1) << "Moving varying attribute expressions out of the shader...\n";
         s = setup_gpu_vertex_buffer(s);
+        log_pass("removing varying attributes", s);
         debug(2) << "Lowering after removing varying attributes:\n"
                  << s << "\n\n";
     }
 
     debug(1) << "Lowering unsafe promises...\n";
     s = lower_unsafe_promises(s, t);
+    log_pass("lowering unsafe promises", s);
     debug(2) << "Lowering after lowering unsafe promises:\n"
              << s << "\n\n";
 
     debug(1) << "Flattening nested ramps...\n";
     s = flatten_nested_ramps(s);
+    log_pass("flattening nested ramps", s);
     debug(2) << "Lowering after flattening nested ramps:\n"
              << s << "\n\n";
 
@@ -442,6 +572,7 @@ Module lower(const vector<Function> &output_funcs,
     s = remove_dead_allocations(s);
     s = simplify(s);
     s = hoist_loop_invariant_values(s);
+    log_pass("removing dead allocations and hoisting loop invariant values", s);
     debug(2) << "Lowering after removing dead allocations and hoisting loop invariant values:\n"
              << s << "\n\n";
 
@@ -451,6 +582,7 @@ Module lower(const vector<Function> &output_funcs,
     if (t.arch != Target::Hexagon && t.has_feature(Target::HVX)) {
         debug(1) << "Splitting off Hexagon offload...\n";
         s = inject_hexagon_rpc(s, t, result_module);
+        log_pass("splitting off Hexagon offload", s);
         debug(2) << "Lowering after splitting off Hexagon offload:\n"
                  << s << "\n";
     } else {
@@ -461,6 +593,7 @@ Module lower(const vector<Function> &output_funcs,
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
             s = custom_passes[i]->mutate(s);
+            log_pass("custom pass " + std::to_string(i), s);
             debug(1) << "Lowering after custom pass " << i << ":\n"
                      << s << "\n\n";
         }
@@ -539,6 +672,7 @@ Module lower(const vector<Function> &output_funcs,
         }
     };
     s = StrengthenRefs().mutate(s);
+    log_pass("argument inference", s);
 
     LoweredFunc main_func(pipeline_name, public_args, s, linkage_type);
 
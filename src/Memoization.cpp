@@ -3,12 +3,16 @@
 #include "Function.h"
 #include "IRMutator.h"
 #include "IROperator.h"
+#include "IRPrinter.h"
 #include "Param.h"
 #include "Scope.h"
 #include "Util.h"
 #include "Var.h"
 
+#include <limits>
 #include <map>
+#include <set>
+#include <sstream>
 
 namespace Halide {
 namespace Internal {
@@ -143,6 +147,86 @@ public:
     std::map<DependencyKey, DependencyInfo> dependency_info;
 };
 
+// Builds a description of a Function and of everything it calls that
+// does not depend on where things happen to live in memory, so that a
+// hash of it can identify the computation in a cache key that outlives
+// the process (see the disk tier in runtime/cache.cpp).
+class FingerprintFunction : public IRGraphVisitor {
+    std::set<std::string> visited;
+
+    using IRGraphVisitor::visit;
+
+    void visit(const Call *call) override {
+        if (call->func.defined()) {
+            visit_function(Function(call->func));
+        }
+        if (call->image.defined() && visited.insert(call->image.name()).second) {
+            const Buffer<> &image = call->image;
+            out << "image " << image.name() << " " << image.type() << "\n";
+            for (int i = 0; i < image.dimensions(); i++) {
+                out << image.dim(i).min() << " " << image.dim(i).extent() << " " << image.dim(i).stride() << "\n";
+            }
+            if (image.raw_buffer()->host) {
+                // Hash the contents rather than include them, so that
+                // large images don't make the description large too.
+                const uint8_t *begin = image.raw_buffer()->begin();
+                const uint8_t *end = image.raw_buffer()->end();
+                out << fnv_hash(begin, end - begin) << "\n";
+            }
+        }
+        IRGraphVisitor::visit(call);
+    }
+
+public:
+    std::ostringstream out;
+
+    FingerprintFunction() {
+        // Float constants must be printed exactly, or pipelines that
+        // differ only in them would share a fingerprint.
+        out.precision(std::numeric_limits<double>::max_digits10);
+    }
+
+    void visit_function(const Function &function) {
+        if (!visited.insert(function.name()).second) {
+            return;
+        }
+        out << "func " << function.name() << "(";
+        for (const std::string &arg : function.args()) {
+            out << arg << ",";
+        }
+        out << ")\n";
+        if (function.has_extern_definition()) {
+            out << "extern " << function.extern_function_name() << "\n";
+        }
+        auto print_definition = [&](const Definition &def) {
+            out << "[";
+            for (const Expr &e : def.args()) {
+                out << e << ",";
+            }
+            out << "] = (";
+            for (const Expr &e : def.values()) {
+                out << e << ",";
+            }
+            out << ")\n";
+        };
+        if (function.has_pure_definition()) {
+            print_definition(function.definition());
+        }
+        for (const Definition &def : function.updates()) {
+            print_definition(def);
+        }
+        function.accept(this);
+    }
+
+    static uint64_t fnv_hash(const uint8_t *data, size_t size) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; i++) {
+            h = (h ^ data[i]) * 0x100000001b3ULL;
+        }
+        return h;
+    }
+};
+
 typedef std::pair<FindParameterDependencies::DependencyKey, FindParameterDependencies::DependencyInfo> DependencyKeyInfoPair;
 typedef std::pair<const FindParameterDependencies::DependencyKey, FindParameterDependencies::DependencyInfo> ConstDependencyKeyInfoPair;
 
@@ -151,7 +235,7 @@ class KeyInfo {
     Expr key_size_expr;
     const std::string &top_level_name;
     const std::string &function_name;
-    int memoize_instance;
+    uint64_t fingerprint;
 
     size_t parameters_alignment() {
         int32_t max_alignment = 0;
@@ -170,28 +254,31 @@ class KeyInfo {
         return size_t(1) << i;
     }
 
-    // TODO: Using the full names in the key results in a (hopefully incredibly
-    // slight) performance difference based on how one names filters and
-    // functions. It is arguably a little easier to debug if something
-    // goes wrong as one doesn't need to destructure the cache key by hand
-    // in the debugger. Also, if a pointer is used, a counter must also be
-    // put in the cache key to avoid aliasing on reuse of the address in
-    // JIT situations where code is regenerated into the same region of
-    // memory.
-    //
-    // There is a plan to change the hash function used in the cache and
-    // after that happens, we'll measure performance again and maybe decide
-    // to choose one path or the other (see Git history for the implementation.
-    // It was deleted as part of the address_of intrinsic cleanup).
+    // The key starts with a hash of the names of the pipeline and the
+    // function, the Halide version, and the definitions of the function
+    // and of everything it depends on. Unlike the address of a string
+    // constant, this is the same in every process that compiles the same
+    // pipeline, which lets entries in the disk tier of the cache be found
+    // again after a restart, and it differs between pipelines that merely
+    // share names.
+    static uint64_t compute_fingerprint(const Function &function, const std::string &top_level_name) {
+        FingerprintFunction fingerprinter;
+        fingerprinter.out << "halide " << HALIDE_VERSION_MAJOR << "." << HALIDE_VERSION_MINOR << "." << HALIDE_VERSION_PATCH << "\n";
+        fingerprinter.out << top_level_name.size() << ":" << top_level_name
+                          << function.origin_name().size() << ":" << function.origin_name() << "\n";
+        fingerprinter.visit_function(function);
+        std::string description = fingerprinter.out.str();
+        return FingerprintFunction::fnv_hash((const uint8_t *)description.data(), description.size());
+    }
 
 public:
-    KeyInfo(const Function &function, const std::string &name, int memoize_instance)
+    KeyInfo(const Function &function, const std::string &name)
         : top_level_name(name),
           function_name(function.origin_name()),
-          memoize_instance(memoize_instance) {
+          fingerprint(compute_fingerprint(function, name)) {
         dependencies.visit_function(function);
         size_t size_so_far = 0;
-        size_so_far += Handle().bytes() + 4;
+        size_so_far += UInt(64).bytes();
 
         size_t needed_alignment = parameters_alignment();
         if (needed_alignment > 1) {
@@ -217,24 +304,11 @@ public:
         std::vector<Stmt> writes;
         Expr index = Expr(0);
 
-        // Store a pointer to a string identifying the filter and
-        // function. Assume this will be unique due to CSE. This can
-        // break with loading and unloading of code, though the name
-        // mechanism can also break in those conditions.
-        writes.push_back(Store::make(key_name,
-                                     StringImm::make(std::to_string(top_level_name.size()) + ":" + top_level_name +
-                                                     std::to_string(function_name.size()) + ":" + function_name),
-                                     (index / Handle().bytes()), Parameter(), const_true(), ModulusRemainder()));
-        size_t alignment = Handle().bytes();
-        index += Handle().bytes();
-
-        // Halide compilation is not threadsafe anyway...
-        writes.push_back(Store::make(key_name,
-                                     memoize_instance,
-                                     (index / Int(32).bytes()),
-                                     Parameter(), const_true(), ModulusRemainder()));
-        alignment += 4;
-        index += 4;
+        // Store the fingerprint identifying the filter and function.
+        writes.push_back(Store::make(key_name, make_const(UInt(64), fingerprint),
+                                     (index / UInt(64).bytes()), Parameter(), const_true(), ModulusRemainder()));
+        size_t alignment = UInt(64).bytes();
+        index += UInt(64).bytes();
 
         size_t needed_alignment = parameters_alignment();
         if (needed_alignment > 1) {
@@ -311,15 +385,13 @@ public:
 class InjectMemoization : public IRMutator {
 public:
     const std::map<std::string, Function> &env;
-    int memoize_instance;
     const std::string &top_level_name;
     const std::vector<Function> &outputs;
 
     InjectMemoization(const std::map<std::string, Function> &e,
-                      int memoize_instance,
                       const std::string &name,
                       const std::vector<Function> &outputs)
-        : env(e), memoize_instance(memoize_instance), top_level_name(name), outputs(outputs) {
+        : env(e), top_level_name(name), outputs(outputs) {
     }
 
 private:
@@ -352,7 +424,7 @@ private:
 
             Stmt mutated_body = mutate(op->body);
 
-            KeyInfo key_info(f, top_level_name, memoize_instance);
+            KeyInfo key_info(f, top_level_name);
 
             std::string cache_key_name = op->name + ".cache_key";
             std::string cache_result_name = op->name + ".cache_result";
@@ -413,7 +485,7 @@ private:
                 return ProducerConsumer::make(op->name, op->is_producer, mutated_body);
             } else {
                 const Function f(iter->second);
-                KeyInfo key_info(f, top_level_name, memoize_instance);
+                KeyInfo key_info(f, top_level_name);
 
                 std::string cache_key_name = op->name + ".cache_key";
                 std::string computed_bounds_name = op->name + ".computed_bounds.buffer";
@@ -433,13 +505,7 @@ private:
 Stmt inject_memoization(const Stmt &s, const std::map<std::string, Function> &env,
                         const std::string &name,
                         const std::vector<Function> &outputs) {
-    // Cache keys use the addresses of names of Funcs. For JIT, a
-    // counter for the pipeline is needed as the address may be reused
-    // across pipelines. This isn't a problem when using full names as
-    // the function names already are uniquefied by a counter.
-    static std::atomic<int> memoize_instance{0};
-
-    InjectMemoization injector(env, memoize_instance++, name, outputs);
+    InjectMemoization injector(env, name, outputs);
 
     return injector.mutate(s);
 }
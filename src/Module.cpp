@@ -1,6 +1,7 @@
 #include "Module.h"
 
 #include <array>
+#include <cstdlib>
 #include <fstream>
 #include <future>
 #include <utility>
@@ -18,6 +19,7 @@
 #include "Pipeline.h"
 #include "PythonExtensionGen.h"
 #include "StmtToHtml.h"
+#include "ThreadPool.h"
 
 using Halide::Internal::debug;
 
@@ -63,6 +65,18 @@ std::map<Output, const OutputInfo> get_output_info(const Target &target) {
 
 namespace {
 
+// The number of objects to split the code for a static library into,
+// and so the number of threads to generate it with.
+int llvm_codegen_jobs() {
+    std::string jobs = get_env_variable("HL_LLVM_CODEGEN_JOBS");
+    if (jobs.empty()) {
+        return 1;
+    }
+    int n = std::atoi(jobs.c_str());
+    user_assert(n >= 0) << "HL_LLVM_CODEGEN_JOBS must not be negative\n";
+    return n > 0 ? n : (int)ThreadPool<void>::num_processors_online();
+}
+
 class TemporaryObjectFileDir final {
 public:
     TemporaryObjectFileDir()
@@ -604,16 +618,35 @@ void Module::compile(const std::map<Output, std::string> &output_files) const {
             // no real-world code ever sets both object and static_library
             // at the same time, so there is no meaningful performance advantage
             // to be had.
+            //
+            // The code can be split across several objects, which are
+            // generated in parallel.
             TemporaryObjectFileDir temp_dir;
             {
-                std::string object = temp_dir.add_temp_object_file(output_files.at(Output::static_library), "", target());
-                debug(1) << "Module.compile(): temporary object " << object << "\n";
-                auto out = make_raw_fd_ostream(object);
-                compile_llvm_module_to_object(*llvm_module, *out);
-                out->flush();  // create_static_library() is happier if we do this
-                if (logger && !contains(output_files, Output::object)) {
-                    // Don't double-record object-code size if we already recorded it for object
-                    logger->record_object_code_size(file_stat(object).file_size);
+                int definitions = 0;
+                for (const auto &f : *llvm_module) {
+                    definitions += f.isDeclaration() ? 0 : 1;
+                }
+                const int jobs = std::max(1, std::min(llvm_codegen_jobs(), definitions));
+                std::vector<std::string> objects;
+                std::vector<std::unique_ptr<llvm::raw_fd_ostream>> outs;
+                for (int i = 0; i < jobs; i++) {
+                    std::string suffix = jobs > 1 ? "_" + std::to_string(i) : "";
+                    objects.push_back(temp_dir.add_temp_object_file(output_files.at(Output::static_library), suffix, target()));
+                    debug(1) << "Module.compile(): temporary object " << objects.back() << "\n";
+                    outs.push_back(make_raw_fd_ostream(objects.back()));
+                }
+                std::vector<LLVMOStream *> out_ptrs;
+                for (auto &out : outs) {
+                    out_ptrs.push_back(out.get());
+                }
+                compile_llvm_module_to_objects(*llvm_module, out_ptrs);
+                for (size_t i = 0; i < outs.size(); i++) {
+                    outs[i]->flush();  // create_static_library() is happier if we do this
+                    if (logger && !contains(output_files, Output::object)) {
+                        // Don't double-record object-code size if we already recorded it for object
+                        logger->record_object_code_size(file_stat(objects[i]).file_size);
+                    }
                 }
             }
             debug(1) << "Module.compile(): static_library " << output_files.at(Output::static_library) << "\n";
@@ -754,7 +787,8 @@ void compile_multitarget(const std::string &fn_name,
                          const std::vector<Target> &targets,
                          const std::vector<std::string> &suffixes,
                          const ModuleFactory &module_factory,
-                         const CompilerLoggerFactory &compiler_logger_factory) {
+                         const CompilerLoggerFactory &compiler_logger_factory,
+                         int num_jobs) {
     validate_outputs(output_files);
 
     user_assert(!fn_name.empty()) << "Function name must be specified.\n";
@@ -827,7 +861,16 @@ void compile_multitarget(const std::string &fn_name,
     TemporaryObjectFileDir temp_obj_dir, temp_compiler_log_dir;
     std::vector<Expr> wrapper_args;
     std::vector<LoweredArgument> base_target_args;
-    std::vector<AutoSchedulerResults> auto_scheduler_results;
+    std::vector<AutoSchedulerResults> auto_scheduler_results(targets.size());
+
+    struct SubTarget {
+        std::string fn_name;
+        Target target;
+        std::map<Output, std::string> outputs;
+        std::vector<LoweredArgument> args;
+        std::vector<int> unique_name_counters;
+    };
+    std::vector<SubTarget> sub_targets(targets.size());
 
     for (size_t i = 0; i < targets.size(); ++i) {
         const Target &target = targets[i];
@@ -868,29 +911,21 @@ void compile_multitarget(const std::string &fn_name,
             sub_fn_target = sub_fn_target.without_feature(Target::Matlab);
         }
 
-        {
-            ScopedCompilerLogger activate(compiler_logger_factory, sub_fn_name, sub_fn_target);
-            Module sub_module = module_factory(sub_fn_name, sub_fn_target);
-            // Re-assign every time -- should be the same across all targets anyway,
-            // but base_target is always the last one we encounter.
-            base_target_args = sub_module.get_function_by_name(sub_fn_name).args;
-
-            auto sub_out = add_suffixes(output_files, suffix);
-            if (contains(output_files, Output::static_library)) {
-                sub_out[Output::object] = temp_obj_dir.add_temp_object_file(output_files.at(Output::static_library), suffix, target);
-                sub_out.erase(Output::static_library);
-            }
-            sub_out.erase(Output::registration);
-            sub_out.erase(Output::schedule);
-            sub_out.erase(Output::c_header);
-            if (contains(sub_out, Output::compiler_log)) {
-                sub_out[Output::compiler_log] = temp_compiler_log_dir.add_temp_file(output_files.at(Output::compiler_log), suffix, target);
-            }
-            debug(1) << "compile_multitarget: compile_sub_target " << sub_out[Output::object] << "\n";
-            sub_module.compile(sub_out);
-            const auto *r = sub_module.get_auto_scheduler_results();
-            auto_scheduler_results.push_back(r ? *r : AutoSchedulerResults());
+        // Pick the output files here, rather than when the sub-target is
+        // compiled, so that their order doesn't depend on which
+        // sub-target finishes first.
+        auto sub_out = add_suffixes(output_files, suffix);
+        if (contains(output_files, Output::static_library)) {
+            sub_out[Output::object] = temp_obj_dir.add_temp_object_file(output_files.at(Output::static_library), suffix, target);
+            sub_out.erase(Output::static_library);
         }
+        sub_out.erase(Output::registration);
+        sub_out.erase(Output::schedule);
+        sub_out.erase(Output::c_header);
+        if (contains(sub_out, Output::compiler_log)) {
+            sub_out[Output::compiler_log] = temp_compiler_log_dir.add_temp_file(output_files.at(Output::compiler_log), suffix, target);
+        }
+        sub_targets[i] = {sub_fn_name, sub_fn_target, sub_out, {}, {}};
 
         uint64_t cur_target_features[kFeaturesWordCount] = {0};
         for (int i = 0; i < Target::FeatureEnd; ++i) {
@@ -920,6 +955,76 @@ void compile_multitarget(const std::string &fn_name,
         wrapper_args.emplace_back(sub_fn_name);
     }
 
+    // Every sub-target starts making unique names from the same point, so
+    // that the output doesn't depend on how the sub-target compilations
+    // interleave.
+    const std::vector<int> unique_name_counters = ScopedUniqueNameCounters::snapshot();
+    const auto compile_sub_target = [&](size_t i) {
+        SubTarget &sub = sub_targets[i];
+        ScopedUniqueNameCounters names(unique_name_counters);
+        ScopedCompilerLogger activate(compiler_logger_factory, sub.fn_name, sub.target);
+        Module sub_module = module_factory(sub.fn_name, sub.target);
+        sub.args = sub_module.get_function_by_name(sub.fn_name).args;
+        debug(1) << "compile_multitarget: compile_sub_target " << sub.outputs[Output::object] << "\n";
+        sub_module.compile(sub.outputs);
+        const auto *r = sub_module.get_auto_scheduler_results();
+        auto_scheduler_results[i] = r ? *r : AutoSchedulerResults();
+        sub.unique_name_counters = names.current();
+    };
+
+    if (num_jobs <= 0) {
+        num_jobs = (int)ThreadPool<void>::num_processors_online();
+    }
+    num_jobs = std::min(num_jobs, (int)targets.size());
+    if (num_jobs <= 1) {
+        for (size_t i = 0; i < targets.size(); ++i) {
+            compile_sub_target(i);
+        }
+    } else {
+        debug(1) << "compile_multitarget: compiling " << targets.size() << " sub-targets with " << num_jobs << " jobs\n";
+#ifdef HALIDE_WITH_EXCEPTIONS
+        // Errors must be rethrown on this thread; report the one from the
+        // earliest target, as a serial compile would.
+        std::vector<std::exception_ptr> errors(targets.size());
+#endif
+        {
+            ThreadPool<void> pool(num_jobs);
+            std::vector<std::future<void>> futures;
+            for (size_t i = 0; i < targets.size(); ++i) {
+                futures.push_back(pool.async([&, i]() {
+#ifdef HALIDE_WITH_EXCEPTIONS
+                    try {
+                        compile_sub_target(i);
+                    } catch (...) {
+                        errors[i] = std::current_exception();
+                    }
+#else
+                    compile_sub_target(i);
+#endif
+                }));
+            }
+            for (auto &f : futures) {
+                f.wait();
+            }
+        }
+#ifdef HALIDE_WITH_EXCEPTIONS
+        for (const auto &e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        }
+#endif
+    }
+
+    // The sub-targets may have run on other threads, so make sure names
+    // made on this thread from here on don't collide with theirs.
+    for (const auto &sub : sub_targets) {
+        ScopedUniqueNameCounters::advance(sub.unique_name_counters);
+    }
+
+    // Should be the same across all targets anyway, but use the base target's.
+    base_target_args = sub_targets.back().args;
+
     // If we haven't specified "no runtime", build a runtime with the base target
     // and add that to the result.
     if (!base_target.has_feature(Target::NoRuntime)) {
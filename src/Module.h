@@ -221,12 +221,18 @@ std::map<Output, std::string> compile_standalone_runtime(const std::map<Output,
 using ModuleFactory = std::function<Module(const std::string &fn_name, const Target &target)>;
 using CompilerLoggerFactory = std::function<std::unique_ptr<Internal::CompilerLogger>(const std::string &fn_name, const Target &target)>;
 
+/** Compile a pipeline for several targets, along with a wrapper that
+ * dispatches to the best one at runtime. Up to num_jobs targets are
+ * compiled concurrently (zero means one per core); if num_jobs is not
+ * one, module_factory and compiler_logger_factory must be safe to call
+ * from several threads at once. The output doesn't depend on num_jobs. */
 void compile_multitarget(const std::string &fn_name,
                          const std::map<Output, std::string> &output_files,
                          const std::vector<Target> &targets,
                          const std::vector<std::string> &suffixes,
                          const ModuleFactory &module_factory,
-                         const CompilerLoggerFactory &compiler_logger_factory = nullptr);
+                         const CompilerLoggerFactory &compiler_logger_factory = nullptr,
+                         int num_jobs = 1);
 
 }  // namespace Halide
 
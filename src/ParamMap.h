@@ -86,6 +86,13 @@ public:
         set(p, buf, nullptr);
     }
 
+    /** Map an ImageParam to a Buffer<> that infer_input_bounds will
+     * allocate with the required region, instead of binding the
+     * ImageParam. */
+    void set(const ImageParam &p, Buffer<> *buf_out_param) {
+        set(p, Buffer<>(), buf_out_param);
+    }
+
     size_t size() const {
         return mapping.size();
     }
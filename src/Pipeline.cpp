@@ -1,5 +1,8 @@
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
 #include <utility>
 
 #include "Argument.h"
@@ -7,6 +10,7 @@
 #include "FindCalls.h"
 #include "Func.h"
 #include "IRVisitor.h"
+#include "ImageParam.h"
 #include "InferArguments.h"
 #include "LLVM_Output.h"
 #include "Lower.h"
@@ -115,6 +119,22 @@ struct PipelineContents {
 
     bool trace_pipeline = false;
 
+    /** A compilation started by compile_jit_async() that hasn't been
+     * swapped in yet. It's done by a separate pipeline with the same
+     * outputs, so that this one can be used meanwhile. */
+    struct AsyncJIT {
+        Target target, fallback;
+        Pipeline compiler;
+        std::shared_future<void> done;
+    };
+    std::unique_ptr<AsyncJIT> async_jit;
+
+    /** Held while jit-compiling, or while picking the code to run in
+     * realize(), so that several threads can realize the same
+     * pipeline at once. Recursive because realize() calls
+     * compile_jit(). */
+    std::recursive_mutex jit_mutex;
+
     PipelineContents()
         : module("", Target()) {
         user_context_arg.arg = Argument("__user_context", Argument::InputScalar, type_of<const void *>(), 0, ArgumentEstimates{});
@@ -125,7 +145,17 @@ struct PipelineContents {
         clear_custom_lowering_passes();
     }
 
+    /** Drop any compilation started by compile_jit_async(). It borrows
+     * the custom lowering passes, so it must be finished first. */
+    void discard_async_jit() {
+        if (async_jit) {
+            async_jit->done.wait();
+            async_jit.reset();
+        }
+    }
+
     void clear_custom_lowering_passes() {
+        discard_async_jit();
         invalidate_cache();
         for (size_t i = 0; i < custom_lowering_passes.size(); i++) {
             if (custom_lowering_passes[i].deleter) {
@@ -553,6 +583,8 @@ Target Pipeline::get_compiled_jit_target() const {
 
 void Pipeline::compile_jit(const Target &target_arg) {
     user_assert(defined()) << "Pipeline is undefined\n";
+    std::lock_guard<std::recursive_mutex> lock(contents->jit_mutex);
+    finish_async_jit(target_arg, false);
     user_assert(!target_arg.has_unknowns()) << "Cannot compile_jit() for target '" << target_arg << "'\n";
 
     Target target(target_arg);
@@ -640,6 +672,83 @@ void Pipeline::compile_jit(const Target &target_arg) {
     contents->jit_module = jit_module;
 }
 
+std::shared_future<void> Pipeline::compile_jit_async(const Target &target, const Target &fallback) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    user_assert(!target.has_unknowns()) << "Cannot compile_jit_async() for target '" << target << "'\n";
+    for (const auto &e : contents->jit_externs) {
+        user_assert(!e.second.pipeline().defined())
+            << "compile_jit_async() does not support jit externs that are Funcs or Pipelines, such as " << e.first << "\n";
+    }
+
+    contents->discard_async_jit();
+
+    if (get_compiled_jit_target() == target) {
+        std::promise<void> compiled;
+        compiled.set_value();
+        return compiled.get_future().share();
+    }
+
+    if (!fallback.has_unknowns()) {
+        compile_jit(fallback);
+    }
+
+    Pipeline compiler(outputs());
+    compiler.contents->jit_externs = contents->jit_externs;
+    compiler.contents->requirements = contents->requirements;
+    compiler.contents->trace_pipeline = contents->trace_pipeline;
+    for (const CustomLoweringPass &p : contents->custom_lowering_passes) {
+        // The passes still belong to this pipeline.
+        compiler.contents->custom_lowering_passes.push_back({p.pass, nullptr});
+    }
+
+    std::unique_ptr<PipelineContents::AsyncJIT> async(new PipelineContents::AsyncJIT);
+    async->target = target;
+    async->fallback = fallback;
+    async->compiler = compiler;
+    async->done = std::async(std::launch::async, [compiler, target]() mutable {
+                      compiler.compile_jit(target);
+                  }).share();
+    std::shared_future<void> done = async->done;
+    contents->async_jit = std::move(async);
+    return done;
+}
+
+Target Pipeline::finish_async_jit(const Target &t, bool use_fallback) {
+    if (!contents->async_jit) {
+        return t;
+    }
+    const PipelineContents::AsyncJIT &async = *contents->async_jit;
+    const Target target = t.has_unknowns() ? async.target : t;
+    if (target != async.target) {
+        return t;
+    }
+    if (use_fallback &&
+        !async.fallback.has_unknowns() &&
+        async.done.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        debug(2) << "Still compiling for " << target << ", running " << async.fallback << " instead\n";
+        return async.fallback;
+    }
+
+    std::unique_ptr<PipelineContents::AsyncJIT> finished = std::move(contents->async_jit);
+    // Rethrows any error from the compilation.
+    finished->done.get();
+
+    debug(2) << "Swapping in code compiled in the background for " << target << "\n";
+    const PipelineContents &compiled = *finished->compiler.contents;
+    contents->invalidate_cache();
+    contents->module = compiled.module;
+    contents->jit_module = compiled.jit_module;
+    contents->jit_target = compiled.jit_target;
+    contents->wasm_module = compiled.wasm_module;
+    for (InferredArgument arg : compiled.inferred_args) {
+        if (arg.param.same_as(compiled.user_context_arg.param)) {
+            arg = contents->user_context_arg;
+        }
+        contents->inferred_args.push_back(arg);
+    }
+    return target;
+}
+
 void Pipeline::set_error_handler(void (*handler)(void *, const char *)) {
     user_assert(defined()) << "Pipeline is undefined\n";
     contents->jit_handlers.custom_error = handler;
@@ -685,6 +794,7 @@ const std::map<std::string, JITExtern> &Pipeline::get_jit_externs() {
 
 void Pipeline::add_custom_lowering_pass(IRMutator *pass, std::function<void()> deleter) {
     user_assert(defined()) << "Pipeline is undefined\n";
+    contents->discard_async_jit();
     contents->invalidate_cache();
     CustomLoweringPass p = {pass, std::move(deleter)};
     contents->custom_lowering_passes.push_back(p);
@@ -1054,7 +1164,8 @@ Pipeline::make_externs_jit_module(const Target &target,
     return result;
 }
 
-int Pipeline::call_jit_code(const Target &target, const JITCallArgs &args) {
+int Pipeline::call_jit_code(const Target &target, const JITModule &jit_module,
+                            WasmModule &wasm_module, const JITCallArgs &args) {
 #if defined(__has_feature)
 #if __has_feature(memory_sanitizer)
     user_warning << "MSAN does not support JIT compilers of any sort, and will report "
@@ -1064,10 +1175,10 @@ int Pipeline::call_jit_code(const Target &target, const JITCallArgs &args) {
 #endif
 #endif
     if (target.arch == Target::WebAssembly) {
-        internal_assert(contents->wasm_module.contents.defined());
-        return contents->wasm_module.run(args.store);
+        internal_assert(wasm_module.contents.defined());
+        return wasm_module.run(args.store);
     }
-    return contents->jit_module.argv_function()(args.store);
+    return jit_module.argv_function()(args.store);
 }
 
 void Pipeline::realize(RealizationArg outputs, const Target &t,
@@ -1077,6 +1188,10 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
 
     debug(2) << "Realizing Pipeline for " << target << "\n";
 
+    std::unique_lock<std::recursive_mutex> lock(contents->jit_mutex);
+
+    target = finish_async_jit(target, true);
+
     if (target.has_unknowns()) {
         // If we've already jit-compiled for a specific target, use that.
         target = get_compiled_jit_target();
@@ -1119,6 +1234,13 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
     prepare_jit_call_arguments(outputs, target, param_map,
                                &user_context_storage, false, args);
 
+    // Once the arguments are set up, other threads are free to run
+    // the same code concurrently, or to replace it with a fresh
+    // compilation, so hold on to the code we're about to call.
+    const JITModule jit_module = contents->jit_module;
+    WasmModule wasm_module = contents->wasm_module;
+    lock.unlock();
+
     // The handlers in the jit_context default to the default handlers
     // in the runtime of the shared module (e.g. halide_print_impl,
     // default_trace). As an example, here's what happens with a
@@ -1157,15 +1279,15 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
     // exception.
 
     debug(2) << "Calling jitted function\n";
-    int exit_status = call_jit_code(target, args);
+    int exit_status = call_jit_code(target, jit_module, wasm_module, args);
     debug(2) << "Back from jitted function. Exit status was " << exit_status << "\n";
 
     // If we're profiling, report runtimes and reset profiler stats.
-    if (target.has_feature(Target::Profile)) {
+    if (target.has_feature(Target::Profile) || target.has_feature(Target::ProfileEvents)) {
         JITModule::Symbol report_sym =
-            contents->jit_module.find_symbol_by_name("halide_profiler_report");
+            jit_module.find_symbol_by_name("halide_profiler_report");
         JITModule::Symbol reset_sym =
-            contents->jit_module.find_symbol_by_name("halide_profiler_reset");
+            jit_module.find_symbol_by_name("halide_profiler_reset");
         if (report_sym.address && reset_sym.address) {
             void *uc = &jit_context.jit_context;
             void (*report_fn_ptr)(void *) = (void (*)(void *))(report_sym.address);
@@ -1181,7 +1303,9 @@ void Pipeline::realize(RealizationArg outputs, const Target &t,
 
 void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target, const ParamMap &param_map) {
     user_assert(!target.has_feature(Target::NoBoundsQuery)) << "You may not call infer_input_bounds() with Target::NoBoundsQuery set.";
+    std::unique_lock<std::recursive_mutex> lock(contents->jit_mutex);
     compile_jit(target);
+    const Target jit_target = contents->jit_target;
 
     // This has to happen after a runtime has been compiled in compile_jit.
     JITFuncCallContext jit_context(jit_handlers());
@@ -1189,7 +1313,7 @@ void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target,
 
     size_t args_size = contents->inferred_args.size() + outputs.size();
     JITCallArgs args(args_size);
-    prepare_jit_call_arguments(outputs, contents->jit_target, param_map,
+    prepare_jit_call_arguments(outputs, jit_target, param_map,
                                &user_context_storage, true, args);
 
     struct TrackedBuffer {
@@ -1201,11 +1325,15 @@ void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target,
     };
     vector<TrackedBuffer> tracked_buffers(args_size);
 
+    // Keep the arguments being queried, as contents may change once
+    // the lock is released.
     vector<size_t> query_indices;
+    vector<InferredArgument> query_args;
     for (size_t i = 0; i < contents->inferred_args.size(); i++) {
         if (args.store[i] == nullptr) {
             query_indices.push_back(i);
             InferredArgument ia = contents->inferred_args[i];
+            query_args.push_back(ia);
             internal_assert(ia.param.defined() && ia.param.is_buffer());
             // Make some empty Buffers of the right dimensionality
             vector<int> initial_shape(ia.param.dimensions(), 0);
@@ -1221,6 +1349,12 @@ void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target,
         return;
     }
 
+    // As in realize, other threads may run or replace the code once
+    // the arguments are set up.
+    const JITModule jit_module = contents->jit_module;
+    WasmModule wasm_module = contents->wasm_module;
+    lock.unlock();
+
     int iter = 0;
     const int max_iters = 16;
     for (iter = 0; iter < max_iters; iter++) {
@@ -1231,7 +1365,7 @@ void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target,
         }
 
         Internal::debug(2) << "Calling jitted function\n";
-        int exit_status = call_jit_code(contents->jit_target, args);
+        int exit_status = call_jit_code(jit_target, jit_module, wasm_module, args);
         jit_context.report_if_error(exit_status);
         Internal::debug(2) << "Back from jitted function\n";
         bool changed = false;
@@ -1261,8 +1395,9 @@ void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target,
     debug(2) << "Bounds inference converged after " << iter << " iterations\n";
 
     // Now allocate the resulting buffers
-    for (size_t i : query_indices) {
-        InferredArgument ia = contents->inferred_args[i];
+    for (size_t k = 0; k < query_indices.size(); k++) {
+        const size_t i = query_indices[k];
+        InferredArgument ia = query_args[k];
         Buffer<> *buf_out_param = nullptr;
         Parameter &p = param_map.map(ia.param, buf_out_param);
 
@@ -1275,7 +1410,9 @@ void Pipeline::infer_input_bounds(RealizationArg outputs, const Target &target,
         tracked_buffers[i].query.allocate();
 
         if (buf_out_param != nullptr) {
-            *buf_out_param = Buffer<>(*tracked_buffers[i].query.raw_buffer());
+            // Hand over the allocation too, so the caller's buffer
+            // outlives the query buffers.
+            *buf_out_param = Buffer<>(std::move(tracked_buffers[i].query));
         } else {
             // Bind this parameter to this buffer, giving away the
             // buffer. The user retrieves it via ImageParam::get.
@@ -1315,8 +1452,125 @@ void Pipeline::infer_input_bounds(const std::vector<int32_t> &sizes,
     infer_input_bounds(r, target, param_map);
 }
 
+void Pipeline::realize_tiled(const std::vector<int32_t> &sizes,
+                             const std::vector<int32_t> &tile_sizes,
+                             const std::vector<ImageParam> &inputs,
+                             const TileReader &read,
+                             const TileWriter &write,
+                             const Target &target,
+                             const ParamMap &param_map) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+    user_assert(sizes.size() == tile_sizes.size())
+        << "realize_tiled was given " << sizes.size() << " output sizes but "
+        << tile_sizes.size() << " tile sizes\n";
+    user_assert(read && write) << "realize_tiled requires a reader and a writer\n";
+
+    // Resolve the target the way realize does, so that the bounds
+    // queries and the realizations agree on it.
+    Target t = target;
+    if (t.has_unknowns()) {
+        std::lock_guard<std::recursive_mutex> lock(contents->jit_mutex);
+        t = get_compiled_jit_target();
+        if (t.has_unknowns()) {
+            t = get_jit_target_from_environment();
+        }
+    }
+
+    vector<Type> output_types;
+    for (const Function &out : contents->outputs) {
+        user_assert(out.has_pure_definition() || out.has_extern_definition())
+            << "Can't realize Pipeline with undefined output Func: " << out.name() << ".\n";
+        for (Type t : out.output_types()) {
+            output_types.push_back(t);
+        }
+    }
+
+    // Tiles are clamped to the output size, and shifted inwards at
+    // the end of each dimension, so they all have the same shape.
+    const int dims = (int)sizes.size();
+    vector<int> extents(dims), tiles_per_dim(dims);
+    int64_t num_tiles = 1;
+    for (int d = 0; d < dims; d++) {
+        user_assert(sizes[d] > 0 && tile_sizes[d] > 0)
+            << "realize_tiled requires positive sizes and tile sizes\n";
+        extents[d] = std::min(tile_sizes[d], sizes[d]);
+        tiles_per_dim[d] = (sizes[d] + extents[d] - 1) / extents[d];
+        num_tiles *= tiles_per_dim[d];
+    }
+
+    struct Tile {
+        vector<Buffer<>> outputs;
+        vector<Buffer<>> regions;
+    };
+
+    // Allocate a tile and read in the input regions it depends on.
+    auto prepare = [&](int64_t index) {
+        Tile tile;
+        vector<int> mins(dims);
+        for (int d = 0; d < dims; d++) {
+            mins[d] = std::min((int)(index % tiles_per_dim[d]) * extents[d], sizes[d] - extents[d]);
+            index /= tiles_per_dim[d];
+        }
+        for (Type t : output_types) {
+            Buffer<> buf(t, extents);
+            buf.set_min(mins);
+            tile.outputs.push_back(std::move(buf));
+        }
+        if (!inputs.empty()) {
+            tile.regions.resize(inputs.size());
+            ParamMap query_map = param_map;
+            for (size_t i = 0; i < inputs.size(); i++) {
+                query_map.set(inputs[i], &tile.regions[i]);
+            }
+            Realization r(tile.outputs);
+            infer_input_bounds(r, t, query_map);
+            for (size_t i = 0; i < inputs.size(); i++) {
+                read(inputs[i], tile.regions[i]);
+            }
+        }
+        return tile;
+    };
+
+    auto consume = [&write](Tile tile) {
+        for (Buffer<> &buf : tile.outputs) {
+            buf.copy_to_host();
+        }
+        Realization r(tile.outputs);
+        write(r);
+    };
+
+    std::future<Tile> next = std::async(std::launch::async, prepare, (int64_t)0);
+    std::future<void> writing;
+    for (int64_t i = 0; i < num_tiles; i++) {
+        Tile tile = next.get();
+        if (i + 1 < num_tiles) {
+            next = std::async(std::launch::async, prepare, i + 1);
+        }
+
+        ParamMap compute_map = param_map;
+        for (size_t j = 0; j < inputs.size(); j++) {
+            compute_map.set(inputs[j], tile.regions[j]);
+        }
+        {
+            Realization r(tile.outputs);
+            realize(r, t, compute_map);
+        }
+        tile.regions.clear();
+
+        if (writing.valid()) {
+            writing.get();
+        }
+        writing = std::async(std::launch::async, consume, std::move(tile));
+    }
+    if (writing.valid()) {
+        writing.get();
+    }
+}
+
 void Pipeline::invalidate_cache() {
     if (defined()) {
+        // Anything compiled in the background is stale too.
+        contents->discard_async_jit();
         contents->invalidate_cache();
     }
 }
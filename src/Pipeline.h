@@ -7,6 +7,8 @@
  * pipeline.
  */
 
+#include <functional>
+#include <future>
 #include <map>
 #include <vector>
 
@@ -53,6 +55,7 @@ struct MachineParams {
 
 namespace Internal {
 class IRMutator;
+struct WasmModule;
 }  // namespace Internal
 
 /**
@@ -154,12 +157,22 @@ private:
 
     static AutoSchedulerFn find_autoscheduler(const std::string &autoscheduler_name);
 
-    int call_jit_code(const Target &target, const JITCallArgs &args);
+    // Call the given compiled code, which the caller must have copied
+    // from contents while holding jit_mutex, as another thread may
+    // replace what's in contents once it is released.
+    static int call_jit_code(const Target &target, const Internal::JITModule &jit_module,
+                             Internal::WasmModule &wasm_module, const JITCallArgs &args);
 
     // Get the value of contents->jit_target, but reality-check that the contents
     // sensibly match the value. Return Target() if not jitted.
     Target get_compiled_jit_target() const;
 
+    // If compile_jit_async() was called for the given target (or if the
+    // target has unknowns), either swap in the code it compiled, waiting
+    // for it if necessary, or, if allowed and there is one, return the
+    // fallback target to run instead while it is still compiling.
+    Target finish_async_jit(const Target &target, bool use_fallback);
+
 public:
     /** Make an undefined Pipeline object. */
     Pipeline();
@@ -344,9 +357,42 @@ public:
      * wish to avoid including the time taken to compile a pipeline,
      * then you can call this ahead of time. Default is to use the Target
      * returned from Halide::get_jit_target_from_environment()
+     *
+     * If the environment variable HL_JIT_CACHE_DIR names a directory,
+     * the machine code is also kept in a file there, keyed by a hash
+     * of the lowered pipeline, the target, and the Halide and LLVM
+     * versions. A later process that lowers the same pipeline loads
+     * that file instead of running LLVM.
+     *
+     * Once a Pipeline has been compiled, it may be realized from
+     * several threads at once, as long as they all use the target it
+     * was compiled for (and do not change its parameters).
      */
     void compile_jit(const Target &target = get_jit_target_from_environment());
 
+    /** Start jit compiling the pipeline on a background thread, and
+     * return at once. The returned future becomes ready when the
+     * machine code is, and reports any compilation error. The first
+     * realize() or compile_jit() for the target (or for a target with
+     * unknowns) after that swaps the new code in, waiting for it if it
+     * isn't ready yet.
+     *
+     * If a fallback target is given, the pipeline is compiled for it
+     * right away (which is free if it already is), and realize() runs
+     * the fallback code instead of waiting while the background
+     * compilation is in progress. This hides the compile latency of a
+     * new target from callers that can tolerate slower code meanwhile.
+     *
+     * The background compilation uses its own copy of the pipeline's
+     * state, so this pipeline can be realized meanwhile. The Funcs in
+     * the pipeline must not be rescheduled while it's running, any
+     * custom lowering passes must be safe to run concurrently, and only
+     * C functions are supported as jit externs. Only one compilation
+     * can be pending at a time; starting another drops the previous
+     * one. */
+    std::shared_future<void> compile_jit_async(const Target &target = get_jit_target_from_environment(),
+                                               const Target &fallback = Target());
+
     /** Set the error handler function that be called in the case of
      * runtime errors during halide pipelines. If you are compiling
      * statically, you can also just define your own function with
@@ -538,6 +584,47 @@ public:
                             const ParamMap &param_map = ParamMap::empty_map());
     // @}
 
+    /** Reads the region of a streamed input described by the given
+     * buffer, which has been allocated with exactly that shape. */
+    using TileReader = std::function<void(const ImageParam &input, Buffer<> &region)>;
+
+    /** Consumes one tile of the output. There is one Buffer per tuple
+     * component per output Func, each cropped to the tile. */
+    using TileWriter = std::function<void(Realization &tile)>;
+
+    /** Realize the Pipeline over an output of the given size one tile
+     * at a time, without ever having all of the output, or all of the
+     * streamed inputs, in memory at once. This is for images too
+     * large to fit in memory.
+     *
+     * For each tile, a bounds query finds the region of each of the
+     * given inputs the tile needs, read is called to fill in that
+     * region, the tile is computed, and the tile is passed to
+     * write. Reading the inputs for the next tile and writing the
+     * previous tile happen on other threads while the current tile
+     * is computed, so at most three tiles (and two sets of input
+     * regions) are live at once. Calls to read and calls to write
+     * are each made one at a time, but read and write may be called
+     * concurrently with each other.
+     *
+     * All tiles have the same size: tiles that would extend past the
+     * end of the output are shifted inwards instead, so they overlap
+     * their neighbours and those pixels are written more than
+     * once. Inputs not in the list are used as they are bound, as
+     * with realize. If the Pipeline has several outputs, they must
+     * all have the same size.
+     *
+     * The streamed inputs are bound to just the region each tile
+     * needs, so boundary conditions on them should be given the
+     * bounds of the whole input explicitly. */
+    void realize_tiled(const std::vector<int32_t> &sizes,
+                       const std::vector<int32_t> &tile_sizes,
+                       const std::vector<ImageParam> &inputs,
+                       const TileReader &read,
+                       const TileWriter &write,
+                       const Target &target = Target(),
+                       const ParamMap &param_map = ParamMap::empty_map());
+
     /** Infer the arguments to the Pipeline, sorted into a canonical order:
      * all buffers (sorted alphabetically by name), followed by all non-buffers
      * (sorted alphabetically by name).
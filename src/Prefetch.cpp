@@ -11,6 +11,7 @@
 #include "Prefetch.h"
 #include "Scope.h"
 #include "Simplify.h"
+#include "Substitute.h"
 #include "Target.h"
 #include "Util.h"
 
@@ -342,6 +343,251 @@ public:
     }
 };
 
+// Find the loads in the body of a serial loop whose address moves by
+// at least a cache line per iteration of the loop, and estimate how
+// many operations an iteration of the loop does. Vectorized and
+// unrolled loops inside it will become straight-line code, so their
+// loads count as loads of the body, one per iteration of them.
+class FindStridedLoads : public IRVisitor {
+public:
+    struct StridedLoad {
+        const Load *op;
+        // The index, and how much it changes per iteration of the loop.
+        Expr index, stride;
+    };
+    vector<StridedLoad> loads;
+    int cost = 0;
+    bool has_inner_loop = false;
+
+    FindStridedLoads(const string &var, int line_bytes)
+        : loop_var(var), line_bytes(line_bytes) {
+    }
+
+private:
+    using IRVisitor::visit;
+
+    const string &loop_var;
+    const int line_bytes;
+    map<string, Expr> lets;
+    Scope<> inner_lets;
+    // The values of the variables of the enclosing vectorized and
+    // unrolled loops for each iteration of them we look at.
+    vector<map<string, Expr>> iterations = {{}};
+
+    template<typename T>
+    void visit_op(const T *op) {
+        cost++;
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Add *op) override {
+        visit_op(op);
+    }
+    void visit(const Sub *op) override {
+        visit_op(op);
+    }
+    void visit(const Mul *op) override {
+        visit_op(op);
+    }
+    void visit(const Div *op) override {
+        visit_op(op);
+    }
+    void visit(const Mod *op) override {
+        visit_op(op);
+    }
+    void visit(const Min *op) override {
+        visit_op(op);
+    }
+    void visit(const Max *op) override {
+        visit_op(op);
+    }
+    void visit(const Select *op) override {
+        visit_op(op);
+    }
+    void visit(const Cast *op) override {
+        visit_op(op);
+    }
+    void visit(const Call *op) override {
+        visit_op(op);
+    }
+    void visit(const Store *op) override {
+        visit_op(op);
+    }
+
+    void visit(const For *op) override {
+        const int64_t *extent = as_const_int(op->extent);
+        Expr min = substitute(lets, op->min);
+        if ((op->for_type != ForType::Vectorized &&
+             op->for_type != ForType::Unrolled) ||
+            !extent || *extent <= 0 ||
+            expr_uses_vars(min, inner_lets)) {
+            // We only prefetch in innermost loops.
+            has_inner_loop = true;
+            return;
+        }
+
+        // Look at every iteration, unless there are so many that the
+        // first and last will have to do.
+        const int max_iterations = 16;
+        vector<map<string, Expr>> old_iterations = iterations;
+        vector<int64_t> values;
+        if (*extent * (int64_t)iterations.size() <= max_iterations) {
+            for (int64_t i = 0; i < *extent; i++) {
+                values.push_back(i);
+            }
+        } else {
+            values = {0, *extent - 1};
+        }
+        iterations.clear();
+        for (const auto &it : old_iterations) {
+            for (int64_t i : values) {
+                iterations.push_back(it);
+                iterations.back()[op->name] = simplify(substitute(it, min) + (int)i);
+            }
+        }
+
+        int old_cost = cost;
+        op->body.accept(this);
+        if (op->for_type == ForType::Unrolled) {
+            cost = old_cost + (cost - old_cost) * (int)*extent;
+        }
+        iterations = old_iterations;
+    }
+
+    void visit(const Let *op) override {
+        inner_lets.push(op->name);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const LetStmt *op) override {
+        op->value.accept(this);
+        Expr old_value;
+        auto it = lets.find(op->name);
+        if (it != lets.end()) {
+            old_value = it->second;
+        }
+        lets[op->name] = substitute(lets, op->value);
+        op->body.accept(this);
+        if (old_value.defined()) {
+            lets[op->name] = old_value;
+        } else {
+            lets.erase(op->name);
+        }
+    }
+
+    // Does an index depend on values loaded from memory, which we
+    // can't safely compute for a future iteration?
+    class LoadsMemory : public IRVisitor {
+        using IRVisitor::visit;
+        void visit(const Load *op) override {
+            result = true;
+        }
+        void visit(const Call *op) override {
+            result |= !op->is_pure();
+            IRVisitor::visit(op);
+        }
+
+    public:
+        bool result = false;
+    };
+
+    void visit(const Load *op) override {
+        visit_op(op);
+
+        Expr index = substitute(lets, op->index);
+        for (const auto &it : iterations) {
+            add_load(op, substitute(it, index));
+        }
+    }
+
+    void add_load(const Load *op, const Expr &index) {
+        LoadsMemory loads_memory;
+        index.accept(&loads_memory);
+        if (op->type.is_vector() ||
+            loads_memory.result ||
+            expr_uses_vars(index, inner_lets)) {
+            return;
+        }
+
+        Expr var = Variable::make(Int(32), loop_var);
+        Expr stride = simplify(substitute(loop_var, var + 1, index) - index);
+        if (expr_uses_var(stride, loop_var)) {
+            return;
+        }
+
+        // Hardware prefetchers handle loads that stay within the
+        // same cache line or move to the next one.
+        Expr stride_bytes = stride * op->type.bytes();
+        if (can_prove(stride_bytes < line_bytes && stride_bytes > -line_bytes)) {
+            return;
+        }
+        loads.push_back({op, index, stride});
+    }
+};
+
+class InjectAutoPrefetch : public IRMutator {
+    using IRMutator::visit;
+
+    const int line_bytes, miss_latency;
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            return op;
+        }
+
+        Stmt body = mutate(op->body);
+        if (op->for_type == ForType::Serial) {
+            FindStridedLoads finder(op->name, line_bytes);
+            body.accept(&finder);
+
+            // Prefetch far enough ahead that the data arrives before
+            // the iteration that needs it starts.
+            int distance = std::min(std::max(1, miss_latency / std::max(1, finder.cost)), 64);
+            const int64_t *extent = as_const_int(op->extent);
+            if (!finder.has_inner_loop &&
+                !finder.loads.empty() &&
+                !(extent && *extent <= distance)) {
+                vector<Stmt> prefetches;
+                vector<FindStridedLoads::StridedLoad> fetched;
+                for (const auto &l : finder.loads) {
+                    // Don't fetch the same cache line twice.
+                    bool redundant = false;
+                    for (const auto &f : fetched) {
+                        if (f.op->name == l.op->name) {
+                            Expr delta = (l.index - f.index) * l.op->type.bytes();
+                            redundant = redundant || can_prove(delta < line_bytes && delta > -line_bytes);
+                        }
+                    }
+                    if (redundant) {
+                        continue;
+                    }
+                    fetched.push_back(l);
+
+                    debug(3) << "Prefetching " << l.op->name << " " << distance
+                             << " iterations ahead of loop " << op->name << "\n";
+                    Expr ahead = simplify(l.index + l.stride * distance);
+                    Expr base = Variable::make(Handle(), l.op->name);
+                    prefetches.push_back(Evaluate::make(Call::make(l.op->type, Call::prefetch,
+                                                                   {base, ahead, 1, 1}, Call::Intrinsic)));
+                }
+                prefetches.push_back(body);
+                body = Block::make(prefetches);
+            }
+        }
+
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+
+public:
+    InjectAutoPrefetch(int line_bytes, int miss_latency)
+        : line_bytes(line_bytes), miss_latency(miss_latency) {
+    }
+};
+
 }  // anonymous namespace
 
 Stmt inject_placeholder_prefetch(const Stmt &s, const map<string, Function> &env,
@@ -357,6 +603,15 @@ Stmt inject_prefetch(const Stmt &s, const map<string, Function> &env) {
     return InjectPrefetch(env, finder.buffers).mutate(s);
 }
 
+Stmt inject_auto_prefetch(const Stmt &s, const Target &t) {
+    // A cache line size that's safe for the target (see
+    // reduce_prefetch_dimension), and the number of operations a loop
+    // body can do in the time it takes to fetch a line from memory.
+    int line_bytes = (t.arch == Target::ARM) ? 32 : 64;
+    int miss_latency = 200;
+    return InjectAutoPrefetch(line_bytes, miss_latency).mutate(s);
+}
+
 Stmt reduce_prefetch_dimension(Stmt stmt, const Target &t) {
     size_t max_dim = 0;
     Expr max_byte_size;
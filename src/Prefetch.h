@@ -31,6 +31,13 @@ Stmt inject_placeholder_prefetch(const Stmt &s, const std::map<std::string, Func
   * applicable. */
 Stmt inject_prefetch(const Stmt &s, const std::map<std::string, Function> &env);
 
+/** Inject prefetches ahead of the loads in innermost serial loops whose
+ * address moves by a cache line or more per iteration, such as the
+ * loads of a transpose or a strided gather. The prefetch distance is
+ * chosen from the number of operations in the loop body. Used when
+ * the target has the AutoPrefetch feature. */
+Stmt inject_auto_prefetch(const Stmt &s, const Target &t);
+
 /** Reduce a multi-dimensional prefetch into a prefetch of lower dimension
  * (max dimension of the prefetch is specified by target architecture).
  * This keeps the 'max_dim' innermost dimensions and adds loops for the rest
@@ -27,8 +27,12 @@ public:
 
     string pipeline_name;
 
-    InjectProfiling(const string &pipeline_name)
-        : pipeline_name(pipeline_name) {
+    // Whether to record events on each thread's timeline, rather than
+    // just updating the state the sampling profiler reads.
+    bool record_events;
+
+    InjectProfiling(const string &pipeline_name, bool record_events)
+        : pipeline_name(pipeline_name), record_events(record_events) {
         indices["overhead"] = 0;
         stack.push_back(0);
     }
@@ -114,6 +118,14 @@ private:
 
         bool on_stack;
         Expr size = compute_allocation_size(new_extents, condition, op->type, op->name, on_stack);
+        if (const Variable *v = op->new_expr.as<Variable>()) {
+            if (func_alloc_sizes.contains(v->name)) {
+                // This allocation reuses the storage of another one
+                // (see reuse_heap_allocations), so it doesn't allocate
+                // any memory of its own.
+                size = make_zero(UInt(64));
+            }
+        }
         internal_assert(size.type() == UInt(64));
         func_alloc_sizes.push(op->name, {on_stack, size});
 
@@ -204,8 +216,10 @@ private:
         Expr profiler_token = Variable::make(Int(32), "profiler_token");
         Expr profiler_state = Variable::make(Handle(), "profiler_state");
 
-        // This call gets inlined and becomes a single store instruction.
-        Expr set_task = Call::make(Int(32), "halide_profiler_set_current_func",
+        // This call gets inlined and becomes a single store instruction,
+        // unless we're recording events.
+        Expr set_task = Call::make(Int(32),
+                                   record_events ? "halide_profiler_event_set_current_func" : "halide_profiler_set_current_func",
                                    {profiler_state, profiler_token, idx}, Call::Extern);
 
         body = Block::make(Evaluate::make(set_task), body);
@@ -213,18 +227,29 @@ private:
         return ProducerConsumer::make(op->name, op->is_producer, body);
     }
 
+public:
     Stmt incr_active_threads() {
         Expr state = Variable::make(Handle(), "profiler_state");
+        if (record_events) {
+            // The thread starts out working on whichever Func we're
+            // inside of.
+            Expr token = Variable::make(Int(32), "profiler_token");
+            return Evaluate::make(Call::make(Int(32), "halide_profiler_event_incr_active_threads",
+                                             {state, token, stack.back()}, Call::Extern));
+        }
         return Evaluate::make(Call::make(Int(32), "halide_profiler_incr_active_threads",
                                          {state}, Call::Extern));
     }
 
     Stmt decr_active_threads() {
         Expr state = Variable::make(Handle(), "profiler_state");
-        return Evaluate::make(Call::make(Int(32), "halide_profiler_decr_active_threads",
+        return Evaluate::make(Call::make(Int(32),
+                                         record_events ? "halide_profiler_event_decr_active_threads" : "halide_profiler_decr_active_threads",
                                          {state}, Call::Extern));
     }
 
+private:
+
     Stmt visit_parallel_task(const Stmt &s) {
         if (const Fork *f = s.as<Fork>()) {
             return Fork::make(visit_parallel_task(f->first), visit_parallel_task(f->rest));
@@ -255,6 +280,12 @@ private:
         bool update_active_threads = (op->device_api == DeviceAPI::Hexagon ||
                                       op->is_unordered_parallel());
 
+        // Events aren't recorded remotely.
+        bool old_record_events = record_events;
+        if (op->device_api == DeviceAPI::Hexagon) {
+            record_events = false;
+        }
+
         if (update_active_threads) {
             body = Block::make({incr_active_threads(), body, decr_active_threads()});
         }
@@ -283,6 +314,8 @@ private:
             body = op->body;
         }
 
+        record_events = old_record_events;
+
         Stmt stmt = For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
 
         if (update_active_threads) {
@@ -292,8 +325,8 @@ private:
     }
 };
 
-Stmt inject_profiling(Stmt s, const string &pipeline_name) {
-    InjectProfiling profiling(pipeline_name);
+Stmt inject_profiling(Stmt s, const string &pipeline_name, bool record_events) {
+    InjectProfiling profiling(pipeline_name, record_events);
     s = profiling.mutate(s);
 
     int num_funcs = (int)(profiling.indices.size());
@@ -322,14 +355,7 @@ Stmt inject_profiling(Stmt s, const string &pipeline_name) {
         s = Block::make(update_stack, s);
     }
 
-    Expr profiler_state = Variable::make(Handle(), "profiler_state");
-    Stmt incr_active_threads =
-        Evaluate::make(Call::make(Int(32), "halide_profiler_incr_active_threads",
-                                  {profiler_state}, Call::Extern));
-    Stmt decr_active_threads =
-        Evaluate::make(Call::make(Int(32), "halide_profiler_decr_active_threads",
-                                  {profiler_state}, Call::Extern));
-    s = Block::make({incr_active_threads, s, decr_active_threads});
+    s = Block::make({profiling.incr_active_threads(), s, profiling.decr_active_threads()});
 
     s = LetStmt::make("profiler_pipeline_state", get_pipeline_state, s);
     s = LetStmt::make("profiler_state", get_state, s);
@@ -22,6 +22,10 @@
  *   f0:          0.025673ms (42%)
  *   mandelbrot:  0.006444ms (10%)   peak: 505344   num: 104000   avg: 5376
  *   argmin:      0.027715ms (46%)   stack: 20
+ *
+ * With 'host-profile_events' the pipeline also records when each thread
+ * starts and stops working on each Func, and heap usage over time, and
+ * writes them out as a Chrome trace (see halide_profiler_write_trace_events).
  */
 #include <string>
 
@@ -33,11 +37,12 @@ namespace Internal {
 /** Take a statement representing a halide pipeline insert
  * high-resolution timing into the generated code (via spawning a
  * thread that acts as a sampling profiler); summaries of execution
- * times and counts will be logged at the end. Should be done before
- * storage flattening, but after all bounds inference.
+ * times and counts will be logged at the end. If record_events is
+ * true, also record a timeline of events on each thread. Should be
+ * done before storage flattening, but after all bounds inference.
  *
  */
-Stmt inject_profiling(Stmt, const std::string &);
+Stmt inject_profiling(Stmt, const std::string &, bool record_events = false);
 
 }  // namespace Internal
 }  // namespace Halide
@@ -0,0 +1,377 @@
+#include <map>
+#include <set>
+
+#include "CodeGen_Internal.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "ReuseHeapAllocations.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Is this an allocation that codegen will satisfy with a call to malloc?
+bool is_heap_allocation(const Allocate *op) {
+    if (op->new_expr.defined() ||
+        !op->free_function.empty() ||
+        op->extents.empty() ||
+        !is_one(op->condition)) {
+        return false;
+    }
+    if (op->memory_type == MemoryType::Heap) {
+        return true;
+    } else if (op->memory_type != MemoryType::Auto) {
+        return false;
+    }
+    int32_t constant_size = Allocate::constant_allocation_size(op->extents, op->name);
+    return constant_size == 0 || !can_allocation_fit_on_stack((int64_t)constant_size * op->type.bytes());
+}
+
+class ContainsHeapAllocation : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Allocate *op) override {
+        result = result || is_heap_allocation(op);
+        IRVisitor::visit(op);
+    }
+
+public:
+    bool result = false;
+};
+
+bool contains_heap_allocation(const Stmt &s) {
+    ContainsHeapAllocation c;
+    s.accept(&c);
+    return c.result;
+}
+
+// Find the lifetimes of the heap allocations in a region of
+// straight-line code, as the positions of their Allocate and Free
+// nodes. Loops, branches, and forks are separate regions, so we don't
+// look inside them, but we note where they may allocate.
+class FindLifetimes : public IRVisitor {
+public:
+    struct Lifetime {
+        const Allocate *op;
+        int start, end;
+        // The extents, in terms of the variables in scope outside the
+        // region.
+        vector<Expr> extents;
+        // The heap allocations in this region that enclose this one,
+        // outermost first.
+        vector<size_t> enclosing;
+    };
+    vector<Lifetime> lifetimes;
+    // The positions of the nested regions that contain heap
+    // allocations of their own.
+    vector<int> nested_allocations;
+
+private:
+    using IRVisitor::visit;
+
+    int position = 0;
+    map<string, size_t> index_of;
+    vector<size_t> enclosing;
+    map<string, Expr> lets;
+
+    void visit_nested_region(const Stmt &s) {
+        if (contains_heap_allocation(s)) {
+            nested_allocations.push_back(position++);
+        }
+    }
+
+    void visit(const For *op) override {
+        visit_nested_region(op);
+    }
+
+    void visit(const IfThenElse *op) override {
+        visit_nested_region(op);
+    }
+
+    void visit(const Fork *op) override {
+        visit_nested_region(op);
+    }
+
+    void visit(const Acquire *op) override {
+        visit_nested_region(op);
+    }
+
+    void visit(const Atomic *op) override {
+        visit_nested_region(op);
+    }
+
+    void visit(const LetStmt *op) override {
+        Expr old_value;
+        auto it = lets.find(op->name);
+        if (it != lets.end()) {
+            old_value = it->second;
+        }
+        lets[op->name] = substitute(lets, op->value);
+        op->body.accept(this);
+        if (old_value.defined()) {
+            lets[op->name] = old_value;
+        } else {
+            lets.erase(op->name);
+        }
+    }
+
+    void visit(const Allocate *op) override {
+        if (!is_heap_allocation(op)) {
+            IRVisitor::visit(op);
+            return;
+        }
+
+        vector<Expr> extents;
+        for (const Expr &e : op->extents) {
+            extents.push_back(substitute(lets, e));
+        }
+
+        size_t idx = lifetimes.size();
+        lifetimes.push_back({op, position++, -1, extents, enclosing});
+        index_of[op->name] = idx;
+
+        enclosing.push_back(idx);
+        op->body.accept(this);
+        enclosing.pop_back();
+
+        // If there was no early free, it lives until the end of its
+        // Allocate node.
+        if (lifetimes[idx].end < 0) {
+            lifetimes[idx].end = position++;
+        }
+    }
+
+    void visit(const Free *op) override {
+        auto it = index_of.find(op->name);
+        if (it != index_of.end()) {
+            lifetimes[it->second].end = position++;
+        }
+    }
+};
+
+// Point allocations at the storage of the allocations they share, and
+// move the Free of each shared allocation to after the Free of the
+// last allocation using it.
+class ShareStorage : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const Allocate *op) override {
+        auto it = storage_of.find(op->name);
+        if (it == storage_of.end()) {
+            return IRMutator::visit(op);
+        }
+        Stmt body = mutate(op->body);
+        return Allocate::make(op->name, op->type, op->memory_type, op->extents,
+                              op->condition, body, Variable::make(Handle(), it->second),
+                              "halide_device_host_nop_free");
+    }
+
+    Stmt visit(const Free *op) override {
+        if (shared.count(op->name)) {
+            return Evaluate::make(0);
+        }
+        auto it = free_after.find(op->name);
+        if (it != free_after.end()) {
+            return Block::make(op, Free::make(it->second));
+        }
+        return op;
+    }
+
+public:
+    map<string, string> storage_of, free_after;
+    set<string> shared;
+};
+
+// Check that an allocation with extents a has room for one with
+// extents b.
+bool at_least_as_large(const vector<Expr> &a, const vector<Expr> &b) {
+    if (a.size() == b.size()) {
+        // Extents are non-negative, so it's enough to compare them one
+        // dimension at a time, which is much easier to prove.
+        bool larger = true;
+        for (size_t i = 0; larger && i < a.size(); i++) {
+            larger = can_prove(a[i] >= b[i]);
+        }
+        if (larger) {
+            return true;
+        }
+    }
+    Expr size_a = cast<int64_t>(a[0]), size_b = cast<int64_t>(b[0]);
+    for (size_t i = 1; i < a.size(); i++) {
+        size_a *= cast<int64_t>(a[i]);
+    }
+    for (size_t i = 1; i < b.size(); i++) {
+        size_b *= cast<int64_t>(b[i]);
+    }
+    return can_prove(size_a >= size_b);
+}
+
+Stmt share_storage_in_region(const Stmt &s) {
+    FindLifetimes finder;
+    s.accept(&finder);
+    const auto &lifetimes = finder.lifetimes;
+
+    // Like register allocation for straight-line code: walk the
+    // allocations in order, and put each one in the storage of an
+    // enclosing allocation that is no longer in use.
+    vector<int> busy_until(lifetimes.size()), storage(lifetimes.size(), -1);
+    for (size_t i = 0; i < lifetimes.size(); i++) {
+        busy_until[i] = lifetimes[i].end;
+    }
+
+    // Reusing storage keeps it alive from the end of its previous user
+    // to the end of the next one. If nothing new is allocated in
+    // between, everything in use then was also in use just before the
+    // previous user was freed, so the peak can't go up. Check whether a
+    // new allocation starts strictly between two positions, counting
+    // the allocations that haven't been given storage yet as new.
+    auto allocates_between = [&](int begin, int end) {
+        for (size_t k = 0; k < lifetimes.size(); k++) {
+            if (storage[k] < 0 && lifetimes[k].start > begin && lifetimes[k].start < end) {
+                return true;
+            }
+        }
+        for (int p : finder.nested_allocations) {
+            if (p > begin && p < end) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (size_t i = 0; i < lifetimes.size(); i++) {
+        const auto &l = lifetimes[i];
+        for (size_t j : l.enclosing) {
+            const auto &candidate = lifetimes[j];
+            // Only reuse storage of the same type, and that is
+            // large enough. The allocations within this one haven't
+            // been looked at yet, so they are checked below.
+            if (storage[j] >= 0 ||
+                busy_until[j] >= l.start ||
+                candidate.op->type != l.op->type ||
+                allocates_between(busy_until[j], l.start) ||
+                !at_least_as_large(candidate.extents, l.extents)) {
+                continue;
+            }
+            storage[i] = (int)j;
+            busy_until[j] = l.end;
+            break;
+        }
+    }
+
+    // Now that every allocation has been placed, check the whole span
+    // each one keeps its storage alive for, including the allocations
+    // made while it is in use. Giving up on one reuse turns it into a
+    // new allocation, which may rule out others, so repeat until
+    // nothing changes.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t j = 0; j < lifetimes.size(); j++) {
+            busy_until[j] = lifetimes[j].end;
+        }
+        for (size_t i = 0; i < lifetimes.size(); i++) {
+            int j = storage[i];
+            if (j < 0) {
+                continue;
+            }
+            if (allocates_between(busy_until[j], lifetimes[i].end)) {
+                storage[i] = -1;
+                changed = true;
+            } else {
+                busy_until[j] = lifetimes[i].end;
+            }
+        }
+    }
+
+    ShareStorage sharer;
+    vector<int> last_user(lifetimes.size(), -1);
+    for (size_t i = 0; i < lifetimes.size(); i++) {
+        int j = storage[i];
+        if (j >= 0) {
+            debug(3) << "Allocation " << lifetimes[i].op->name << " reuses the storage of " << lifetimes[j].op->name << "\n";
+            sharer.storage_of[lifetimes[i].op->name] = lifetimes[j].op->name;
+            last_user[j] = (int)i;
+        }
+    }
+
+    if (sharer.storage_of.empty()) {
+        return s;
+    }
+
+    for (size_t j = 0; j < lifetimes.size(); j++) {
+        if (last_user[j] >= 0) {
+            sharer.shared.insert(lifetimes[j].op->name);
+            sharer.free_after[lifetimes[last_user[j]].op->name] = lifetimes[j].op->name;
+        }
+    }
+    debug(2) << "Reusing storage for " << sharer.storage_of.size() << " of "
+             << lifetimes.size() << " heap allocations\n";
+
+    return sharer.mutate(s);
+}
+
+class ReuseHeapAllocations : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            // Leave allocations on other devices alone.
+            return op;
+        }
+        Stmt body = share_storage_in_region(mutate(op->body));
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, body);
+    }
+
+    Stmt visit(const IfThenElse *op) override {
+        Stmt then_case = share_storage_in_region(mutate(op->then_case));
+        Stmt else_case = op->else_case;
+        if (else_case.defined()) {
+            else_case = share_storage_in_region(mutate(else_case));
+        }
+        if (then_case.same_as(op->then_case) &&
+            else_case.same_as(op->else_case)) {
+            return op;
+        }
+        return IfThenElse::make(op->condition, then_case, else_case);
+    }
+
+    Stmt visit(const Fork *op) override {
+        Stmt first = share_storage_in_region(mutate(op->first));
+        Stmt rest = share_storage_in_region(mutate(op->rest));
+        if (first.same_as(op->first) &&
+            rest.same_as(op->rest)) {
+            return op;
+        }
+        return Fork::make(first, rest);
+    }
+
+    Stmt visit(const Acquire *op) override {
+        Stmt body = share_storage_in_region(mutate(op->body));
+        if (body.same_as(op->body)) {
+            return op;
+        }
+        return Acquire::make(op->semaphore, op->count, body);
+    }
+};
+
+}  // namespace
+
+Stmt reuse_heap_allocations(const Stmt &s) {
+    return share_storage_in_region(ReuseHeapAllocations().mutate(s));
+}
+
+}  // namespace Internal
+}  // namespace Halide
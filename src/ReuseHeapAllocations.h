@@ -0,0 +1,29 @@
+#ifndef HALIDE_REUSE_HEAP_ALLOCATIONS_H
+#define HALIDE_REUSE_HEAP_ALLOCATIONS_H
+
+/** \file
+ * Defines the lowering pass that lets heap allocations with disjoint
+ * lifetimes share storage.
+ */
+
+#include "Expr.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Find heap allocations at the same loop level whose lifetimes (as
+ * delimited by the Free nodes injected by inject_early_frees) don't
+ * overlap, and make the later ones use the storage of an earlier one
+ * of the same type that is provably at least as large, instead of
+ * calling malloc again. Allocations that reuse storage get a new_expr
+ * that refers to the allocation they share, and the Free of the
+ * shared allocation moves to after the last one of them. Storage is
+ * only reused when nothing else is allocated between the end of its
+ * previous use and the end of the new one, so keeping it alive for
+ * longer can't raise the peak amount of memory in use. */
+Stmt reuse_heap_allocations(const Stmt &s);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -1688,6 +1688,7 @@ class ComputeLegalSchedules : public IRVisitor {
 public:
     struct Site {
         bool is_parallel;
+        ForType for_type;
         LoopLevel loop_level;
     };
     vector<Site> sites_allowed;
@@ -1725,7 +1726,7 @@ private:
         // Since we are now in the lowering phase, we expect all LoopLevels to be locked;
         // thus any new ones we synthesize we must explicitly lock.
         loop_level.lock();
-        Site s = {f->is_parallel(), loop_level};
+        Site s = {f->is_parallel(), f->for_type, loop_level};
         sites.push_back(s);
         f->body.accept(this);
         sites.pop_back();
@@ -2104,18 +2105,39 @@ bool validate_schedule(Function f, const Stmt &s, const Target &target, bool is_
         }
     }
 
-    // Check there isn't a parallel loop between the compute_at and the store_at
+    // If there's a parallel loop between the store_at and the
+    // compute_at, sharing the storage across its iterations would be a
+    // race condition. All uses of the Func are inside the compute_at,
+    // so if the parallel loops are all ordinary parallel loops on the
+    // CPU, instead give each iteration of the innermost one its own
+    // copy of the storage. Sliding window and storage folding then
+    // apply within each parallel strip, with the first iteration of
+    // each strip computing the warm-up region. Storage can't be moved
+    // into GPU or vectorized loops, so those remain an error.
     std::ostringstream err;
 
     if (store_at_ok && compute_at_ok) {
+        size_t innermost_parallel = 0;
         for (size_t i = store_idx + 1; i <= compute_idx; i++) {
-            if (sites[i].is_parallel) {
+            if (!sites[i].is_parallel) {
+                continue;
+            }
+            if (sites[i].for_type != ForType::Parallel) {
                 err << "Func \"" << f.name()
                     << "\" is stored outside the parallel loop over "
                     << sites[i].loop_level.to_string()
                     << " but computed within it. This is a potential race condition.\n";
                 store_at_ok = compute_at_ok = false;
+                break;
             }
+            innermost_parallel = i;
+        }
+        if (store_at_ok && innermost_parallel > 0) {
+            debug(1) << "Func \"" << f.name()
+                     << "\" is stored outside the parallel loop over "
+                     << sites[innermost_parallel].loop_level.to_string()
+                     << " but computed within it. Moving its storage into that loop.\n";
+            f.schedule().store_level() = sites[innermost_parallel].loop_level;
         }
     }
 
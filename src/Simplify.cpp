@@ -19,8 +19,20 @@ using std::vector;
 int Simplify::debug_indent = 0;
 #endif
 
+namespace {
+
+// The cache of simplified Exprs is off by default. Set
+// HL_SIMPLIFIER_CACHE=1 to turn it on.
+bool expr_cache_enabled() {
+    static bool enabled = get_env_variable("HL_SIMPLIFIER_CACHE") == "1";
+    return enabled;
+}
+
+}  // namespace
+
 Simplify::Simplify(bool r, const Scope<Interval> *bi, const Scope<ModulusRemainder> *ai)
-    : remove_dead_lets(r), no_float_simplify(false) {
+    : remove_dead_lets(r), no_float_simplify(false),
+      use_expr_cache(expr_cache_enabled()), compare_cache(8) {
 
     // Only respect the constant bounds from the containing scope.
     for (auto iter = bi->cbegin(); iter != bi->cend(); ++iter) {
@@ -58,17 +70,17 @@ void Simplify::found_buffer_reference(const string &name, size_t dimensions) {
     for (size_t i = 0; i < dimensions; i++) {
         string stride = name + ".stride." + std::to_string(i);
         if (var_info.contains(stride)) {
-            var_info.ref(stride).old_uses++;
+            count_use(stride, var_info.ref(stride), false);
         }
 
         string min = name + ".min." + std::to_string(i);
         if (var_info.contains(min)) {
-            var_info.ref(min).old_uses++;
+            count_use(min, var_info.ref(min), false);
         }
     }
 
     if (var_info.contains(name)) {
-        var_info.ref(name).old_uses++;
+        count_use(name, var_info.ref(name), false);
     }
 }
 
@@ -110,12 +122,14 @@ void Simplify::ScopedFact::learn_false(const Expr &fact) {
     info.old_uses = info.new_uses = 0;
     if (const Variable *v = fact.as<Variable>()) {
         info.replacement = const_false(fact.type().lanes());
+        info.id = simplify->new_context();
         simplify->var_info.push(v->name, info);
         pop_list.push_back(v);
     } else if (const NE *ne = fact.as<NE>()) {
         const Variable *v = ne->a.as<Variable>();
         if (v && is_const(ne->b)) {
             info.replacement = ne->b;
+            info.id = simplify->new_context();
             simplify->var_info.push(v->name, info);
             pop_list.push_back(v);
         }
@@ -163,6 +177,7 @@ void Simplify::ScopedFact::learn_false(const Expr &fact) {
         learn_true(n->a);
     } else if (simplify->falsehoods.insert(fact).second) {
         falsehoods.push_back(fact);
+        simplify->new_context();
     }
 }
 
@@ -173,6 +188,7 @@ void Simplify::ScopedFact::learn_upper_bound(const Variable *v, int64_t val) {
     if (simplify->bounds_and_alignment_info.contains(v->name)) {
         b.intersect(simplify->bounds_and_alignment_info.get(v->name));
     }
+    simplify->new_context();
     simplify->bounds_and_alignment_info.push(v->name, b);
     bounds_pop_list.push_back(v);
 }
@@ -184,6 +200,7 @@ void Simplify::ScopedFact::learn_lower_bound(const Variable *v, int64_t val) {
     if (simplify->bounds_and_alignment_info.contains(v->name)) {
         b.intersect(simplify->bounds_and_alignment_info.get(v->name));
     }
+    simplify->new_context();
     simplify->bounds_and_alignment_info.push(v->name, b);
     bounds_pop_list.push_back(v);
 }
@@ -193,6 +210,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
     info.old_uses = info.new_uses = 0;
     if (const Variable *v = fact.as<Variable>()) {
         info.replacement = const_true(fact.type().lanes());
+        info.id = simplify->new_context();
         simplify->var_info.push(v->name, info);
         pop_list.push_back(v);
     } else if (const EQ *eq = fact.as<EQ>()) {
@@ -204,6 +222,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
             if (is_const(eq->b) || eq->b.as<Variable>()) {
                 // TODO: consider other cases where we might want to entirely substitute
                 info.replacement = eq->b;
+                info.id = simplify->new_context();
                 simplify->var_info.push(v->name, info);
                 pop_list.push_back(v);
             } else if (v->type.is_int()) {
@@ -216,6 +235,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
                     auto existing_knowledge = simplify->bounds_and_alignment_info.get(v->name);
                     expr_info.intersect(existing_knowledge);
                 }
+                simplify->new_context();
                 simplify->bounds_and_alignment_info.push(v->name, expr_info);
                 bounds_pop_list.push_back(v);
             }
@@ -233,6 +253,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
                 auto existing_knowledge = simplify->bounds_and_alignment_info.get(vb->name);
                 expr_info.intersect(existing_knowledge);
             }
+            simplify->new_context();
             simplify->bounds_and_alignment_info.push(vb->name, expr_info);
             bounds_pop_list.push_back(vb);
         } else if (modulus && remainder && (v = m->a.as<Variable>())) {
@@ -245,6 +266,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
                 auto existing_knowledge = simplify->bounds_and_alignment_info.get(v->name);
                 expr_info.intersect(existing_knowledge);
             }
+            simplify->new_context();
             simplify->bounds_and_alignment_info.push(v->name, expr_info);
             bounds_pop_list.push_back(v);
         }
@@ -292,6 +314,7 @@ void Simplify::ScopedFact::learn_true(const Expr &fact) {
         learn_false(n->a);
     } else if (simplify->truths.insert(fact).second) {
         truths.push_back(fact);
+        simplify->new_context();
     }
 }
 
@@ -308,17 +331,110 @@ Simplify::ScopedFact::~ScopedFact() {
     for (const auto &e : falsehoods) {
         simplify->falsehoods.erase(e);
     }
+    if (simplify) {
+        simplify->restore_context(old_context);
+    }
+}
+
+Expr Simplify::mutate_with_cache(const Expr &e, ExprInfo *b) {
+    // Constants and variables are cheaper to simplify than to look
+    // up. Inside a strict_float the simplifier treats float Exprs
+    // differently without changing the context, so we don't use the
+    // cache there at all.
+    if (no_float_simplify || is_const(e) || e.as<Variable>()) {
+        return Super::dispatch(e, b);
+    }
+
+    ExprWithCompareCache key(e, &compare_cache);
+    auto &cache = expr_cache[context];
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+        const CachedExpr &cached = it->second;
+        // Replay the uses of the let vars bound outside this Expr, so
+        // that simplify_let keeps the lets it would otherwise keep.
+        for (const auto &u : cached.uses) {
+            VarInfo &info = var_info.ref(u.name);
+            internal_assert(info.id == u.id) << "Stale simplifier cache entry for " << e << "\n";
+            count_use(u.name, info, u.new_use);
+        }
+        if (b) {
+            *b = cached.info;
+        }
+        return cached.result;
+    }
+
+    const int start_context = context;
+    const int first_inner_id = last_context + 1;
+    const size_t log_start = use_log.size();
+
+    // Always ask for the bounds, so that the entry can serve callers
+    // that want them.
+    CachedExpr cached;
+    cache_depth++;
+    cached.result = Super::dispatch(e, &cached.info);
+    cache_depth--;
+    internal_assert(context == start_context);
+
+    // Keep one use of each var bound outside this Expr, and drop the
+    // ones bound inside it. Those are out of scope now anyway.
+    for (size_t i = log_start; i < use_log.size(); i++) {
+        if (use_log[i].id < first_inner_id) {
+            cached.uses.push_back(use_log[i]);
+        }
+    }
+    std::sort(cached.uses.begin(), cached.uses.end(),
+              [](const CachedUse &a, const CachedUse &b) {
+                  return a.id < b.id || (a.id == b.id && a.new_use < b.new_use);
+              });
+    cached.uses.erase(std::unique(cached.uses.begin(), cached.uses.end(),
+                                  [](const CachedUse &a, const CachedUse &b) {
+                                      return a.id == b.id && a.new_use == b.new_use;
+                                  }),
+                      cached.uses.end());
+    use_log.resize(log_start);
+    if (cache_depth > 0) {
+        use_log.insert(use_log.end(), cached.uses.begin(), cached.uses.end());
+    }
+
+    if (b) {
+        *b = cached.info;
+    }
+    Expr result = cached.result;
+    expr_cache[context].emplace(key, std::move(cached));
+    return result;
+}
+
+void Simplify::count_use(const string &name, VarInfo &info, bool new_use) {
+    if (new_use) {
+        info.new_uses++;
+    } else {
+        info.old_uses++;
+    }
+    if (cache_depth > 0) {
+        use_log.push_back({name, info.id, new_use});
+    }
+}
+
+void Simplify::restore_context(int c) {
+    context = c;
+    if (use_expr_cache) {
+        // Contexts are numbered in the order they are entered, so the
+        // ones after c can't be entered again. Drop their entries.
+        expr_cache.erase(expr_cache.upper_bound(c), expr_cache.end());
+    }
 }
 
 Expr simplify(const Expr &e, bool remove_dead_let_stmts,
               const Scope<Interval> &bounds,
               const Scope<ModulusRemainder> &alignment) {
+    ScopedCompilationTimer timer(CompilerLogger::Phase::Simplifier);
     return Simplify(remove_dead_let_stmts, &bounds, &alignment).mutate(e, nullptr);
 }
 
 Stmt simplify(const Stmt &s, bool remove_dead_let_stmts,
               const Scope<Interval> &bounds,
               const Scope<ModulusRemainder> &alignment) {
+    ScopedCompilationTimer timer(CompilerLogger::Phase::Simplifier);
     return Simplify(remove_dead_let_stmts, &bounds, &alignment).mutate(s);
 }
 
@@ -335,6 +451,7 @@ Stmt simplify_exprs(const Stmt &s) {
 }
 
 bool can_prove(Expr e, const Scope<Interval> &bounds) {
+    ScopedCompilationTimer timer(CompilerLogger::Phase::Simplifier);
     internal_assert(e.type().is_bool())
         << "Argument to can_prove is not a boolean Expr: " << e << "\n";
 
@@ -225,7 +225,7 @@ Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
                 << "Cannot replace variable " << op->name
                 << " of type " << op->type
                 << " with expression of type " << info.replacement.type() << "\n";
-            info.new_uses++;
+            count_use(op->name, info, true);
             // We want to remutate the replacement, because we may be
             // injecting it into a context where it is known to be a
             // constant (e.g. due to an if).
@@ -233,7 +233,7 @@ Expr Simplify::visit(const Variable *op, ExprInfo *bounds) {
         } else {
             // This expression was not something deemed
             // substitutable - no replacement is defined.
-            info.old_uses++;
+            count_use(op->name, info, false);
             return op;
         }
     } else {
@@ -7,6 +7,7 @@
  * exported in Halide.h. */
 
 #include "Bounds.h"
+#include "IREquality.h"
 #include "IRMatch.h"
 #include "IRVisitor.h"
 #include "Scope.h"
@@ -99,7 +100,7 @@ public:
         const std::string spaces(debug_indent, ' ');
         debug(1) << spaces << "Simplifying Expr: " << e << "\n";
         debug_indent++;
-        Expr new_e = Super::dispatch(e, b);
+        Expr new_e = use_expr_cache ? mutate_with_cache(e, b) : Super::dispatch(e, b);
         debug_indent--;
         if (!new_e.same_as(e)) {
             debug(1)
@@ -113,7 +114,7 @@ public:
 #else
     HALIDE_ALWAYS_INLINE
     Expr mutate(const Expr &e, ExprInfo *b) {
-        Expr new_e = Super::dispatch(e, b);
+        Expr new_e = use_expr_cache ? mutate_with_cache(e, b) : Super::dispatch(e, b);
         internal_assert(new_e.type() == e.type()) << e << " -> " << new_e << "\n";
         return new_e;
     }
@@ -167,6 +168,8 @@ public:
     struct VarInfo {
         Expr replacement;
         int old_uses, new_uses;
+        // The context entered when this var was bound
+        int id = 0;
     };
 
     // Tracked for all let vars
@@ -175,6 +178,48 @@ public:
     // Only tracked for integer let vars
     Scope<ExprInfo> bounds_and_alignment_info;
 
+    // An optional cache of simplified Exprs (see HL_SIMPLIFIER_CACHE
+    // in Simplify.cpp). The result of simplifying an Expr depends on
+    // everything we know about the enclosing scope: var_info,
+    // bounds_and_alignment_info, truths, and falsehoods. Each change
+    // to those enters a new context, and undoing the change returns
+    // to the previous one, so the cache is keyed on the context as
+    // well as the Expr.
+    bool use_expr_cache;
+    int context = 0, last_context = 0;
+
+    // Each entry remembers which let vars from the enclosing scope
+    // the Expr used, so that hits count as uses too.
+    struct CachedUse {
+        std::string name;
+        int id;
+        bool new_use;
+    };
+    struct CachedExpr {
+        Expr result;
+        ExprInfo info;
+        std::vector<CachedUse> uses;
+    };
+    IRCompareCache compare_cache;
+    std::map<int, std::map<ExprWithCompareCache, CachedExpr>> expr_cache;
+
+    // The uses of let vars seen while simplifying the Exprs we are
+    // about to add to the cache.
+    std::vector<CachedUse> use_log;
+    int cache_depth = 0;
+
+    Expr mutate_with_cache(const Expr &e, ExprInfo *b);
+
+    HALIDE_ALWAYS_INLINE
+    int new_context() {
+        context = ++last_context;
+        return context;
+    }
+
+    void restore_context(int c);
+
+    void count_use(const std::string &name, VarInfo &info, bool new_use);
+
     // Symbols used by rewrite rules
     IRMatcher::Wild<0> x;
     IRMatcher::Wild<1> y;
@@ -240,14 +285,26 @@ public:
         void learn_upper_bound(const Variable *v, int64_t val);
         void learn_lower_bound(const Variable *v, int64_t val);
 
+        // The context to return to when this fact goes out of scope
+        int old_context;
+
         ScopedFact(Simplify *s)
-            : simplify(s) {
+            : simplify(s), old_context(s->context) {
         }
         ~ScopedFact();
 
         // allow move but not copy
         ScopedFact(const ScopedFact &that) = delete;
-        ScopedFact(ScopedFact &&that) = default;
+        ScopedFact(ScopedFact &&that) noexcept
+            : simplify(that.simplify),
+              pop_list(std::move(that.pop_list)),
+              bounds_pop_list(std::move(that.bounds_pop_list)),
+              truths(std::move(that.truths)),
+              falsehoods(std::move(that.falsehoods)),
+              old_context(that.old_context) {
+            // The moved-from fact must not restore the context early.
+            that.simplify = nullptr;
+        }
     };
 
     // Tell the simplifier to learn from and exploit a boolean
@@ -58,6 +58,7 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
         }
     };
 
+    const int old_context = context;
     vector<Frame> frames;
     Body result;
 
@@ -193,6 +194,7 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
         info.new_uses = 0;
         info.replacement = replacement;
 
+        info.id = new_context();
         var_info.push(op->name, info);
 
         // Before we enter the body, track the alignment info
@@ -203,6 +205,7 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
             f.new_value = mutate(f.new_value, &new_value_bounds);
             if (new_value_bounds.min_defined || new_value_bounds.max_defined || new_value_bounds.alignment.modulus != 1) {
                 // There is some useful information
+                new_context();
                 bounds_and_alignment_info.push(f.new_name, new_value_bounds);
                 f.new_value_bounds_tracked = true;
             }
@@ -210,6 +213,7 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
 
         if (no_overflow_scalar_int(f.value.type())) {
             if (value_bounds.min_defined || value_bounds.max_defined || value_bounds.alignment.modulus != 1) {
+                new_context();
                 bounds_and_alignment_info.push(op->name, value_bounds);
                 f.value_bounds_tracked = true;
             }
@@ -262,6 +266,7 @@ Body Simplify::simplify_let(const LetOrLetStmt *op, ExprInfo *bounds) {
             result = it->op;
         }
     }
+    restore_context(old_context);
 
     return result;
 }
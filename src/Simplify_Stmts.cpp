@@ -155,12 +155,14 @@ Stmt Simplify::visit(const For *op) {
                                          (in_vector_loop ||
                                           op->for_type == ForType::Vectorized));
 
+    const int old_context = context;
     bool bounds_tracked = false;
     if (min_bounds.min_defined || (min_bounds.max_defined && extent_bounds.max_defined)) {
         min_bounds.max += extent_bounds.max - 1;
         min_bounds.max_defined &= extent_bounds.max_defined;
         min_bounds.alignment = ModulusRemainder{};
         bounds_tracked = true;
+        new_context();
         bounds_and_alignment_info.push(op->name, min_bounds);
     }
 
@@ -168,6 +170,7 @@ Stmt Simplify::visit(const For *op) {
 
     if (bounds_tracked) {
         bounds_and_alignment_info.pop(op->name);
+        restore_context(old_context);
     }
 
     if (is_no_op(new_body)) {
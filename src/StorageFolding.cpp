@@ -61,6 +61,17 @@ class FoldStorageOfFunction : public IRMutator {
     int dim;
     Expr factor;
     string dynamic_footprint;
+    // If defined, the factor is only known at runtime, and is a power
+    // of two. Coordinates are folded by and-ing them with this mask,
+    // which is all ones if it turned out not to be worth folding.
+    Expr mask;
+
+    Expr fold(const Expr &e) const {
+        if (mask.defined()) {
+            return e & mask;
+        }
+        return is_one(factor) ? 0 : (e % factor);
+    }
 
     using IRMutator::visit;
 
@@ -71,7 +82,7 @@ class FoldStorageOfFunction : public IRMutator {
         if (op->name == func && op->call_type == Call::Halide) {
             vector<Expr> args = op->args;
             internal_assert(dim < (int)args.size());
-            args[dim] = is_one(factor) ? 0 : (args[dim] % factor);
+            args[dim] = fold(args[dim]);
             expr = Call::make(op->type, op->name, args, op->call_type,
                               op->func, op->value_index, op->image, op->param);
         } else if (op->name == Call::buffer_crop) {
@@ -87,6 +98,10 @@ class FoldStorageOfFunction : public IRMutator {
                 // need to use folded coordinates, and then restore
                 // the non-folded min after the crop operation.
 
+                // Runtime fold factors aren't used when there are
+                // extern consumers.
+                internal_assert(!mask.defined());
+
                 // Pull out the expressions we need
                 internal_assert(op->args.size() >= 5);
                 Expr mins_arg = op->args[3];
@@ -145,15 +160,15 @@ class FoldStorageOfFunction : public IRMutator {
         internal_assert(op);
         if (op->name == func) {
             vector<Expr> args = op->args;
-            args[dim] = is_one(factor) ? 0 : (args[dim] % factor);
+            args[dim] = fold(args[dim]);
             stmt = Provide::make(op->name, op->values, args);
         }
         return stmt;
     }
 
 public:
-    FoldStorageOfFunction(string f, int d, Expr e, string p)
-        : func(std::move(f)), dim(d), factor(std::move(e)), dynamic_footprint(std::move(p)) {
+    FoldStorageOfFunction(string f, int d, Expr e, string p, Expr m = Expr())
+        : func(std::move(f)), dim(d), factor(std::move(e)), dynamic_footprint(std::move(p)), mask(std::move(m)) {
     }
 };
 
@@ -482,13 +497,79 @@ public:
     }
 };
 
+// Collect the names of the variables defined by lets and loops in a statement.
+class VarsDefinedIn : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const LetStmt *op) override {
+        names.push(op->name);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const For *op) override {
+        names.push(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    Scope<> names;
+};
+
 // Attempt to fold the storage of a particular function in a statement
 class AttemptStorageFoldingOfFunction : public IRMutator {
     Function func;
     bool explicit_only;
+    const Region &realize_bounds;
+    const Stmt &realize_body;
+
+    // The lets and serial loops between the realization and the
+    // current node, outermost first. Loops are recorded with their
+    // min and max.
+    struct Enclosing {
+        string name;
+        Expr value, max;
+    };
+    vector<Enclosing> enclosing;
 
     using IRMutator::visit;
 
+    Stmt visit(const LetStmt *op) override {
+        enclosing.push_back({op->name, op->value, Expr()});
+        Stmt body = mutate(op->body);
+        enclosing.pop_back();
+        if (body.same_as(op->body)) {
+            return op;
+        } else {
+            return LetStmt::make(op->name, op->value, body);
+        }
+    }
+
+    // Find an upper bound for an expression in terms of variables
+    // defined outside the realization, so that it can be used to size
+    // it. Returns an undefined Expr if there isn't one.
+    Expr bound_outside_realization(Expr e) const {
+        for (auto it = enclosing.rbegin(); it != enclosing.rend(); ++it) {
+            if (it->max.defined()) {
+                Scope<Interval> scope;
+                scope.push(it->name, Interval(it->value, it->max));
+                Interval in = bounds_of_expr_in_scope(e, scope);
+                if (!in.has_upper_bound()) {
+                    return Expr();
+                }
+                e = in.max;
+            } else {
+                e = substitute(it->name, it->value, e);
+            }
+        }
+        // Check for anything else defined inside the realization.
+        VarsDefinedIn defined;
+        realize_body.accept(&defined);
+        if (expr_uses_vars(e, defined.names)) {
+            return Expr();
+        }
+        return simplify(common_subexpression_elimination(e));
+    }
+
     Stmt visit(const ProducerConsumer *op) override {
         if (op->name == func.name()) {
             // Can't proceed into the pipeline for this func
@@ -684,6 +765,11 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             internal_assert(can_fold_forwards || can_fold_backwards);
 
             Expr factor;
+            // If the factor is only known at runtime, an upper bound on
+            // the extent to derive it from, and a prefix for the names
+            // of the variables describing the fold.
+            Expr runtime_factor;
+            string runtime_fold_name;
             if (explicit_factor.defined()) {
                 if (dynamic_footprint.empty() && !func.schedule().async()) {
                     // We were able to prove monotonicity
@@ -719,11 +805,31 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                     if (success) {
                         factor = e;
                     } else {
-                        debug(3) << "Not folding because extent not bounded by a constant not greater than " << max_fold << "\n"
-                                 << "extent = " << extent << "\n"
-                                 << "max extent = " << max_extent << "\n";
-                        // Try the next dimension
-                        continue;
+                        // Fall back to a fold factor computed at
+                        // runtime from the actual loop bounds. This
+                        // isn't worth it if the realization has a
+                        // constant size anyway, and isn't attempted
+                        // for async producers, which size their
+                        // semaphores by the factor, or for extern
+                        // consumers, which take crops of the buffer.
+                        if (!is_const(realize_bounds[dim].extent) &&
+                            !func.schedule().async() &&
+                            !has_extern_consumer.result) {
+                            Interval in = bounds_of_expr_in_scope(extent, bounds);
+                            if (in.has_upper_bound()) {
+                                runtime_factor = bound_outside_realization(in.max);
+                            }
+                        }
+                        if (!runtime_factor.defined()) {
+                            debug(3) << "Not folding because extent not bounded by a constant not greater than " << max_fold << "\n"
+                                     << "extent = " << extent << "\n"
+                                     << "max extent = " << max_extent << "\n";
+                            // Try the next dimension
+                            continue;
+                        }
+                        runtime_fold_name = func.name() + "." + func.args()[dim] + unique_name('_');
+                        factor = Variable::make(Int(32), runtime_fold_name + ".fold_factor");
+                        debug(3) << "Folding by a factor computed at runtime from max extent " << runtime_factor << "\n";
                     }
                 }
             }
@@ -750,6 +856,12 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
             debug(3) << "Proceeding with factor " << factor << "\n";
 
             Fold fold = {(int)i - 1, factor};
+            Expr mask;
+            if (runtime_factor.defined()) {
+                fold.runtime_factor = runtime_factor;
+                fold.runtime_name = runtime_fold_name;
+                mask = Variable::make(Int(32), runtime_fold_name + ".fold_mask");
+            }
             dims_folded.push_back(fold);
             {
                 string head;
@@ -758,7 +870,7 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
                 } else {
                     head = dynamic_footprint;
                 }
-                body = FoldStorageOfFunction(func.name(), (int)i - 1, factor, head).mutate(body);
+                body = FoldStorageOfFunction(func.name(), (int)i - 1, factor, head, mask).mutate(body);
             }
 
             // If the producer is async, it can run ahead by
@@ -874,7 +986,9 @@ class AttemptStorageFoldingOfFunction : public IRMutator {
         // iteration to the next (which may happen due to sliding),
         // then we're safe to fold an inner loop.
         if (box_contains(provided, required)) {
+            enclosing.push_back({op->name, op->min, simplify(op->min + op->extent - 1)});
             body = mutate(body);
+            enclosing.pop_back();
         }
 
         if (body.same_as(op->body)) {
@@ -912,11 +1026,16 @@ public:
         Semaphore semaphore;
         string head, tail;
         bool fold_forward;
+        // For folds by a factor only known at runtime, the extent
+        // the factor must cover, and the prefix of the names of the
+        // variables that describe the fold.
+        Expr runtime_factor;
+        string runtime_name;
     };
     vector<Fold> dims_folded;
 
-    AttemptStorageFoldingOfFunction(Function f, bool explicit_only)
-        : func(std::move(f)), explicit_only(explicit_only) {
+    AttemptStorageFoldingOfFunction(Function f, bool explicit_only, const Region &realize_bounds, const Stmt &realize_body)
+        : func(std::move(f)), explicit_only(explicit_only), realize_bounds(realize_bounds), realize_body(realize_body) {
     }
 };
 
@@ -937,7 +1056,7 @@ class StorageFolding : public IRMutator {
         // Don't attempt automatic storage folding if there is
         // more than one produce node for this func.
         bool explicit_only = count_producers(body, op->name) != 1;
-        AttemptStorageFoldingOfFunction folder(func, explicit_only);
+        AttemptStorageFoldingOfFunction folder(func, explicit_only, op->bounds, body);
         debug(3) << "Attempting to fold " << op->name << "\n";
         body = folder.mutate(body);
 
@@ -954,11 +1073,39 @@ class StorageFolding : public IRMutator {
                 Expr f = folder.dims_folded[i].factor;
                 internal_assert(d >= 0 &&
                                 d < (int)bounds.size());
-                bounds[d] = Range(0, f);
+                if (folder.dims_folded[i].runtime_factor.defined()) {
+                    // Only fold if the factor turns out to be smaller
+                    // than the realization. Otherwise keep the full
+                    // extent, and leave coordinates as they are.
+                    Expr folded = Variable::make(Bool(), folder.dims_folded[i].runtime_name + ".folded");
+                    bounds[d] = Range(select(folded, 0, bounds[d].min), select(folded, f, bounds[d].extent));
+                } else {
+                    bounds[d] = Range(0, f);
+                }
             }
 
             Stmt stmt = Realize::make(op->name, op->types, op->memory_type, bounds, op->condition, body);
 
+            // Define the variables describing runtime folds, so that
+            // the decision and the resulting size are visible in the
+            // lowered code.
+            for (const auto &fold : folder.dims_folded) {
+                if (!fold.runtime_factor.defined()) {
+                    continue;
+                }
+                const string &name = fold.runtime_name;
+                Expr max_extent = Variable::make(Int(32), name + ".max_extent");
+                Expr factor = fold.factor;
+                Expr folded = Variable::make(Bool(), name + ".folded");
+                // Round the factor up to a power of two, so that
+                // folding is a mask rather than a division.
+                Expr rounded = 1 << (32 - count_leading_zeros(clamp(max_extent, 1, 1 << 30) - 1));
+                stmt = LetStmt::make(name + ".fold_mask", select(folded, factor - 1, -1), stmt);
+                stmt = LetStmt::make(name + ".folded", max_extent <= factor && factor < op->bounds[fold.dim].extent, stmt);
+                stmt = LetStmt::make(name + ".fold_factor", rounded, stmt);
+                stmt = LetStmt::make(name + ".max_extent", fold.runtime_factor, stmt);
+            }
+
             // Each fold may have an associated semaphore that needs initialization, along with some counters
             for (const auto &fold : folder.dims_folded) {
                 auto sema = fold.semaphore;
@@ -163,6 +163,25 @@ Target calculate_host_target() {
             if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
                 initial_features.push_back(Target::AVX512_Cannonlake);
             }
+
+            // AVX512-VNNI is reported in ecx of leaf 7, and
+            // AVX512-BF16 in eax of sub-leaf 1 of leaf 7.
+            const uint32_t avx512vnni = 1U << 11;
+            const uint32_t avx512bf16 = 1U << 5;
+            int info3[4];
+            cpuid(info3, 7, 1);
+            const bool have_cascadelake = ((info2[1] & avx512_skylake) == avx512_skylake &&
+                                           (info2[2] & avx512vnni) == avx512vnni);
+            const bool have_cooperlake = have_cascadelake && (info3[0] & avx512bf16) == avx512bf16;
+            if (have_cascadelake) {
+                initial_features.push_back(Target::AVX512_Cascadelake);
+            }
+            if (have_cooperlake) {
+                initial_features.push_back(Target::AVX512_Cooperlake);
+                if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
+                    initial_features.push_back(Target::AVX512_SapphireRapids);
+                }
+            }
         }
     }
 #endif
@@ -358,6 +377,11 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"arm_dot_prod", Target::ARMDotProd},
     {"llvm_large_code_model", Target::LLVMLargeCodeModel},
     {"rvv", Target::RVV},
+    {"profile_events", Target::ProfileEvents},
+    {"avx512_cascadelake", Target::AVX512_Cascadelake},
+    {"avx512_cooperlake", Target::AVX512_Cooperlake},
+    {"avx512_sapphirerapids", Target::AVX512_SapphireRapids},
+    {"auto_prefetch", Target::AutoPrefetch},
     // NOTE: When adding features to this map, be sure to update PyEnums.cpp as well.
 };
 
@@ -881,14 +905,17 @@ int Target::natural_vector_size(const Halide::Type &t) const {
             return 1;
         }
     } else if (arch == Target::X86) {
-        if (is_integer && (has_feature(Halide::Target::AVX512_Skylake) ||
-                           has_feature(Halide::Target::AVX512_Cannonlake))) {
-            // AVX512BW exists on Skylake and Cannonlake
+        const bool avx512bw = features_any_of({Halide::Target::AVX512_Skylake,
+                                               Halide::Target::AVX512_Cannonlake,
+                                               Halide::Target::AVX512_Cascadelake,
+                                               Halide::Target::AVX512_Cooperlake,
+                                               Halide::Target::AVX512_SapphireRapids});
+        if (is_integer && avx512bw) {
+            // AVX512BW exists on Skylake and everything after it
             return 64 / data_size;
-        } else if (t.is_float() && (has_feature(Halide::Target::AVX512) ||
-                                    has_feature(Halide::Target::AVX512_KNL) ||
-                                    has_feature(Halide::Target::AVX512_Skylake) ||
-                                    has_feature(Halide::Target::AVX512_Cannonlake))) {
+        } else if (t.is_float() && (avx512bw ||
+                                    has_feature(Halide::Target::AVX512) ||
+                                    has_feature(Halide::Target::AVX512_KNL))) {
             // AVX512F is on all AVX512 architectures
             return 64 / data_size;
         } else if (has_feature(Halide::Target::AVX2)) {
@@ -933,7 +960,7 @@ bool Target::get_runtime_compatible_target(const Target &other, Target &result)
                                                      CUDACapability30, CUDACapability32, CUDACapability35, CUDACapability50, CUDACapability61, CUDACapability70, CUDACapability75, CUDACapability80,
                                                      HVX_v62, HVX_v65, HVX_v66}};
 
-    const std::array<Feature, 12> intersection_features = {{SSE41, AVX, AVX2, FMA, FMA4, F16C, ARMv7s, VSX, AVX512, AVX512_KNL, AVX512_Skylake, AVX512_Cannonlake}};
+    const std::array<Feature, 15> intersection_features = {{SSE41, AVX, AVX2, FMA, FMA4, F16C, ARMv7s, VSX, AVX512, AVX512_KNL, AVX512_Skylake, AVX512_Cannonlake, AVX512_Cascadelake, AVX512_Cooperlake, AVX512_SapphireRapids}};
 
     const std::array<Feature, 10> matching_features = {{SoftFloatABI, Debug, TSAN, ASAN, MSAN, HVX, HexagonDma, HVX_shared_object}};
 
@@ -126,6 +126,11 @@ struct Target {
         ARMDotProd = halide_target_feature_arm_dot_prod,
         LLVMLargeCodeModel = halide_llvm_large_code_model,
         RVV = halide_target_feature_rvv,
+        ProfileEvents = halide_target_feature_profile_events,
+        AVX512_Cascadelake = halide_target_feature_avx512_cascadelake,
+        AVX512_Cooperlake = halide_target_feature_avx512_cooperlake,
+        AVX512_SapphireRapids = halide_target_feature_avx512_sapphirerapids,
+        AutoPrefetch = halide_target_feature_auto_prefetch,
         FeatureEnd = halide_target_feature_end
     };
     Target() = default;
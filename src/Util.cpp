@@ -2,6 +2,7 @@
 #include "Debug.h"
 #include "Error.h"
 #include "Introspection.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <fstream>
@@ -147,12 +148,55 @@ const int num_unique_name_counters = (1 << 14);
 // this is a global, which is always zero-initialized.
 std::atomic<int> unique_name_counters[num_unique_name_counters] = {};
 
+// Set while a ScopedUniqueNameCounters is alive on this thread.
+thread_local std::vector<int> *thread_unique_name_counters = nullptr;
+
 int unique_count(size_t h) {
     h = h & (num_unique_name_counters - 1);
+    if (thread_unique_name_counters) {
+        return (*thread_unique_name_counters)[h]++;
+    }
     return unique_name_counters[h]++;
 }
 }  // namespace
 
+std::vector<int> ScopedUniqueNameCounters::snapshot() {
+    if (thread_unique_name_counters) {
+        return *thread_unique_name_counters;
+    }
+    std::vector<int> result(num_unique_name_counters);
+    for (int i = 0; i < num_unique_name_counters; i++) {
+        result[i] = unique_name_counters[i];
+    }
+    return result;
+}
+
+void ScopedUniqueNameCounters::advance(const std::vector<int> &past) {
+    internal_assert(past.size() == (size_t)num_unique_name_counters);
+    for (int i = 0; i < num_unique_name_counters; i++) {
+        if (thread_unique_name_counters) {
+            int &c = (*thread_unique_name_counters)[i];
+            c = std::max(c, past[i]);
+        } else {
+            int old_value = unique_name_counters[i];
+            while (old_value < past[i] &&
+                   !unique_name_counters[i].compare_exchange_weak(old_value, past[i])) {
+            }
+        }
+    }
+}
+
+ScopedUniqueNameCounters::ScopedUniqueNameCounters(const std::vector<int> &start)
+    : counters(start), previous(thread_unique_name_counters) {
+    internal_assert(counters.size() == (size_t)num_unique_name_counters);
+    thread_unique_name_counters = &counters;
+}
+
+ScopedUniqueNameCounters::~ScopedUniqueNameCounters() {
+    thread_unique_name_counters = previous;
+    advance(counters);
+}
+
 // There are three possible families of names returned by the methods below:
 // 1) char pattern: (char that isn't '$') + number (e.g. v234)
 // 2) string pattern: (string without '$') + '$' + number (e.g. fr#nk82$42)
@@ -151,6 +151,37 @@ std::string unique_name(char prefix);
 std::string unique_name(const std::string &prefix);
 // @}
 
+/** While one of these is alive, unique_name on the current thread
+ * draws from a private copy of its counters, starting from a snapshot.
+ * Compilations that start from the same snapshot on different threads
+ * then make the same names regardless of how the threads interleave.
+ * On destruction, the counters the thread used before are advanced
+ * past every value the private copy handed out, so later names remain
+ * unique. */
+class ScopedUniqueNameCounters {
+    std::vector<int> counters;
+    std::vector<int> *previous;
+
+public:
+    /** The counters unique_name would currently use on this thread. */
+    static std::vector<int> snapshot();
+
+    /** Advance the counters unique_name currently uses on this thread
+     * past the given values. */
+    static void advance(const std::vector<int> &past);
+
+    /** The counters this object has handed out so far. */
+    const std::vector<int> &current() const {
+        return counters;
+    }
+
+    explicit ScopedUniqueNameCounters(const std::vector<int> &start);
+    ~ScopedUniqueNameCounters();
+
+    ScopedUniqueNameCounters(const ScopedUniqueNameCounters &) = delete;
+    ScopedUniqueNameCounters &operator=(const ScopedUniqueNameCounters &) = delete;
+};
+
 /** Test if the first string starts with the second string */
 bool starts_with(const std::string &str, const std::string &prefix);
 
@@ -54,6 +54,12 @@
   HL_NO_SUBTILING
   If set to 1, limits the search space to that of Mullapudi et al.
 
+  HL_NO_FEATURE_MEMOS
+  If set to 1, featurizes every loop nest from scratch, instead of reusing the features of parts of it that haven't changed. The schedule found does not depend on this.
+
+  HL_CHECK_FEATURE_MEMOS
+  If set to 1, featurizes every loop nest from scratch, and checks that any features that would have been reused match. This is for debugging the autoscheduler.
+
   HL_DEBUG_AUTOSCHEDULE
   If set, is used for the debug log level for auto-schedule generation (overriding the
   value of HL_DEBUG_CODEGEN, if any).
@@ -61,14 +67,19 @@
   HL_AUTOSCHEDULE_MEMORY_LIMIT
   If set, only consider schedules that allocate at most this much memory (measured in bytes).
 
+  HL_AUTOSCHEDULE_NUM_THREADS
+  Number of threads to use to expand the states in the beam. Defaults to the number of cores. The schedule found does not depend on this.
+
   TODO: expose these settings by adding some means to pass args to
   generator plugins instead of environment vars.
 */
 #include "HalidePlugin.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <queue>
 #include <random>
@@ -191,7 +202,7 @@ struct State {
     void operator=(const State &) = delete;
     void operator=(State &&) = delete;
 
-    static int cost_calculations;
+    static std::atomic<int> cost_calculations;
 
     uint64_t structural_hash(int depth) const {
         uint64_t h = num_decisions_made;
@@ -527,7 +538,7 @@ struct State {
             vector<int> vector_dims;
             if (!node->is_input && !node->is_output) {
                 for (int v = 0; v < node->dimensions; v++) {
-                    const auto &p = root->get_bounds(node)->region_computed(v);
+                    const auto p = root->get_bounds(node)->region_computed(v);
                     if (p.extent() >= node->vector_size) {
                         vector_dims.push_back(v);
                     }
@@ -909,7 +920,68 @@ struct State {
 };
 
 // Keep track of how many times we evaluated a state.
-int State::cost_calculations = 0;
+std::atomic<int> State::cost_calculations{0};
+
+// The children of a state are generated and featurized on worker
+// threads, but the cost model isn't thread-safe, and the order in
+// which states reach the cost model and the priority queue affects
+// which schedule we end up with. So each worker records what
+// generate_children does with its cost model and its children here,
+// and the main thread replays it, in the order a serial search would
+// have done it.
+class ExpansionLog : public CostModel {
+    struct Event {
+        // Either a schedule to enqueue into the cost model...
+        StageMapOfScheduleFeatures features;
+        double *cost_ptr = nullptr;
+        // ...or a child to add to the beam.
+        IntrusivePtr<State> child;
+    };
+
+    vector<Event> events;
+
+public:
+    void set_pipeline_features(const FunctionDAG &dag,
+                               const MachineParams &params) override {
+        internal_error << "ExpansionLog does not evaluate costs itself\n";
+    }
+
+    void enqueue(const FunctionDAG &dag,
+                 const StageMapOfScheduleFeatures &schedule_feats,
+                 double *cost_ptr) override {
+        Event e;
+        e.features = schedule_feats;
+        e.cost_ptr = cost_ptr;
+        events.emplace_back(std::move(e));
+    }
+
+    void evaluate_costs() override {
+        internal_error << "ExpansionLog does not evaluate costs itself\n";
+    }
+
+    void reset() override {
+        events.clear();
+    }
+
+    void accept_child(IntrusivePtr<State> &&s) {
+        Event e;
+        e.child = std::move(s);
+        events.emplace_back(std::move(e));
+    }
+
+    void replay(const FunctionDAG &dag,
+                CostModel *cost_model,
+                std::function<void(IntrusivePtr<State> &&)> &accept_child) {
+        for (auto &e : events) {
+            if (e.child.defined()) {
+                accept_child(std::move(e.child));
+            } else {
+                cost_model->enqueue(dag, e.features, e.cost_ptr);
+            }
+        }
+        events.clear();
+    }
+};
 
 // A priority queue of states, sorted according to increasing
 // cost. Never shrinks, to avoid reallocations.
@@ -995,7 +1067,8 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                                           int pass_idx,
                                           int num_passes,
                                           ProgressBar &tick,
-                                          std::unordered_set<uint64_t> &permitted_hashes) {
+                                          std::unordered_set<uint64_t> &permitted_hashes,
+                                          ThreadPool<void> *thread_pool) {
 
     if (cost_model) {
         configure_pipeline_features(dag, params, cost_model);
@@ -1054,7 +1127,8 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                                              pass_idx,
                                              num_passes,
                                              tick,
-                                             permitted_hashes);
+                                             permitted_hashes,
+                                             thread_pool);
             } else {
                 internal_error << "Ran out of legal states with beam size " << beam_size << "\n";
             }
@@ -1064,6 +1138,10 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
             aslog(0) << "Warning: Huge number of states generated (" << pending.size() << ").\n";
         }
 
+        // The states to expand this step, in the order we pulled
+        // them off the queue.
+        vector<IntrusivePtr<State>> to_expand;
+
         expanded = 0;
         while (expanded < beam_size && !pending.empty()) {
 
@@ -1142,13 +1220,48 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                 return best;
             }
 
-            state->generate_children(dag, params, cost_model, memory_limit, enqueue_new_children);
+            to_expand.emplace_back(std::move(state));
             expanded++;
         }
 
         // Drop the other states unconsidered.
         pending.clear();
 
+        // Generating and featurizing the children is where almost
+        // all of the time goes, so do it in parallel, one task per
+        // state in the beam.
+        vector<ExpansionLog> logs(to_expand.size());
+        auto expand = [&](size_t idx) {
+            ExpansionLog &log = logs[idx];
+            std::function<void(IntrusivePtr<State> &&)> accept_child =
+                [&](IntrusivePtr<State> &&s) {
+                    log.accept_child(std::move(s));
+                };
+            to_expand[idx]->generate_children(dag, params, cost_model ? &log : nullptr,
+                                              memory_limit, accept_child);
+        };
+        if (thread_pool && to_expand.size() > 1) {
+            vector<std::future<void>> tasks;
+            for (size_t idx = 0; idx < to_expand.size(); idx++) {
+                tasks.emplace_back(thread_pool->async(expand, idx));
+            }
+            // Let all the tasks finish before rethrowing any errors,
+            // because they refer to things on this stack frame.
+            for (auto &t : tasks) {
+                t.wait();
+            }
+            for (auto &t : tasks) {
+                t.get();
+            }
+        } else {
+            for (size_t idx = 0; idx < to_expand.size(); idx++) {
+                expand(idx);
+            }
+        }
+        for (auto &log : logs) {
+            log.replay(dag, cost_model, enqueue_new_children);
+        }
+
         if (cost_model) {
             // Now evaluate all the costs and re-sort them in the priority queue
             cost_model->evaluate_costs();
@@ -1213,12 +1326,27 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
         num_passes = std::atoi(num_passes_str.c_str());
     }
 
+    size_t num_threads = ThreadPool<void>::num_processors_online();
+    string num_threads_str = get_env_variable("HL_AUTOSCHEDULE_NUM_THREADS");
+    if (!num_threads_str.empty()) {
+        num_threads = std::max(1, std::atoi(num_threads_str.c_str()));
+    }
+    if (cyos_str == "1" || beam_size == 1) {
+        // There's nothing to expand in parallel.
+        num_threads = 1;
+    }
+    std::unique_ptr<ThreadPool<void>> thread_pool;
+    if (num_threads > 1) {
+        thread_pool.reset(new ThreadPool<void>(num_threads));
+    }
+
     for (int i = 0; i < num_passes; i++) {
         ProgressBar tick;
 
         auto pass = optimal_schedule_pass(dag, outputs, params, cost_model,
                                           rng, beam_size, memory_limit,
-                                          i, num_passes, tick, permitted_hashes);
+                                          i, num_passes, tick, permitted_hashes,
+                                          thread_pool.get());
 
         tick.clear();
 
@@ -1299,7 +1427,7 @@ void generate_schedule(const std::vector<Function> &outputs,
 
     HALIDE_TOC;
 
-    aslog(1) << "Cost evaluated this many times: " << State::cost_calculations << "\n";
+    aslog(1) << "Cost evaluated this many times: " << State::cost_calculations.load() << "\n";
 
     // Dump the schedule found
     aslog(1) << "** Optimal schedule:\n";
@@ -26,6 +26,21 @@ bool may_subtile() {
     return b;
 }
 
+// Set HL_NO_FEATURE_MEMOS=1 to featurize every child of the root from
+// scratch instead of reusing its features from an identical context.
+bool use_feature_memos() {
+    static bool b = get_env_variable("HL_NO_FEATURE_MEMOS") != "1";
+    return b;
+}
+
+// Set HL_CHECK_FEATURE_MEMOS=1 to featurize the children of the root
+// from scratch even when there are memoized features, and check that
+// the two agree.
+bool check_feature_memos() {
+    static bool b = get_env_variable("HL_CHECK_FEATURE_MEMOS") == "1";
+    return b;
+}
+
 // Given a multi-dimensional box of dimensionality d, generate a list
 // of candidate tile sizes for it, logarithmically spacing the sizes
 // using the given factor. If 'allow_splits' is false, every dimension
@@ -126,7 +141,7 @@ void LoopNest::copy_from(const LoopNest &n) {
     children = n.children;
     inlined = n.inlined;
     store_at = n.store_at;
-    bounds = n.bounds;
+    copy_bounds_from(n);
     node = n.node;
     stage = n.stage;
     innermost = n.innermost;
@@ -321,9 +336,30 @@ void LoopNest::compute_features(const FunctionDAG &dag,
     }
 
     if (is_root()) {
+        // Funcs inlined into more than one child of the root
+        // accumulate features from all of them, so the features of
+        // those children can't be reused independently.
+        vector<FeatureContext> contexts(children.size());
+        vector<int> times_inlined(dag.nodes.size(), 0);
+        for (size_t i = 0; i < children.size(); i++) {
+            if (!use_feature_memos()) {
+                contexts[i].valid = false;
+                continue;
+            }
+            children[i]->get_feature_context(dag, sites, &contexts[i]);
+            for (const auto *f : contexts[i].inlined) {
+                times_inlined[f->id]++;
+            }
+        }
+
         // TODO: This block of code is repeated below. Refactor
-        for (const auto &c : children) {
-            c->compute_features(dag, params, sites, subinstances, parallelism, this, parent, root, &working_set_here, features);
+        for (size_t i = 0; i < children.size(); i++) {
+            auto &ctx = contexts[i];
+            for (const auto *f : ctx.inlined) {
+                ctx.valid &= (times_inlined[f->id] == 1);
+            }
+            children[i]->compute_features_of_root_child(dag, params, sites, subinstances, parallelism,
+                                                        this, parent, root, ctx, &working_set_here, features);
         }
 
         for (const auto *node : store_at) {
@@ -954,16 +990,191 @@ void LoopNest::compute_features(const FunctionDAG &dag,
     }
 }
 
+void LoopNest::get_feature_context(const FunctionDAG &dag,
+                                   const StageMap<Sites> &sites,
+                                   FeatureContext *ctx) const {
+    // Find all the loops in this loop nest, and the stages they compute.
+    set<const LoopNest *> loops;
+    vector<const LoopNest *> pending;
+    pending.push_back(this);
+    while (!pending.empty()) {
+        const LoopNest *l = pending.back();
+        pending.pop_back();
+        loops.insert(l);
+        ctx->stages.push_back(l->stage);
+        for (const auto *f : l->store_at) {
+            for (const auto &s : f->stages) {
+                ctx->stages.push_back(&s);
+            }
+        }
+        for (auto it = l->inlined.begin(); it != l->inlined.end(); it++) {
+            ctx->inlined.push_back(it.key());
+            ctx->stages.push_back(&(it.key()->stages[0]));
+        }
+        for (const auto &c : l->children) {
+            pending.push_back(c.get());
+        }
+    }
+    std::sort(ctx->stages.begin(), ctx->stages.end(),
+              [](const FunctionDAG::Node::Stage *a, const FunctionDAG::Node::Stage *b) {
+                  return a->id < b->id;
+              });
+    ctx->stages.erase(std::unique(ctx->stages.begin(), ctx->stages.end()), ctx->stages.end());
+    std::sort(ctx->inlined.begin(), ctx->inlined.end(),
+              [](const FunctionDAG::Node *a, const FunctionDAG::Node *b) {
+                  return a->id < b->id;
+              });
+    ctx->inlined.erase(std::unique(ctx->inlined.begin(), ctx->inlined.end()), ctx->inlined.end());
+
+    // compute_features looks at the sites of those stages, and of
+    // the Funcs they load from.
+    vector<bool> used(dag.nodes.size(), false);
+    for (const auto *s : ctx->stages) {
+        used[s->node->id] = true;
+        for (const auto *e : s->incoming_edges) {
+            used[e->producer->id] = true;
+        }
+    }
+
+    // Loops in this loop nest are immutable, so we can identify them
+    // by address. The bounds at the root don't depend on the
+    // schedule. We only look at the vector_dim of the produce site
+    // of a Func computed elsewhere, but if it's computed or stored
+    // somewhere other than here or the root, we'd need its bounds
+    // there too.
+    auto encode = [&](const LoopNest *l) -> int64_t {
+        if (l == nullptr) {
+            return 0;
+        } else if (l->is_root()) {
+            return 1;
+        } else if (loops.count(l)) {
+            return (int64_t)(intptr_t)l;
+        } else {
+            return 2;
+        }
+    };
+    for (const auto &n : dag.nodes) {
+        if (!used[n.id]) {
+            continue;
+        }
+        for (const auto &s : n.stages) {
+            if (!sites.contains(&s)) {
+                ctx->key.push_back(-1);
+                continue;
+            }
+            const auto &site = sites.get(&s);
+            int64_t compute = encode(site.compute), store = encode(site.store);
+            if (compute == 2 || store == 2) {
+                ctx->valid = false;
+                return;
+            }
+            ctx->key.push_back(site.inlined);
+            ctx->key.push_back(compute);
+            ctx->key.push_back(store);
+            ctx->key.push_back(encode(site.produce));
+            ctx->key.push_back(site.produce ? site.produce->vector_dim : -1);
+            ctx->key.push_back(encode(site.innermost));
+            ctx->key.push_back(encode(site.task));
+        }
+    }
+}
+
+void LoopNest::compute_features_of_root_child(const FunctionDAG &dag,
+                                              const MachineParams &params,
+                                              const StageMap<Sites> &sites,
+                                              int64_t instances,
+                                              int64_t parallelism,
+                                              const LoopNest *parent,
+                                              const LoopNest *grandparent,
+                                              const LoopNest &root,
+                                              const FeatureContext &ctx,
+                                              int64_t *working_set,
+                                              StageMap<ScheduleFeatures> *features) const {
+    internal_assert(parent && parent->is_root());
+
+    FeatureMemo to_check;
+    bool found = false;
+    if (ctx.valid) {
+        std::lock_guard<std::mutex> lock(feature_memos_mutex);
+        for (const auto &m : feature_memos) {
+            if (m.key == ctx.key) {
+                if (check_feature_memos()) {
+                    to_check = m;
+                    found = true;
+                    break;
+                }
+                for (const auto &f : m.features) {
+                    features->get_or_create(f.first) = f.second;
+                }
+                *working_set += m.working_set;
+                return;
+            }
+        }
+    }
+
+    int64_t working_set_here = 0;
+    compute_features(dag, params, sites, instances, parallelism, parent, grandparent, root, &working_set_here, features);
+    *working_set += working_set_here;
+
+    if (found) {
+        internal_assert(working_set_here == to_check.working_set)
+            << "Memoized working set " << to_check.working_set
+            << " differs from recomputed working set " << working_set_here << "\n";
+        for (const auto &f : to_check.features) {
+            const auto &computed = features->get(f.first);
+            for (size_t i = 0; i < ScheduleFeatures::num_features(); i++) {
+                // Compare NaNs as equal.
+                bool same = computed[i] == f.second[i] || (computed[i] != computed[i] && f.second[i] != f.second[i]);
+                internal_assert(same)
+                    << "Memoized feature " << i << " of " << f.first->name << " is " << f.second[i]
+                    << " but recomputes as " << computed[i] << "\n";
+            }
+        }
+        return;
+    }
+
+    if (!ctx.valid) {
+        return;
+    }
+
+    // The stages in the context are the only ones this loop nest
+    // writes features for, and nothing else writes features for
+    // them before we do, so they're a function of the context.
+    FeatureMemo m;
+    m.key = ctx.key;
+    m.working_set = working_set_here;
+    for (const auto *s : ctx.stages) {
+        if (features->contains(s)) {
+            m.features.emplace_back(s, features->get(s));
+        }
+    }
+
+    // Remember a few contexts, to bound the memory used.
+    const size_t max_feature_memos = 8;
+    std::lock_guard<std::mutex> lock(feature_memos_mutex);
+    if (feature_memos.size() >= max_feature_memos) {
+        feature_memos.erase(feature_memos.begin());
+    }
+    feature_memos.emplace_back(std::move(m));
+}
+
 // Get the region required of a Func at this site, from which we
 // know what region would be computed if it were scheduled here,
 // and what its loop nest would be.
-const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
-    if (bounds.contains(f)) {
-        const Bound &b = bounds.get(f);
-        // Expensive validation for debugging
-        // b->validate();
-        return b;
+Bound LoopNest::get_bounds(const FunctionDAG::Node *f) const {
+    {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        if (bounds.contains(f)) {
+            const Bound &b = bounds.get(f);
+            // Expensive validation for debugging
+            // b->validate();
+            return b;
+        }
     }
+    // Compute the bounds without holding the lock, because it
+    // recursively queries the bounds of the consumers at this
+    // site. If another thread races us to it, it computes the same
+    // thing, so it doesn't matter which one ends up in the cache.
     auto *bound = f->make_bound();
 
     // Compute the region required
@@ -1014,7 +1225,7 @@ const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
         f->loop_nest_for_region(i, &(bound->region_computed(0)), &(bound->loops(i, 0)));
     }
 
-    const Bound &b = set_bounds(f, bound);
+    Bound b = set_bounds(f, bound);
     // Validation is expensive, turn if off by default.
     // b->validate();
     return b;
@@ -1308,7 +1519,7 @@ IntrusivePtr<const LoopNest> LoopNest::parallelize_in_tiles(const MachineParams
     inner->innermost = innermost;
     inner->children = children;
     inner->inlined = inlined;
-    inner->bounds = bounds;
+    inner->copy_bounds_from(*this);
     inner->store_at = store_at;
 
     auto *b = inner->get_bounds(node)->make_copy();
@@ -1478,7 +1689,7 @@ vector<IntrusivePtr<const LoopNest>> LoopNest::compute_in_tiles(const FunctionDA
             inner->innermost = innermost;
             inner->children = children;
             inner->inlined = inlined;
-            inner->bounds = bounds;
+            inner->copy_bounds_from(*this);
             inner->store_at = store_at;
 
             {
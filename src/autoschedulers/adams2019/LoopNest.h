@@ -8,6 +8,7 @@
 
 #include "FunctionDAG.h"
 #include "PerfectHashMap.h"
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -53,6 +54,11 @@ struct LoopNest {
     // little boxes to the left of the loop nest tree figures.
     mutable NodeMap<Bound> bounds;
 
+    // LoopNests are shared between States, which may be expanded on
+    // different threads, so the lazily-filled bounds cache above is
+    // guarded by this mutex.
+    mutable std::mutex bounds_mutex;
+
     // The Func this loop nest belongs to
     const FunctionDAG::Node *node = nullptr;
 
@@ -134,6 +140,53 @@ struct LoopNest {
                           int64_t *working_set,
                           StageMap<ScheduleFeatures> *features) const;
 
+    // Everything the features of a child of the root depend on,
+    // other than the loop nest itself.
+    struct FeatureContext {
+        // The sites of the stages it computes, inlines, or loads from.
+        vector<int64_t> key;
+        // The stages whose features it computes.
+        vector<const FunctionDAG::Node::Stage *> stages;
+        // The Funcs inlined into it.
+        vector<const FunctionDAG::Node *> inlined;
+        // False if the features also depend on other parts of the
+        // loop nest in ways the key doesn't capture.
+        bool valid = true;
+    };
+
+    void get_feature_context(const FunctionDAG &dag,
+                             const StageMap<Sites> &sites,
+                             FeatureContext *ctx) const;
+
+    // Compute the features of a child of the root, reusing the
+    // features it computed last time it was in the same context if
+    // there are any. Most children of the root are shared unchanged
+    // between a State and its children in the beam search, so this
+    // saves re-featurizing all but the part of the loop nest that
+    // changed.
+    void compute_features_of_root_child(const FunctionDAG &dag,
+                                        const MachineParams &params,
+                                        const StageMap<Sites> &sites,
+                                        int64_t instances,
+                                        int64_t parallelism,
+                                        const LoopNest *parent,
+                                        const LoopNest *grandparent,
+                                        const LoopNest &root,
+                                        const FeatureContext &ctx,
+                                        int64_t *working_set,
+                                        StageMap<ScheduleFeatures> *features) const;
+
+    // The features this loop nest computed as a child of the root in
+    // the last few contexts it was featurized in, for
+    // compute_features_of_root_child. Guarded by feature_memos_mutex.
+    struct FeatureMemo {
+        vector<int64_t> key;
+        vector<pair<const FunctionDAG::Node::Stage *, ScheduleFeatures>> features;
+        int64_t working_set;
+    };
+    mutable vector<FeatureMemo> feature_memos;
+    mutable std::mutex feature_memos_mutex;
+
     bool is_root() const {
         // The root is the sole node without a Func associated with
         // it.
@@ -141,14 +194,22 @@ struct LoopNest {
     }
 
     // Set the region required of a Func at this site.
-    const Bound &set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+    Bound set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
         return bounds.emplace(f, b);
     }
 
     // Get the region required of a Func at this site, from which we
     // know what region would be computed if it were scheduled here,
-    // and what its loop nest would be.
-    const Bound &get_bounds(const FunctionDAG::Node *f) const;
+    // and what its loop nest would be. Returned by value, because
+    // another thread may grow the cache while we're using it.
+    Bound get_bounds(const FunctionDAG::Node *f) const;
+
+    // Copy the bounds cache of another loop nest.
+    void copy_bounds_from(const LoopNest &n) {
+        std::lock_guard<std::mutex> lock(n.bounds_mutex);
+        bounds = n.bounds;
+    }
 
     // Recursively print a loop nest representation to stderr
     void dump(string prefix, const LoopNest *parent) const;
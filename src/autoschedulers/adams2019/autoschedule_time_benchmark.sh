@@ -0,0 +1,76 @@
+#!/bin/bash
+
+# Measure how long the autoscheduler takes to schedule some of the
+# generators in apps/, once with a single thread and once with all the
+# threads given by HL_AUTOSCHEDULE_NUM_THREADS (defaulting to the
+# number of cores), and check that both produce the same schedule.
+
+if [ $# -lt 3 ]; then
+  echo "Usage: $0 halide_distrib_path halide_target output_dir [app ...]"
+  exit 1
+fi
+
+set -eu
+
+HALIDE_DISTRIB_PATH=$(cd ${1} && pwd)
+HL_TARGET=${2}
+mkdir -p ${3}
+OUT=$(cd ${3} && pwd)
+shift 3
+
+HALIDE_SRC_ROOT=$(cd $(dirname $0)/../../.. && pwd)
+
+if [ $# -gt 0 ]; then
+    APPS="$@"
+else
+    APPS="bilateral_grid camera_pipe harris iir_blur interpolate lens_blur local_laplacian nl_means resnet_50 stencil_chain unsharp"
+fi
+
+# Make the search deterministic, and the same as the default build
+# settings.
+export HL_SEED=${HL_SEED:-0}
+export HL_RANDOM_DROPOUT=100
+
+THREADS=${HL_AUTOSCHEDULE_NUM_THREADS:-$(getconf _NPROCESSORS_ONLN)}
+
+printf "%-20s %14s %14s %10s\n" "app" "1 thread (s)" "${THREADS} threads (s)" "speedup"
+
+FAILED=0
+for APP in ${APPS}; do
+    # The generator name is usually the app name
+    case ${APP} in
+        resnet_50) GENERATOR_NAME=resnet50 ;;
+        *) GENERATOR_NAME=${APP} ;;
+    esac
+
+    # Build the generator with the Adams2019 autoscheduler linked in.
+    GENERATOR=${OUT}/${APP}/host/${GENERATOR_NAME}.generator
+    make -s -C ${HALIDE_SRC_ROOT}/apps/${APP} \
+         HALIDE_DISTRIB_PATH=${HALIDE_DISTRIB_PATH} \
+         AUTOSCHEDULER=adams2019 \
+         BIN=${OUT}/${APP} \
+         ${GENERATOR} > /dev/null
+
+    for T in 1 ${THREADS}; do
+        mkdir -p ${OUT}/${APP}/${T}
+        START=$(date +%s.%N)
+        HL_AUTOSCHEDULE_NUM_THREADS=${T} \
+            ${GENERATOR} -g ${GENERATOR_NAME} -o ${OUT}/${APP}/${T} -f ${GENERATOR_NAME} \
+            -e schedule target=${HL_TARGET} auto_schedule=true -s Adams2019 \
+            2> ${OUT}/${APP}/${T}/autoschedule.log
+        END=$(date +%s.%N)
+        eval TIME_${T//[^0-9]/}=$(echo "${END} - ${START}" | bc)
+    done
+
+    SERIAL=${TIME_1}
+    PARALLEL=$(eval echo \${TIME_${THREADS//[^0-9]/}})
+    printf "%-20s %14.2f %14.2f %9.2fx\n" ${APP} ${SERIAL} ${PARALLEL} $(echo "${SERIAL} / ${PARALLEL}" | bc -l)
+
+    if ! cmp -s ${OUT}/${APP}/1/${GENERATOR_NAME}.schedule.h \
+                ${OUT}/${APP}/${THREADS}/${GENERATOR_NAME}.schedule.h; then
+        echo "${APP}: the schedule depends on the number of threads"
+        FAILED=1
+    fi
+done
+
+exit ${FAILED}
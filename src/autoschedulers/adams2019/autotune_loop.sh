@@ -39,7 +39,7 @@ BENCHMARKING_TIMEOUT=60s
 if [ -z ${HL_TARGET} ]; then
 # Use the host target -- but remove features that we don't want to train
 # for by default, at least not yet (most notably, AVX512).
-HL_TARGET=`${AUTOSCHED_BIN}/get_host_target avx512 avx512_knl avx512_skylake avx512_cannonlake`
+HL_TARGET=`${AUTOSCHED_BIN}/get_host_target avx512 avx512_knl avx512_skylake avx512_cannonlake avx512_cascadelake avx512_cooperlake avx512_sapphirerapids`
 fi
 echo Training target is: ${HL_TARGET}
 
@@ -1,10 +1,29 @@
 #include "Halide.h"
 
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+
 using namespace Halide;
 
+// The schedules of all the pipelines below, in order.
+std::string schedules;
+
+void auto_schedule(Pipeline p, const Target &target, const MachineParams &params) {
+    schedules += p.auto_schedule(target, params).schedule_source;
+}
+
+void set_env(const char *name, const char *value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
 int main(int argc, char **argv) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s <autoscheduler-lib>\n", argv[0]);
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "Usage: %s <autoscheduler-lib> [schedule-output-file]\n", argv[0]);
         return 1;
     }
 
@@ -25,7 +44,7 @@ int main(int argc, char **argv) {
 
         h.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
 
-        Pipeline(h).auto_schedule(target, params);
+        auto_schedule(Pipeline(h), target, params);
     }
 
     if (1) {
@@ -45,7 +64,7 @@ int main(int argc, char **argv) {
 
         h.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
 
-        Pipeline(h).auto_schedule(target, params);
+        auto_schedule(Pipeline(h), target, params);
     }
 
     if (1) {
@@ -58,7 +77,7 @@ int main(int argc, char **argv) {
 
         h.set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
 
-        Pipeline(h).auto_schedule(target, params);
+        auto_schedule(Pipeline(h), target, params);
     }
 
     // Smaller footprint stencil -> smaller tiles
@@ -71,7 +90,7 @@ int main(int argc, char **argv) {
 
         h.set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
 
-        Pipeline(h).auto_schedule(target, params);
+        auto_schedule(Pipeline(h), target, params);
     }
 
     // A stencil chain
@@ -90,7 +109,7 @@ int main(int argc, char **argv) {
         }
         f[N - 1].set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
 
-        Pipeline(f[N - 1]).auto_schedule(target, params);
+        auto_schedule(Pipeline(f[N - 1]), target, params);
     }
 
     // An outer product
@@ -101,7 +120,7 @@ int main(int argc, char **argv) {
 
         f.set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
 
-        Pipeline(f).auto_schedule(target, params);
+        auto_schedule(Pipeline(f), target, params);
     }
 
     // A separable downsample that models the start of local_laplacian
@@ -120,7 +139,7 @@ int main(int argc, char **argv) {
         downx(x, y, k) = downy(2 * x - 1, y, k) + downy(2 * x, y, k) + downy(2 * x + 1, y, k) + downy(2 * x + 2, y, k);
         downx.set_estimate(x, 1, 1022).set_estimate(y, 1, 1022).set_estimate(k, 0, 256);
 
-        Pipeline(downx).auto_schedule(target, params);
+        auto_schedule(Pipeline(downx), target, params);
     }
 
     // A Func with multiple stages, some of which include additional loops
@@ -139,7 +158,7 @@ int main(int argc, char **argv) {
 
         g.set_estimate(x, 1, 1022).set_estimate(y, 1, 1022);
 
-        Pipeline(g).auto_schedule(target, params);
+        auto_schedule(Pipeline(g), target, params);
     }
 
     if (1) {
@@ -163,7 +182,7 @@ int main(int argc, char **argv) {
 
         after[4].set_estimate(x, 0, 1024).set_estimate(y, 0, 1024);
 
-        Pipeline(after[4]).auto_schedule(target, params);
+        auto_schedule(Pipeline(after[4]), target, params);
     }
 
     if (1) {
@@ -183,7 +202,7 @@ int main(int argc, char **argv) {
 
         f_u64_2.set_estimate(x, 0, 1024 * 1024);
 
-        Pipeline(f_u64_2).auto_schedule(target, params);
+        auto_schedule(Pipeline(f_u64_2), target, params);
     }
 
     if (1) {
@@ -202,7 +221,7 @@ int main(int argc, char **argv) {
 
         out.set_estimate(j, 0, 1024).set_estimate(i, 0, 1024);
 
-        Pipeline(out).auto_schedule(target, params);
+        auto_schedule(Pipeline(out), target, params);
     }
 
     if (1) {
@@ -232,7 +251,7 @@ int main(int argc, char **argv) {
 
         p3[N - 1].set_estimate(x, 0, 1024).set_estimate(y, 0, 1024);
 
-        Pipeline(p3[N - 1]).auto_schedule(target, params);
+        auto_schedule(Pipeline(p3[N - 1]), target, params);
     }
 
     if (1) {
@@ -252,7 +271,7 @@ int main(int argc, char **argv) {
 
         out.set_estimate(x, 0, 10);
 
-        Pipeline(out).auto_schedule(target, params);
+        auto_schedule(Pipeline(out), target, params);
     }
 
     if (1) {
@@ -267,7 +286,7 @@ int main(int argc, char **argv) {
 
         g.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
 
-        Pipeline(g).auto_schedule(target, params);
+        auto_schedule(Pipeline(g), target, params);
     }
 
     if (1) {
@@ -282,7 +301,7 @@ int main(int argc, char **argv) {
 
         h.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
 
-        Pipeline(h).auto_schedule(target, params);
+        auto_schedule(Pipeline(h), target, params);
     }
 
     if (1) {
@@ -300,7 +319,7 @@ int main(int argc, char **argv) {
         a.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
         b.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
 
-        Pipeline({a, b}).auto_schedule(target, params);
+        auto_schedule(Pipeline({a, b}), target, params);
     }
 
     if (1) {
@@ -311,7 +330,7 @@ int main(int argc, char **argv) {
         g(x, y) = f(x, y);
 
         g.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
-        Pipeline(g).auto_schedule(target, params);
+        auto_schedule(Pipeline(g), target, params);
     }
 
     if (1) {
@@ -321,7 +340,7 @@ int main(int argc, char **argv) {
         f(x, y) = im(x, y) * 7;
 
         f.set_estimate(x, 0, 3).set_estimate(y, 0, 5);
-        Pipeline(f).auto_schedule(target, params);
+        auto_schedule(Pipeline(f), target, params);
     }
 
     if (1) {
@@ -338,7 +357,7 @@ int main(int argc, char **argv) {
             .set_estimate(t, 0, 3)
             .set_estimate(u, 0, 2)
             .set_estimate(v, 0, 6);
-        Pipeline(f).auto_schedule(target, params);
+        auto_schedule(Pipeline(f), target, params);
     }
 
     if (1) {
@@ -357,7 +376,7 @@ int main(int argc, char **argv) {
 
         out1.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
         out2.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
-        Pipeline({out1, out2}).auto_schedule(target, params);
+        auto_schedule(Pipeline({out1, out2}), target, params);
     }
 
     if (1) {
@@ -382,7 +401,7 @@ int main(int argc, char **argv) {
         g(x, y) = f[N - 1](x, y) + f[0](clamp(cast<int>(sin(x) * 10000), 0, 100000), clamp(cast<int>(sin(x * y) * 10000), 0, 100000));
         g.set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
 
-        Pipeline(g).auto_schedule(target, params);
+        auto_schedule(Pipeline(g), target, params);
     }
 
     if (1) {
@@ -396,7 +415,7 @@ int main(int argc, char **argv) {
         h(x, y) = g() + x + y;
 
         h.set_estimate(x, 0, 1024).set_estimate(y, 0, 2048);
-        Pipeline(h).auto_schedule(target, params);
+        auto_schedule(Pipeline(h), target, params);
     }
 
     if (1) {
@@ -411,7 +430,7 @@ int main(int argc, char **argv) {
         g(x, y) = f(x, y);
 
         g.set_estimate(x, 0, 10).set_estimate(y, 0, 2048);
-        Pipeline(g).auto_schedule(target, params);
+        auto_schedule(Pipeline(g), target, params);
     }
 
     if (1) {
@@ -443,7 +462,7 @@ int main(int argc, char **argv) {
         out(x, y) = up[0](x, y);
 
         out.set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
-        Pipeline(out).auto_schedule(target, params);
+        auto_schedule(Pipeline(out), target, params);
     }
 
     if (1) {
@@ -461,7 +480,7 @@ int main(int argc, char **argv) {
         casted(x, y) = scan(x, y);
 
         casted.set_estimate(x, 0, 2000).set_estimate(y, 0, 2000);
-        Pipeline(casted).auto_schedule(target, params);
+        auto_schedule(Pipeline(casted), target, params);
     }
 
     if (1) {
@@ -477,7 +496,37 @@ int main(int argc, char **argv) {
 
         f.set_estimate(x, 0, 2000).set_estimate(y, 0, 2000);
         output.set_estimate(i, 0, 256);
-        Pipeline(output).auto_schedule(target, params);
+        auto_schedule(Pipeline(output), target, params);
+    }
+
+    if (argc == 3) {
+        std::ofstream out(argv[2]);
+        out << schedules;
+        return out.good() ? 0 : 1;
+    }
+
+    // The featurization reuses the features of parts of the loop nest
+    // that haven't changed since the last time they were featurized.
+    // Check that turning that off, or recomputing the reused features
+    // and checking they match, gives the same schedules.
+    for (const char *flag : {"HL_NO_FEATURE_MEMOS", "HL_CHECK_FEATURE_MEMOS"}) {
+        std::string file = std::string(argv[0]) + "." + flag + ".schedule";
+        set_env(flag, "1");
+        std::string cmd = std::string("\"") + argv[0] + "\" \"" + argv[1] + "\" \"" + file + "\"";
+        int result = system(cmd.c_str());
+        set_env(flag, "");
+        if (result != 0) {
+            fprintf(stderr, "Autoscheduling with %s=1 failed\n", flag);
+            return 1;
+        }
+        std::ifstream in(file);
+        std::stringstream other;
+        other << in.rdbuf();
+        if (other.str() != schedules) {
+            fprintf(stderr, "Autoscheduling with %s=1 gave different schedules:\n%s\ninstead of:\n%s\n",
+                    flag, other.str().c_str(), schedules.c_str());
+            return 1;
+        }
     }
 
     return 0;
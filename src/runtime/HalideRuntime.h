@@ -333,6 +333,33 @@ extern void halide_join_thread(struct halide_thread *);
  */
 extern int halide_set_num_threads(int n);
 
+/** Enable or disable the work-stealing scheduler in Halide's thread
+ * pool. When enabled, the iterations of parallel loops that cannot
+ * block are split up front into one contiguous range per worker, and
+ * idle workers steal half of another worker's remaining range instead
+ * of claiming iterations one at a time under the global work queue
+ * lock. Returns the old setting. By default this is controlled by the
+ * HL_WORK_STEALING environment variable. (Only meaningful when using
+ * the default implementations of halide_do_par_for() and
+ * halide_do_parallel_tasks().)
+ */
+extern bool halide_set_work_stealing(bool enabled);
+
+/** Enable or disable pinning of Halide's worker threads to cpus. When
+ * enabled, workers are pinned one per cpu with the cpus grouped by NUMA
+ * node, and parallel loops that cannot block are split into contiguous
+ * blocks of iterations that always go to the same workers. Repeated
+ * runs over the same buffers then touch each block of memory from the
+ * node that first touched it, and idle workers steal from workers on
+ * their own node before crossing to another one. Only takes effect
+ * when the thread pool is next started, so call it before running any
+ * pipelines or after halide_shutdown_thread_pool(). Returns the old
+ * setting. By default this is controlled by the HL_THREAD_AFFINITY
+ * environment variable. Currently only supported on Linux and
+ * Android; elsewhere it has no effect.
+ */
+extern bool halide_set_thread_affinity(bool enabled);
+
 /** Halide calls these functions to allocate and free memory. To
  * replace in AOT code, use the halide_set_custom_malloc and
  * halide_set_custom_free, or (on platforms that support weak
@@ -361,6 +388,39 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** Enable or disable pooling of the host allocations made by
+ * halide_default_malloc. When enabled, freed blocks are kept on free
+ * lists bucketed by size class (four classes per power of two), and
+ * handed back out by later allocations of the same class instead of
+ * being returned to the system allocator. This saves repeated
+ * malloc/free and page faults for pipelines that run many times with
+ * intermediates of the same sizes. Free lists are sharded by calling
+ * thread, so parallel loops that allocate per iteration don't contend
+ * on a lock. Cached blocks are only released by
+ * halide_trim_host_allocation_pool, or by disabling pooling again.
+ * Has no effect on allocations made by a custom malloc. Returns the
+ * old setting. By default this is controlled by the
+ * HL_HOST_ALLOCATION_POOLING environment variable.
+ */
+extern bool halide_set_host_allocation_pooling(bool enabled);
+
+/** Release blocks cached by the host allocation pool, biggest first,
+ * until it holds at most max_cached_bytes. */
+extern void halide_trim_host_allocation_pool(void *user_context, uint64_t max_cached_bytes);
+
+/** Statistics about the host allocation pool. */
+struct halide_host_allocation_pool_stats {
+    /** The number of pooled allocations made, and how many of them
+     * reused a cached block. */
+    uint64_t allocations, hits;
+
+    /** The number of blocks currently cached, and their total size. */
+    uint64_t cached_blocks, cached_bytes;
+};
+
+/** Get statistics about the host allocation pool. */
+extern void halide_get_host_allocation_pool_stats(void *user_context, struct halide_host_allocation_pool_stats *stats);
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -871,6 +931,52 @@ extern int halide_get_gpu_device(void *user_context);
  */
 extern void halide_memoization_cache_set_size(int64_t size);
 
+/** The policies the default memoization cache can use to choose which
+ * unused entry to evict when it is over its size limit. */
+typedef enum halide_memoization_cache_eviction_policy_t {
+    /** Evict the least recently used entry. The default. */
+    halide_memoization_cache_evict_lru = 0,
+    /** Evict the entry that is cheapest to recompute per byte, with
+     * entries that go unused aging out over time (the GreedyDual-Size
+     * algorithm). The recompute cost of an entry is measured as the
+     * time between the lookup that missed and the store. */
+    halide_memoization_cache_evict_cost_aware = 1,
+} halide_memoization_cache_eviction_policy_t;
+
+/** Set the eviction policy used by the default memoization cache. */
+extern void halide_memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy);
+
+/** Counters describing the behavior of the default memoization cache
+ * since it was created or last cleaned up. */
+struct halide_memoization_cache_stats_t {
+    uint64_t hits, misses, evictions;
+    /** The number of entries currently in the cache. */
+    uint64_t entries;
+    /** The number of bytes currently cached, and the soft maximum set
+     * by halide_memoization_cache_set_size. */
+    int64_t current_size, max_size;
+    /** The number of lookups satisfied from the disk tier (these are
+     * also counted as hits), and the number of entries written to it. */
+    uint64_t disk_hits, disk_stores;
+    /** The number of bytes in the disk tier, and its maximum, which is
+     * zero if there is no disk tier. */
+    int64_t disk_size, disk_max_size;
+};
+
+/** Fill in the current statistics of the default memoization cache. */
+extern void halide_memoization_cache_get_stats(struct halide_memoization_cache_stats_t *stats);
+
+/** Give the default memoization cache a second tier on disk. Entries
+ * evicted from memory, and any still cached when the cache is cleaned
+ * up (e.g. at exit), are written to checksummed files in the given
+ * directory, and a lookup that misses in memory maps them back in
+ * without copying. This lets a process restart with a warm cache. At
+ * most max_size bytes of files are kept, removing the least recently
+ * used first. Pass a null directory to turn the disk tier off and
+ * remove its files. Returns zero on success, or an error code
+ * if files can't be created or mapped in the directory. */
+extern int halide_memoization_cache_set_disk_tier(const char *directory, int64_t max_size);
+
 /** Given a cache key for a memoized result, currently constructed
  *  from the Func name and top-level Func name plus the arguments of
  *  the computation, determine if the result is in the cache and
@@ -1325,6 +1431,11 @@ typedef enum halide_target_feature_t {
     halide_target_feature_arm_dot_prod,           ///< Enable ARMv8.2-a dotprod extension (i.e. udot and sdot instructions)
     halide_llvm_large_code_model,                 ///< Use the LLVM large code model to compile
     halide_target_feature_rvv,                    ///< Enable RISCV "V" Vector Extension
+    halide_target_feature_profile_events,         ///< Like halide_target_feature_profile, but also record per-thread timelines of Func execution and heap usage. See halide_profiler_write_trace_events.
+    halide_target_feature_avx512_cascadelake,     ///< Enable the AVX512 features supported by Cascade Lake Xeon server processors. This adds AVX512-VNNI to the Skylake features.
+    halide_target_feature_avx512_cooperlake,      ///< Enable the AVX512 features supported by Cooper Lake Xeon server processors. This adds AVX512-BF16 to the Cascade Lake features.
+    halide_target_feature_avx512_sapphirerapids,  ///< Enable the AVX512 features supported by Sapphire Rapids Xeon server processors. This includes all of the Cooper Lake and Cannonlake features, plus AVX512-VBMI2, AVX512-BITALG and AVX512-VPOPCNTDQ.
+    halide_target_feature_auto_prefetch,          ///< Insert software prefetches ahead of strided loads in innermost serial loops, at a distance chosen from the cost of the loop body.
     halide_target_feature_end                     ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
@@ -1803,7 +1914,8 @@ extern struct halide_profiler_state *halide_profiler_get_state();
 extern struct halide_profiler_pipeline_stats *halide_profiler_get_pipeline_state(const char *pipeline_name);
 
 /** Reset profiler state cheaply. May leave threads running or some
- * memory allocated but all accumluated statistics are reset.
+ * memory allocated but all accumluated statistics are reset. Frees
+ * the per-thread buffers used to record profiler events.
  * WARNING: Do NOT call this method while any halide pipeline is
  * running; halide_profiler_memory_allocate/free and
  * halide_profiler_stack_peak_update update the profiler pipeline's
@@ -1818,9 +1930,22 @@ extern void halide_profiler_reset();
 void halide_profiler_shutdown();
 
 /** Print out timing statistics for everything run since the last
- * reset. Also happens at process exit. */
+ * reset. Also happens at process exit. If any pipelines compiled with
+ * halide_target_feature_profile_events have run, this also writes
+ * their trace events to the file named by the environment variable
+ * HL_PROFILER_TRACE_FILE, or halide_profiler_trace.json by default. */
 extern void halide_profiler_report(void *user_context);
 
+/** Write the events recorded since the last reset by pipelines
+ * compiled with halide_target_feature_profile_events to a file, in the
+ * Chrome trace event JSON format (which the Perfetto UI also
+ * reads). Each thread gets a timeline showing which Func it was
+ * working on, and when it was idle or waiting. Only the most recent
+ * events of each thread are kept. Returns zero on success.
+ * WARNING: Do NOT call this method while any halide pipeline is
+ * running. */
+extern int halide_profiler_write_trace_events(void *user_context, const char *filename);
+
 /// \name "Float16" functions
 /// These functions operate of bits (``uint16_t``) representing a half
 /// precision floating point number (IEEE-754 2008 binary16).
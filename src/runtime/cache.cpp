@@ -82,6 +82,19 @@ struct CacheEntry {
     halide_dimension_t *computed_bounds;
     // The actual stored data.
     halide_buffer_t *buf;
+    // The total size in bytes of the tuple buffers.
+    uint64_t size;
+    // How long the entry took to compute, in nanoseconds, measured from
+    // the lookup that missed to the store. Only tracked by the
+    // cost-aware eviction policy.
+    uint64_t cost;
+    // The GreedyDual-Size priority used by the cost-aware eviction
+    // policy. The unused entry with the lowest priority is evicted first.
+    double priority;
+    // If the entry was loaded from the disk tier, the file mapping that
+    // backs the tuple buffers, which is unmapped instead of freeing them.
+    void *mapping;
+    size_t mapping_size;
 
     bool init(const uint8_t *cache_key, size_t cache_key_size,
               uint32_t key_hash,
@@ -94,6 +107,9 @@ struct CacheEntry {
 struct CacheBlockHeader {
     CacheEntry *entry;
     uint32_t hash;
+    // When the lookup that missed happened, if the eviction policy
+    // needs to know how expensive entries are to recompute.
+    int64_t miss_time;
 };
 
 // Each host block has extra space to store a header just before the
@@ -122,6 +138,11 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
     in_use_count = 0;
     tuple_count = tuples;
     dimensions = computed_bounds_buf->dimensions;
+    size = 0;
+    cost = 0;
+    priority = 0;
+    mapping = nullptr;
+    mapping_size = 0;
 
     // Allocate all the necessary space (or die)
     size_t storage_bytes = 0;
@@ -166,6 +187,7 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
         for (int j = 0; j < dimensions; j++) {
             buf[i].dim[j] = tuple_buffers[i]->dim[j];
         }
+        size += buf[i].size_in_bytes();
     }
     return true;
 }
@@ -173,7 +195,12 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
 WEAK void CacheEntry::destroy() {
     for (uint32_t i = 0; i < tuple_count; i++) {
         halide_device_free(nullptr, &buf[i]);
-        halide_free(nullptr, get_pointer_to_header(buf[i].host));
+        if (mapping == nullptr) {
+            halide_free(nullptr, get_pointer_to_header(buf[i].host));
+        }
+    }
+    if (mapping != nullptr) {
+        halide_unmap_file(mapping, mapping_size);
     }
     halide_free(nullptr, metadata_storage);
 }
@@ -186,34 +213,484 @@ WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size) {
     return h;
 }
 
-WEAK halide_mutex memoization_lock = {{0}};
+// The cache is split into shards by key hash, each with its own lock,
+// hash table and recency list, so that threads looking up unrelated
+// keys don't serialize. The size limit is global across all shards.
+const size_t kNumShards = 16;
+const size_t kHashTableSize = 32;
+
+struct CacheShard {
+    halide_mutex lock;
+
+    CacheEntry *entries[kHashTableSize];
 
-const size_t kHashTableSize = 256;
+    CacheEntry *most_recently_used;
+    CacheEntry *least_recently_used;
 
-WEAK CacheEntry *cache_entries[kHashTableSize];
+    uint64_t num_entries;
+    uint64_t hits, misses, evictions;
+};
+
+WEAK CacheShard cache_shards[kNumShards];
+
+// The low bits of the hash pick the shard, and the remaining bits pick
+// the bucket within the shard.
+ALWAYS_INLINE CacheShard &shard_for_hash(uint32_t h) {
+    return cache_shards[h % kNumShards];
+}
 
-WEAK CacheEntry *most_recently_used = nullptr;
-WEAK CacheEntry *least_recently_used = nullptr;
+ALWAYS_INLINE uint32_t bucket_for_hash(uint32_t h) {
+    return (h / kNumShards) % kHashTableSize;
+}
 
 const uint64_t kDefaultCacheSize = 1 << 20;
 WEAK int64_t max_cache_size = kDefaultCacheSize;
+// Updated atomically, as it is shared by all the shards.
 WEAK int64_t current_cache_size = 0;
 
+WEAK halide_memoization_cache_eviction_policy_t eviction_policy = halide_memoization_cache_evict_lru;
+
+ALWAYS_INLINE int64_t add_to_cache_size(int64_t delta) {
+    return __atomic_add_fetch(&current_cache_size, delta, __ATOMIC_RELAXED);
+}
+
+ALWAYS_INLINE bool cache_over_budget() {
+    return __atomic_load_n(&current_cache_size, __ATOMIC_RELAXED) >
+           __atomic_load_n(&max_cache_size, __ATOMIC_RELAXED);
+}
+
+// The GreedyDual-Size inflation value: the priority of the most
+// recently evicted entry. New and reused entries get priorities
+// relative to this, so entries that aren't reused age out. Victims are
+// chosen across all the shards, so this is shared by all of them, and
+// is kept as the bits of a double so that it can be accessed
+// atomically.
+WEAK uint64_t inflation_bits = 0;
+
+ALWAYS_INLINE double get_inflation() {
+    union {
+        uint64_t bits;
+        double value;
+    } u;
+    u.bits = __atomic_load_n(&inflation_bits, __ATOMIC_RELAXED);
+    return u.value;
+}
+
+ALWAYS_INLINE void set_inflation(double value) {
+    union {
+        uint64_t bits;
+        double value;
+    } u;
+    u.value = value;
+    __atomic_store_n(&inflation_bits, u.bits, __ATOMIC_RELAXED);
+}
+
+// The priority an entry gets when it is stored or hit: its cost to
+// recompute per byte of cache it occupies, on top of the inflation
+// value.
+ALWAYS_INLINE double entry_priority(const CacheEntry *entry) {
+    return get_inflation() + (double)entry->cost / (double)(entry->size + 1);
+}
+
+// The optional disk tier holds entries evicted from memory in files,
+// one per slot, and maps them back in on a lookup that misses in
+// memory. Slots are picked by key hash, so a slot holds at most one
+// entry and the directory never has more than kDiskSlots files in it.
+const size_t kDiskSlots = 1024;
+const size_t kMaxDiskPath = 1024;
+// "HLMEMC01"
+const uint64_t kDiskMagic = 0x3130434d454d4c48ULL;
+// The tuple data in a file is aligned to this, which is at least the
+// alignment of halide_malloc on any target, and has at least this much
+// space before it for the CacheBlockHeader.
+const uint64_t kDiskDataAlignment = 128;
+
+struct DiskTier {
+    halide_mutex lock;
+    bool enabled;
+    char directory[kMaxDiskPath];
+    int64_t max_size, current_size;
+    // The size of the file in each slot, or zero if there is none.
+    uint64_t slot_size[kDiskSlots];
+    // When each slot was last stored or hit, for picking which file
+    // to remove when the directory is over its size limit.
+    uint64_t slot_last_use[kDiskSlots];
+    // Whether the file in each slot was written by this process or has
+    // already passed its checksum, so that the checksum, which reads the
+    // whole file, is only computed the first time a file is mapped.
+    bool slot_verified[kDiskSlots];
+    uint64_t clock;
+    uint64_t hits, stores;
+};
+
+WEAK DiskTier disk_tier;
+
+// A file starts with this header, followed by the computed bounds, a
+// DiskTupleHeader and the shape of each tuple buffer, the key, and
+// then the data of each tuple buffer. Every part is padded to a
+// multiple of eight bytes.
+struct DiskEntryHeader {
+    uint64_t magic;
+    // Of everything in the file after this header.
+    uint64_t checksum;
+    uint64_t file_size;
+    uint64_t cost;
+    uint32_t key_size;
+    int32_t tuple_count;
+    int32_t dimensions;
+    int32_t padding;
+};
+
+struct DiskTupleHeader {
+    halide_type_t type;
+    int32_t padding;
+    uint64_t data_offset;
+    uint64_t data_size;
+};
+
+WEAK uint64_t fnv_hash(const uint8_t *key, size_t key_size) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < key_size; i++) {
+        h = (h ^ key[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// The checksum is FNV-1a over eight-byte words, so that verifying a
+// large file costs little more than reading it.
+ALWAYS_INLINE uint64_t checksum_word(uint64_t checksum, uint64_t word) {
+    return (checksum ^ word) * 0x100000001b3ULL;
+}
+
+ALWAYS_INLINE uint64_t align_up(uint64_t x, uint64_t alignment) {
+    return (x + alignment - 1) & ~(alignment - 1);
+}
+
+WEAK uint64_t checksum_words(uint64_t checksum, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        checksum = checksum_word(checksum, word);
+    }
+    if (size % 8) {
+        uint64_t word = 0;
+        memcpy(&word, data + (size & ~(size_t)7), size % 8);
+        checksum = checksum_word(checksum, word);
+    }
+    return checksum;
+}
+
+// Lays out and checksums the body of an entry file, and writes it too
+// if given a file. Run once without a file to find the checksum and
+// size that go in the header.
+struct DiskWriter {
+    void *file;
+    uint64_t checksum;
+    uint64_t offset;
+    bool ok;
+
+    ALWAYS_INLINE DiskWriter(void *f)
+        : file(f), checksum(0xcbf29ce484222325ULL), offset(sizeof(DiskEntryHeader)), ok(true) {
+    }
+
+    void write(const void *data, size_t size) {
+        // The checksum already pads the last word with zeros.
+        checksum = checksum_words(checksum, (const uint8_t *)data, size);
+        size_t padding = align_up(size, 8) - size;
+        if (file && ok) {
+            const uint64_t zero = 0;
+            ok = halide_write_file(file, data, size) &&
+                 halide_write_file(file, &zero, padding);
+        }
+        offset += size + padding;
+    }
+
+    void pad_to(uint64_t new_offset) {
+        const uint64_t zeros[8] = {0};
+        while (offset < new_offset) {
+            size_t n = new_offset - offset;
+            if (n > sizeof(zeros)) {
+                n = sizeof(zeros);
+            }
+            checksum = checksum_words(checksum, (const uint8_t *)zeros, n);
+            if (file && ok) {
+                ok = halide_write_file(file, zeros, n);
+            }
+            offset += n;
+        }
+    }
+
+    void write_body(const CacheEntry *entry) {
+        write(entry->computed_bounds, sizeof(halide_dimension_t) * entry->dimensions);
+        uint64_t data_offset = offset +
+                               sizeof(DiskTupleHeader) * entry->tuple_count +
+                               sizeof(halide_dimension_t) * entry->dimensions * entry->tuple_count +
+                               align_up(entry->key_size, 8);
+        for (uint32_t i = 0; i < entry->tuple_count; i++) {
+            DiskTupleHeader t = {};
+            t.type = entry->buf[i].type;
+            t.data_size = entry->buf[i].size_in_bytes();
+            t.data_offset = align_up(data_offset + kDiskDataAlignment, kDiskDataAlignment);
+            data_offset = align_up(t.data_offset + t.data_size, 8);
+            write(&t, sizeof(t));
+        }
+        for (uint32_t i = 0; i < entry->tuple_count; i++) {
+            write(entry->buf[i].dim, sizeof(halide_dimension_t) * entry->dimensions);
+        }
+        write(entry->key, entry->key_size);
+        for (uint32_t i = 0; i < entry->tuple_count; i++) {
+            pad_to(align_up(offset + kDiskDataAlignment, kDiskDataAlignment));
+            write(entry->buf[i].host, entry->buf[i].size_in_bytes());
+        }
+    }
+};
+
+WEAK void disk_slot_path(char *dst, size_t slot) {
+    char *end = dst + kMaxDiskPath;
+    dst = halide_string_to_string(dst, end, disk_tier.directory);
+    dst = halide_string_to_string(dst, end, "/halide_memoization_");
+    halide_uint64_to_string(dst, end, slot, 4);
+}
+
+WEAK void remove_disk_slot_already_locked(size_t slot) {
+    char path[kMaxDiskPath];
+    disk_slot_path(path, slot);
+    halide_remove_file(path);
+    disk_tier.current_size -= disk_tier.slot_size[slot];
+    disk_tier.slot_size[slot] = 0;
+    disk_tier.slot_verified[slot] = false;
+}
+
+// Remove the least recently used files, other than the given slot's,
+// until there is room for the given number of bytes.
+WEAK void make_room_in_disk_tier_already_locked(uint64_t bytes, size_t keep_slot) {
+    while (disk_tier.current_size + (int64_t)bytes > disk_tier.max_size) {
+        size_t victim = kDiskSlots;
+        for (size_t i = 0; i < kDiskSlots; i++) {
+            if (i != keep_slot && disk_tier.slot_size[i] != 0 &&
+                (victim == kDiskSlots || disk_tier.slot_last_use[i] < disk_tier.slot_last_use[victim])) {
+                victim = i;
+            }
+        }
+        if (victim == kDiskSlots) {
+            return;
+        }
+        remove_disk_slot_already_locked(victim);
+    }
+}
+
+// Write an entry that is no longer in the in-memory cache to the disk
+// tier. Entries that came from the disk tier are already there.
+WEAK void spill_to_disk_tier(const CacheEntry *entry) {
+    if (!__atomic_load_n(&disk_tier.enabled, __ATOMIC_RELAXED) || entry->mapping != nullptr) {
+        return;
+    }
+    for (uint32_t i = 0; i < entry->tuple_count; i++) {
+        // Only dense host allocations made by the cache can be mapped
+        // back in.
+        const halide_buffer_t &b = entry->buf[i];
+        if (b.host == nullptr || b.device_dirty() || b.host != b.begin()) {
+            return;
+        }
+    }
+
+    DiskWriter sizer(nullptr);
+    sizer.write_body(entry);
+
+    DiskEntryHeader header = {};
+    header.magic = kDiskMagic;
+    header.checksum = sizer.checksum;
+    header.file_size = sizer.offset;
+    header.cost = entry->cost;
+    header.key_size = entry->key_size;
+    header.tuple_count = entry->tuple_count;
+    header.dimensions = entry->dimensions;
+
+    ScopedMutexLock lock(&disk_tier.lock);
+    if (!disk_tier.enabled || (int64_t)header.file_size > disk_tier.max_size) {
+        return;
+    }
+
+    size_t slot = fnv_hash(entry->key, entry->key_size) % kDiskSlots;
+    remove_disk_slot_already_locked(slot);
+    make_room_in_disk_tier_already_locked(header.file_size, slot);
+
+    char path[kMaxDiskPath];
+    disk_slot_path(path, slot);
+    void *file = halide_create_file(path);
+    if (!file) {
+        return;
+    }
+    DiskWriter writer(file);
+    writer.ok = halide_write_file(file, &header, sizeof(header));
+    writer.write_body(entry);
+    halide_close_file(file);
+    if (!writer.ok) {
+        halide_remove_file(path);
+        return;
+    }
+
+    disk_tier.slot_size[slot] = header.file_size;
+    disk_tier.slot_last_use[slot] = ++disk_tier.clock;
+    disk_tier.slot_verified[slot] = true;
+    disk_tier.current_size += header.file_size;
+    disk_tier.stores++;
+}
+
+// Check that a mapped file is an intact entry for the given lookup,
+// and return its tuple headers if so. The checksum is only checked if
+// verify is set. Sets corrupt if the file should be removed.
+WEAK const DiskTupleHeader *validate_disk_entry(const uint8_t *base, size_t mapped_size,
+                                                const uint8_t *cache_key, int32_t size,
+                                                const halide_buffer_t *computed_bounds,
+                                                int32_t tuple_count, halide_buffer_t **tuple_buffers,
+                                                bool verify, bool *corrupt) {
+    const DiskEntryHeader *header = (const DiskEntryHeader *)base;
+    *corrupt = true;
+    if (mapped_size < sizeof(DiskEntryHeader) ||
+        header->magic != kDiskMagic ||
+        header->file_size != mapped_size ||
+        mapped_size % 8 != 0) {
+        return nullptr;
+    }
+
+    // From here on the file may still be for some other key or shape,
+    // which is cheap to check, so do that before the checksum.
+    *corrupt = false;
+    int dimensions = computed_bounds->dimensions;
+    if (header->key_size != (uint32_t)size ||
+        header->tuple_count != tuple_count ||
+        header->dimensions != dimensions) {
+        return nullptr;
+    }
+    const halide_dimension_t *bounds = (const halide_dimension_t *)(base + sizeof(DiskEntryHeader));
+    const DiskTupleHeader *tuples = (const DiskTupleHeader *)(bounds + dimensions);
+    const halide_dimension_t *shapes = (const halide_dimension_t *)(tuples + tuple_count);
+    const uint8_t *key = (const uint8_t *)(shapes + dimensions * tuple_count);
+    if (key + size > base + mapped_size ||
+        !keys_equal(key, cache_key, size) ||
+        !buffer_has_shape(computed_bounds, bounds)) {
+        return nullptr;
+    }
+    for (int32_t i = 0; i < tuple_count; i++) {
+        const halide_buffer_t *b = tuple_buffers[i];
+        if (tuples[i].type != b->type ||
+            !buffer_has_shape(b, shapes + i * dimensions) ||
+            tuples[i].data_size != b->size_in_bytes() ||
+            tuples[i].data_offset % kDiskDataAlignment != 0 ||
+            tuples[i].data_offset + tuples[i].data_size > mapped_size) {
+            *corrupt = true;
+            return nullptr;
+        }
+    }
+    if (verify &&
+        header->checksum != checksum_words(0xcbf29ce484222325ULL, base + sizeof(DiskEntryHeader),
+                                           mapped_size - sizeof(DiskEntryHeader))) {
+        *corrupt = true;
+        return nullptr;
+    }
+    return tuples;
+}
+
+// Look for an entry in the disk tier, and if it is there make a new
+// cache entry whose tuple buffers point straight into the mapped file,
+// and fill in the tuple buffers from it.
+WEAK CacheEntry *load_from_disk_tier(const uint8_t *cache_key, int32_t size, uint32_t h,
+                                     const halide_buffer_t *computed_bounds,
+                                     int32_t tuple_count, halide_buffer_t **tuple_buffers) {
+    size_t slot = fnv_hash(cache_key, size) % kDiskSlots;
+    uint8_t *base = nullptr;
+    size_t mapped_size = 0;
+    uint64_t cost = 0;
+    const DiskTupleHeader *tuples = nullptr;
+    {
+        ScopedMutexLock lock(&disk_tier.lock);
+        if (!disk_tier.enabled || disk_tier.slot_size[slot] == 0) {
+            return nullptr;
+        }
+        char path[kMaxDiskPath];
+        disk_slot_path(path, slot);
+        base = (uint8_t *)halide_map_file(path, &mapped_size);
+        if (base == nullptr) {
+            disk_tier.current_size -= disk_tier.slot_size[slot];
+            disk_tier.slot_size[slot] = 0;
+            disk_tier.slot_verified[slot] = false;
+            return nullptr;
+        }
+        bool corrupt = false;
+        tuples = validate_disk_entry(base, mapped_size, cache_key, size, computed_bounds,
+                                     tuple_count, tuple_buffers, !disk_tier.slot_verified[slot], &corrupt);
+        if (tuples == nullptr) {
+            halide_unmap_file(base, mapped_size);
+            if (corrupt) {
+                remove_disk_slot_already_locked(slot);
+            }
+            return nullptr;
+        }
+        cost = ((const DiskEntryHeader *)base)->cost;
+        disk_tier.slot_last_use[slot] = ++disk_tier.clock;
+        disk_tier.slot_verified[slot] = true;
+        disk_tier.hits++;
+    }
+
+    for (int32_t i = 0; i < tuple_count; i++) {
+        tuple_buffers[i]->host = base + tuples[i].data_offset;
+    }
+
+    CacheEntry *entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
+    if (entry == nullptr || !entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers)) {
+        for (int32_t i = 0; i < tuple_count; i++) {
+            tuple_buffers[i]->host = nullptr;
+        }
+        if (entry) {
+            halide_free(nullptr, entry);
+        }
+        halide_unmap_file(base, mapped_size);
+        return nullptr;
+    }
+    entry->mapping = base;
+    entry->mapping_size = mapped_size;
+    entry->cost = cost;
+
+    // The mapping is private, so writing the headers only copies the
+    // pages they are on.
+    for (int32_t i = 0; i < tuple_count; i++) {
+        CacheBlockHeader *header = get_pointer_to_header(tuple_buffers[i]->host);
+        header->entry = entry;
+        header->hash = h;
+        header->miss_time = 0;
+    }
+    return entry;
+}
+
+// Spill entries that have been evicted from memory to the disk tier,
+// if there is one, and free them. Must be called with no shard locks
+// held, as writing the files can take a while.
+WEAK void retire_entries(CacheEntry *entries) {
+    while (entries != nullptr) {
+        CacheEntry *next = entries->next;
+        spill_to_disk_tier(entries);
+        entries->destroy();
+        halide_free(nullptr, entries);
+        entries = next;
+    }
+}
+
 #if CACHE_DEBUGGING
-WEAK void validate_cache() {
-    print(nullptr) << "validating cache, "
+WEAK void validate_shard(const CacheShard &shard) {
+    print(nullptr) << "validating cache shard, "
                    << "current size " << current_cache_size
                    << " of maximum " << max_cache_size << "\n";
     int entries_in_hash_table = 0;
     for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
+        CacheEntry *entry = shard.entries[i];
         while (entry != nullptr) {
             entries_in_hash_table++;
-            if (entry->more_recent == nullptr && entry != most_recently_used) {
+            if (entry->more_recent == nullptr && entry != shard.most_recently_used) {
                 halide_print(nullptr, "cache invalid case 1\n");
                 __builtin_trap();
             }
-            if (entry->less_recent == nullptr && entry != least_recently_used) {
+            if (entry->less_recent == nullptr && entry != shard.least_recently_used) {
                 halide_print(nullptr, "cache invalid case 2\n");
                 __builtin_trap();
             }
@@ -221,13 +698,13 @@ WEAK void validate_cache() {
         }
     }
     int entries_from_mru = 0;
-    CacheEntry *mru_chain = most_recently_used;
+    CacheEntry *mru_chain = shard.most_recently_used;
     while (mru_chain != nullptr) {
         entries_from_mru++;
         mru_chain = mru_chain->less_recent;
     }
     int entries_from_lru = 0;
-    CacheEntry *lru_chain = least_recently_used;
+    CacheEntry *lru_chain = shard.least_recently_used;
     while (lru_chain != nullptr) {
         entries_from_lru++;
         lru_chain = lru_chain->more_recent;
@@ -243,6 +720,10 @@ WEAK void validate_cache() {
         halide_print(nullptr, "cache invalid case 4\n");
         __builtin_trap();
     }
+    if ((uint64_t)entries_in_hash_table != shard.num_entries) {
+        halide_print(nullptr, "cache invalid case 5\n");
+        __builtin_trap();
+    }
     if (current_cache_size < 0) {
         halide_print(nullptr, "cache size is negative\n");
         __builtin_trap();
@@ -250,64 +731,167 @@ WEAK void validate_cache() {
 }
 #endif
 
-WEAK void prune_cache() {
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-    CacheEntry *prune_candidate = least_recently_used;
-    while (current_cache_size > max_cache_size &&
-           prune_candidate != nullptr) {
-        CacheEntry *more_recent = prune_candidate->more_recent;
-
-        if (prune_candidate->in_use_count == 0) {
-            uint32_t h = prune_candidate->hash;
-            uint32_t index = h % kHashTableSize;
-
-            // Remove from hash table
-            CacheEntry *prev_hash_entry = cache_entries[index];
-            if (prev_hash_entry == prune_candidate) {
-                cache_entries[index] = prune_candidate->next;
-            } else {
-                while (prev_hash_entry != nullptr && prev_hash_entry->next != prune_candidate) {
-                    prev_hash_entry = prev_hash_entry->next;
-                }
-                halide_assert(nullptr, prev_hash_entry != nullptr);
-                prev_hash_entry->next = prune_candidate->next;
-            }
-
-            // Remove from less recent chain.
-            if (least_recently_used == prune_candidate) {
-                least_recently_used = more_recent;
-            }
-            if (more_recent != nullptr) {
-                more_recent->less_recent = prune_candidate->less_recent;
-            }
+WEAK void unlink_from_recency_list(CacheShard &shard, CacheEntry *entry) {
+    if (entry->less_recent != nullptr) {
+        entry->less_recent->more_recent = entry->more_recent;
+    } else {
+        halide_assert(nullptr, shard.least_recently_used == entry);
+        shard.least_recently_used = entry->more_recent;
+    }
+    if (entry->more_recent != nullptr) {
+        entry->more_recent->less_recent = entry->less_recent;
+    } else {
+        halide_assert(nullptr, shard.most_recently_used == entry);
+        shard.most_recently_used = entry->less_recent;
+    }
+    entry->more_recent = nullptr;
+    entry->less_recent = nullptr;
+}
 
-            // Remove from more recent chain.
-            if (most_recently_used == prune_candidate) {
-                most_recently_used = prune_candidate->less_recent;
-            }
-            if (prune_candidate->less_recent != nullptr) {
-                prune_candidate->less_recent = more_recent;
-            }
+WEAK void push_most_recently_used(CacheShard &shard, CacheEntry *entry) {
+    entry->more_recent = nullptr;
+    entry->less_recent = shard.most_recently_used;
+    if (shard.most_recently_used != nullptr) {
+        shard.most_recently_used->more_recent = entry;
+    }
+    shard.most_recently_used = entry;
+    if (shard.least_recently_used == nullptr) {
+        shard.least_recently_used = entry;
+    }
+}
 
-            // Decrease cache used amount.
-            for (uint32_t i = 0; i < prune_candidate->tuple_count; i++) {
-                current_cache_size -= prune_candidate->buf[i].size_in_bytes();
-            }
+// Pick the entry to evict from a shard according to the eviction
+// policy, or nullptr if every entry is in use.
+WEAK CacheEntry *choose_victim(const CacheShard &shard) {
+    CacheEntry *victim = nullptr;
+    for (CacheEntry *entry = shard.least_recently_used; entry != nullptr; entry = entry->more_recent) {
+        if (entry->in_use_count != 0) {
+            continue;
+        }
+        if (eviction_policy == halide_memoization_cache_evict_lru) {
+            return entry;
+        }
+        // Ties go to the least recently used entry.
+        if (victim == nullptr || entry->priority < victim->priority) {
+            victim = entry;
+        }
+    }
+    return victim;
+}
 
-            // Deallocate the entry.
-            prune_candidate->destroy();
-            halide_free(nullptr, prune_candidate);
+// Remove an entry from its shard, whose lock must be held, and add it
+// to a list for the caller to pass to retire_entries once it has
+// released the lock.
+WEAK void evict_already_locked(CacheShard &shard, CacheEntry *victim, CacheEntry **evicted) {
+    // Remove from hash table
+    uint32_t index = bucket_for_hash(victim->hash);
+    CacheEntry *prev_hash_entry = shard.entries[index];
+    if (prev_hash_entry == victim) {
+        shard.entries[index] = victim->next;
+    } else {
+        while (prev_hash_entry != nullptr && prev_hash_entry->next != victim) {
+            prev_hash_entry = prev_hash_entry->next;
         }
+        halide_assert(nullptr, prev_hash_entry != nullptr);
+        prev_hash_entry->next = victim->next;
+    }
+
+    unlink_from_recency_list(shard, victim);
+
+    if (eviction_policy == halide_memoization_cache_evict_cost_aware) {
+        set_inflation(victim->priority);
+    }
 
-        prune_candidate = more_recent;
+    // Decrease cache used amount.
+    add_to_cache_size(-(int64_t)victim->size);
+    shard.num_entries--;
+    shard.evictions++;
+
+    victim->next = *evicted;
+    *evicted = victim;
+}
+
+// Evict unused entries from the shard until the cache as a whole is
+// within its size limit or there is nothing left to evict here. The
+// evicted entries are added to a list for the caller to pass to
+// retire_entries once it has released the shard's lock, which must be
+// held. Under the cost-aware policy this does nothing, as the victim
+// has to be chosen from the whole cache by prune_cache.
+WEAK void prune_shard_already_locked(CacheShard &shard, CacheEntry **evicted) {
+    if (eviction_policy == halide_memoization_cache_evict_cost_aware) {
+        return;
+    }
+#if CACHE_DEBUGGING
+    validate_shard(shard);
+#endif
+    while (cache_over_budget()) {
+        CacheEntry *victim = choose_victim(shard);
+        if (victim == nullptr) {
+            break;
+        }
+        evict_already_locked(shard, victim, evicted);
     }
 #if CACHE_DEBUGGING
-    validate_cache();
+    validate_shard(shard);
 #endif
 }
 
+// Evict the unused entry with the lowest priority in the whole cache,
+// taking one shard lock at a time. Returns false if there was none.
+WEAK bool evict_lowest_priority() {
+    size_t best = kNumShards;
+    double best_priority = 0;
+    for (size_t i = 0; i < kNumShards; i++) {
+        CacheShard &shard = cache_shards[i];
+        ScopedMutexLock lock(&shard.lock);
+        CacheEntry *victim = choose_victim(shard);
+        if (victim != nullptr && (best == kNumShards || victim->priority < best_priority)) {
+            best = i;
+            best_priority = victim->priority;
+        }
+    }
+    if (best == kNumShards) {
+        return false;
+    }
+
+    // The shard may have changed since it was looked at, so choose
+    // again.
+    CacheShard &shard = cache_shards[best];
+    CacheEntry *evicted = nullptr;
+    {
+        ScopedMutexLock lock(&shard.lock);
+        CacheEntry *victim = choose_victim(shard);
+        if (victim != nullptr && cache_over_budget()) {
+            evict_already_locked(shard, victim, &evicted);
+        }
+    }
+    retire_entries(evicted);
+    return true;
+}
+
+// Prune shards one at a time, starting after the given one, until the
+// cache is back within its size limit. Must be called with no shard
+// locks held.
+WEAK void prune_cache(size_t first_shard) {
+    if (eviction_policy == halide_memoization_cache_evict_cost_aware) {
+        // A shard's cheapest entry may still be much more expensive
+        // than other shards' entries, so don't evict from any one
+        // shard alone.
+        while (cache_over_budget() && evict_lowest_priority()) {
+        }
+        return;
+    }
+    for (size_t i = 0; i < kNumShards && cache_over_budget(); i++) {
+        CacheShard &shard = cache_shards[(first_shard + i) % kNumShards];
+        CacheEntry *evicted = nullptr;
+        {
+            ScopedMutexLock lock(&shard.lock);
+            prune_shard_already_locked(shard, &evicted);
+        }
+        retire_entries(evicted);
+    }
+}
+
 }  // namespace Internal
 }  // namespace Runtime
 }  // namespace Halide
@@ -319,78 +903,212 @@ WEAK void halide_memoization_cache_set_size(int64_t size) {
         size = kDefaultCacheSize;
     }
 
-    ScopedMutexLock lock(&memoization_lock);
+    __atomic_store_n(&max_cache_size, size, __ATOMIC_RELAXED);
+    prune_cache(0);
+}
+
+WEAK void halide_memoization_cache_set_eviction_policy(halide_memoization_cache_eviction_policy_t policy) {
+    // Take every shard lock so that no shard is midway through an
+    // eviction when the policy changes.
+    for (size_t i = 0; i < kNumShards; i++) {
+        halide_mutex_lock(&cache_shards[i].lock);
+    }
+    if (policy != eviction_policy) {
+        eviction_policy = policy;
+        set_inflation(0);
+        // Start every entry off afresh under the new policy.
+        for (size_t i = 0; i < kNumShards; i++) {
+            CacheShard &shard = cache_shards[i];
+            for (CacheEntry *entry = shard.least_recently_used; entry != nullptr; entry = entry->more_recent) {
+                entry->priority = entry_priority(entry);
+            }
+        }
+    }
+    for (size_t i = kNumShards; i > 0; i--) {
+        halide_mutex_unlock(&cache_shards[i - 1].lock);
+    }
+}
+
+WEAK void halide_memoization_cache_get_stats(halide_memoization_cache_stats_t *stats) {
+    memset(stats, 0, sizeof(halide_memoization_cache_stats_t));
+    for (size_t i = 0; i < kNumShards; i++) {
+        CacheShard &shard = cache_shards[i];
+        ScopedMutexLock lock(&shard.lock);
+        stats->hits += shard.hits;
+        stats->misses += shard.misses;
+        stats->evictions += shard.evictions;
+        stats->entries += shard.num_entries;
+    }
+    stats->current_size = __atomic_load_n(&current_cache_size, __ATOMIC_RELAXED);
+    stats->max_size = __atomic_load_n(&max_cache_size, __ATOMIC_RELAXED);
+
+    ScopedMutexLock lock(&disk_tier.lock);
+    stats->disk_hits = disk_tier.hits;
+    stats->disk_stores = disk_tier.stores;
+    stats->disk_size = disk_tier.current_size;
+    stats->disk_max_size = disk_tier.enabled ? disk_tier.max_size : 0;
+}
+
+WEAK int halide_memoization_cache_set_disk_tier(const char *directory, int64_t max_size) {
+    ScopedMutexLock lock(&disk_tier.lock);
+    if (directory == nullptr && disk_tier.enabled) {
+        // Turning the tier off removes its files.
+        char path[kMaxDiskPath];
+        for (size_t i = 0; i < kDiskSlots; i++) {
+            if (disk_tier.slot_size[i] != 0) {
+                disk_slot_path(path, i);
+                halide_remove_file(path);
+            }
+        }
+    }
+    __atomic_store_n(&disk_tier.enabled, false, __ATOMIC_RELAXED);
+    disk_tier.current_size = 0;
+    disk_tier.clock = 0;
+    for (size_t i = 0; i < kDiskSlots; i++) {
+        disk_tier.slot_size[i] = 0;
+        disk_tier.slot_last_use[i] = 0;
+        disk_tier.slot_verified[i] = false;
+    }
+    if (directory == nullptr) {
+        return 0;
+    }
+
+    // Leave room in paths for the file names.
+    if (strlen(directory) + 32 > kMaxDiskPath) {
+        error(nullptr) << "Memoization cache directory name is too long: " << directory << "\n";
+        return halide_error_code_generic_error;
+    }
+    strncpy(disk_tier.directory, directory, kMaxDiskPath);
+
+    // Check that we can write files there at all.
+    char path[kMaxDiskPath];
+    char *end = path + kMaxDiskPath;
+    halide_string_to_string(halide_string_to_string(path, end, directory), end, "/halide_memoization_probe");
+    void *probe = halide_create_file(path);
+    if (!probe) {
+        error(nullptr) << "Can't create files for the memoization cache in " << directory << "\n";
+        return halide_error_code_generic_error;
+    }
+    halide_close_file(probe);
+    halide_remove_file(path);
+
+    // Pick up the files left by earlier runs.
+    for (size_t i = 0; i < kDiskSlots; i++) {
+        disk_slot_path(path, i);
+        size_t file_size = 0;
+        void *mapping = halide_map_file(path, &file_size);
+        if (mapping) {
+            halide_unmap_file(mapping, file_size);
+            disk_tier.slot_size[i] = file_size;
+            disk_tier.current_size += file_size;
+        }
+    }
 
-    max_cache_size = size;
-    prune_cache();
+    disk_tier.max_size = max_size;
+    make_room_in_disk_tier_already_locked(0, kDiskSlots);
+    __atomic_store_n(&disk_tier.enabled, true, __ATOMIC_RELAXED);
+    return 0;
 }
 
 WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cache_key, int32_t size,
                                          halide_buffer_t *computed_bounds, int32_t tuple_count, halide_buffer_t **tuple_buffers) {
     uint32_t h = djb_hash(cache_key, size);
-    uint32_t index = h % kHashTableSize;
+    uint32_t index = bucket_for_hash(h);
+    CacheShard &shard = shard_for_hash(h);
+    bool use_disk_tier = __atomic_load_n(&disk_tier.enabled, __ATOMIC_RELAXED);
 
-    ScopedMutexLock lock(&memoization_lock);
+    {
+        ScopedMutexLock lock(&shard.lock);
 
 #if CACHE_DEBUGGING
-    debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
+        debug_print_key(user_context, "halide_memoization_cache_lookup", cache_key, size);
 
-    debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
+        debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
 
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            debug_print_buffer(user_context, "Allocation bounds", *buf);
+        {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_buffer_t *buf = tuple_buffers[i];
+                debug_print_buffer(user_context, "Allocation bounds", *buf);
+            }
         }
-    }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != nullptr) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
-
-            // Check all the tuple buffers have the same bounds (they should).
-            bool all_bounds_equal = true;
-            for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-            }
+        CacheEntry *entry = shard.entries[index];
+        while (entry != nullptr) {
+            if (entry->hash == h && entry->key_size == (size_t)size &&
+                keys_equal(entry->key, cache_key, size) &&
+                buffer_has_shape(computed_bounds, entry->computed_bounds) &&
+                entry->tuple_count == (uint32_t)tuple_count) {
+
+                // Check all the tuple buffers have the same bounds (they should).
+                bool all_bounds_equal = true;
+                for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
+                    all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
+                }
 
-            if (all_bounds_equal) {
-                if (entry != most_recently_used) {
-                    halide_assert(user_context, entry->more_recent != nullptr);
-                    if (entry->less_recent != nullptr) {
-                        entry->less_recent->more_recent = entry->more_recent;
-                    } else {
-                        halide_assert(user_context, least_recently_used == entry);
-                        least_recently_used = entry->more_recent;
+                if (all_bounds_equal) {
+                    if (entry != shard.most_recently_used) {
+                        unlink_from_recency_list(shard, entry);
+                        push_most_recently_used(shard, entry);
                     }
-                    halide_assert(user_context, entry->more_recent != nullptr);
-                    entry->more_recent->less_recent = entry->less_recent;
+                    entry->priority = entry_priority(entry);
 
-                    entry->more_recent = nullptr;
-                    entry->less_recent = most_recently_used;
-                    if (most_recently_used != nullptr) {
-                        most_recently_used->more_recent = entry;
+                    for (int32_t i = 0; i < tuple_count; i++) {
+                        halide_buffer_t *buf = tuple_buffers[i];
+                        *buf = entry->buf[i];
                     }
-                    most_recently_used = entry;
-                }
 
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    *buf = entry->buf[i];
+                    entry->in_use_count += tuple_count;
+                    shard.hits++;
+
+                    return 0;
                 }
+            }
+            entry = entry->next;
+        }
 
-                entry->in_use_count += tuple_count;
+        if (!use_disk_tier) {
+            shard.misses++;
+        }
+    }
 
-                return 0;
+    if (use_disk_tier) {
+        // Mapping and checking the file happens without the shard's
+        // lock held. If another thread loads or stores the same key
+        // meanwhile, there will briefly be two entries for it, which
+        // is harmless.
+        CacheEntry *loaded = load_from_disk_tier(cache_key, size, h, computed_bounds,
+                                                 tuple_count, tuple_buffers);
+        CacheEntry *evicted = nullptr;
+        {
+            ScopedMutexLock lock(&shard.lock);
+            if (loaded) {
+                add_to_cache_size(loaded->size);
+                loaded->priority = entry_priority(loaded);
+                loaded->next = shard.entries[index];
+                shard.entries[index] = loaded;
+                push_most_recently_used(shard, loaded);
+                shard.num_entries++;
+                loaded->in_use_count = tuple_count;
+                shard.hits++;
+                prune_shard_already_locked(shard, &evicted);
+            } else {
+                shard.misses++;
             }
         }
-        entry = entry->next;
+        if (loaded) {
+            retire_entries(evicted);
+            prune_cache((&shard - cache_shards) + 1);
+            return 0;
+        }
     }
 
+    // Allocate the buffers for the caller to compute into without
+    // holding the lock.
+    int64_t miss_time = 0;
+    if (eviction_policy == halide_memoization_cache_evict_cost_aware) {
+        miss_time = halide_current_time_ns(user_context);
+    }
     for (int32_t i = 0; i < tuple_count; i++) {
         halide_buffer_t *buf = tuple_buffers[i];
 
@@ -406,12 +1124,9 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
         CacheBlockHeader *header = get_pointer_to_header(buf->host);
         header->hash = h;
         header->entry = nullptr;
+        header->miss_time = miss_time;
     }
 
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
-
     return 1;
 }
 
@@ -420,106 +1135,105 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
                                         int32_t tuple_count, halide_buffer_t **tuple_buffers) {
     debug(user_context) << "halide_memoization_cache_store\n";
 
-    uint32_t h = get_pointer_to_header(tuple_buffers[0]->host)->hash;
+    CacheBlockHeader *first_header = get_pointer_to_header(tuple_buffers[0]->host);
+    uint32_t h = first_header->hash;
+    uint32_t index = bucket_for_hash(h);
+    CacheShard &shard = shard_for_hash(h);
 
-    uint32_t index = h % kHashTableSize;
+    uint64_t cost = 0;
+    if (first_header->miss_time != 0) {
+        cost = halide_current_time_ns(user_context) - first_header->miss_time;
+    }
+
+    CacheEntry *evicted = nullptr;
 
-    ScopedMutexLock lock(&memoization_lock);
+    {
+        ScopedMutexLock lock(&shard.lock);
 
 #if CACHE_DEBUGGING
-    debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
+        debug_print_key(user_context, "halide_memoization_cache_store", cache_key, size);
 
-    debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
+        debug_print_buffer(user_context, "computed_bounds", *computed_bounds);
 
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            debug_print_buffer(user_context, "Allocation bounds", *buf);
+        {
+            for (int32_t i = 0; i < tuple_count; i++) {
+                halide_buffer_t *buf = tuple_buffers[i];
+                debug_print_buffer(user_context, "Allocation bounds", *buf);
+            }
         }
-    }
 #endif
 
-    CacheEntry *entry = cache_entries[index];
-    while (entry != nullptr) {
-        if (entry->hash == h && entry->key_size == (size_t)size &&
-            keys_equal(entry->key, cache_key, size) &&
-            buffer_has_shape(computed_bounds, entry->computed_bounds) &&
-            entry->tuple_count == (uint32_t)tuple_count) {
-
-            bool all_bounds_equal = true;
-            bool no_host_pointers_equal = true;
-            {
-                for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
-                    halide_buffer_t *buf = tuple_buffers[i];
-                    all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
-                    if (entry->buf[i].host == buf->host) {
-                        no_host_pointers_equal = false;
+        CacheEntry *entry = shard.entries[index];
+        while (entry != nullptr) {
+            if (entry->hash == h && entry->key_size == (size_t)size &&
+                keys_equal(entry->key, cache_key, size) &&
+                buffer_has_shape(computed_bounds, entry->computed_bounds) &&
+                entry->tuple_count == (uint32_t)tuple_count) {
+
+                bool all_bounds_equal = true;
+                bool no_host_pointers_equal = true;
+                {
+                    for (int32_t i = 0; all_bounds_equal && i < tuple_count; i++) {
+                        halide_buffer_t *buf = tuple_buffers[i];
+                        all_bounds_equal = buffer_has_shape(tuple_buffers[i], entry->buf[i].dim);
+                        if (entry->buf[i].host == buf->host) {
+                            no_host_pointers_equal = false;
+                        }
                     }
                 }
-            }
-            if (all_bounds_equal) {
-                halide_assert(user_context, no_host_pointers_equal);
-                // This entry is still in use by the caller. Mark it as having no cache entry
-                // so halide_memoization_cache_release can free the buffer.
-                for (int32_t i = 0; i < tuple_count; i++) {
-                    get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+                if (all_bounds_equal) {
+                    halide_assert(user_context, no_host_pointers_equal);
+                    // This entry is still in use by the caller. Mark it as having no cache entry
+                    // so halide_memoization_cache_release can free the buffer.
+                    for (int32_t i = 0; i < tuple_count; i++) {
+                        get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+                    }
+                    return 0;
                 }
-                return 0;
             }
+            entry = entry->next;
         }
-        entry = entry->next;
-    }
 
-    uint64_t added_size = 0;
-    {
-        for (int32_t i = 0; i < tuple_count; i++) {
-            halide_buffer_t *buf = tuple_buffers[i];
-            added_size += buf->size_in_bytes();
+        CacheEntry *new_entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
+        bool inited = false;
+        if (new_entry) {
+            inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers);
         }
-    }
-    current_cache_size += added_size;
-    prune_cache();
-
-    CacheEntry *new_entry = (CacheEntry *)halide_malloc(nullptr, sizeof(CacheEntry));
-    bool inited = false;
-    if (new_entry) {
-        inited = new_entry->init(cache_key, size, h, computed_bounds, tuple_count, tuple_buffers);
-    }
-    if (!inited) {
-        current_cache_size -= added_size;
+        if (!inited) {
+            // This entry is still in use by the caller. Mark it as having no cache entry
+            // so halide_memoization_cache_release can free the buffer.
+            for (int32_t i = 0; i < tuple_count; i++) {
+                get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+            }
 
-        // This entry is still in use by the caller. Mark it as having no cache entry
-        // so halide_memoization_cache_release can free the buffer.
-        for (int32_t i = 0; i < tuple_count; i++) {
-            get_pointer_to_header(tuple_buffers[i]->host)->entry = nullptr;
+            if (new_entry) {
+                halide_free(user_context, new_entry);
+            }
+            return 0;
         }
 
-        if (new_entry) {
-            halide_free(user_context, new_entry);
-        }
-        return 0;
-    }
+        new_entry->cost = cost;
+        new_entry->priority = entry_priority(new_entry);
+        new_entry->next = shard.entries[index];
+        shard.entries[index] = new_entry;
+        push_most_recently_used(shard, new_entry);
+        shard.num_entries++;
 
-    new_entry->next = cache_entries[index];
-    new_entry->less_recent = most_recently_used;
-    if (most_recently_used != nullptr) {
-        most_recently_used->more_recent = new_entry;
-    }
-    most_recently_used = new_entry;
-    if (least_recently_used == nullptr) {
-        least_recently_used = new_entry;
-    }
-    cache_entries[index] = new_entry;
+        new_entry->in_use_count = tuple_count;
 
-    new_entry->in_use_count = tuple_count;
+        for (int32_t i = 0; i < tuple_count; i++) {
+            get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
+        }
 
-    for (int32_t i = 0; i < tuple_count; i++) {
-        get_pointer_to_header(tuple_buffers[i]->host)->entry = new_entry;
+        // The new entry is in use, so this only evicts older ones.
+        add_to_cache_size(new_entry->size);
+        prune_shard_already_locked(shard, &evicted);
     }
+    retire_entries(evicted);
+
+    // If this shard had nothing left to evict, make room elsewhere.
+    prune_cache((&shard - cache_shards) + 1);
 
-#if CACHE_DEBUGGING
-    validate_cache();
-#endif
     debug(user_context) << "Exiting halide_memoization_cache_store\n";
 
     return 0;
@@ -533,12 +1247,13 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
     if (entry == nullptr) {
         halide_free(user_context, header);
     } else {
-        ScopedMutexLock lock(&memoization_lock);
+        CacheShard &shard = shard_for_hash(entry->hash);
+        ScopedMutexLock lock(&shard.lock);
 
         halide_assert(user_context, entry->in_use_count > 0);
         entry->in_use_count--;
 #if CACHE_DEBUGGING
-        validate_cache();
+        validate_shard(shard);
 #endif
     }
 
@@ -547,19 +1262,24 @@ WEAK void halide_memoization_cache_release(void *user_context, void *host) {
 
 WEAK void halide_memoization_cache_cleanup() {
     debug(nullptr) << "halide_memoization_cache_cleanup\n";
-    for (size_t i = 0; i < kHashTableSize; i++) {
-        CacheEntry *entry = cache_entries[i];
-        cache_entries[i] = nullptr;
-        while (entry != nullptr) {
-            CacheEntry *next = entry->next;
-            entry->destroy();
-            halide_free(nullptr, entry);
-            entry = next;
+    for (size_t s = 0; s < kNumShards; s++) {
+        CacheShard &shard = cache_shards[s];
+        for (size_t i = 0; i < kHashTableSize; i++) {
+            CacheEntry *entry = shard.entries[i];
+            shard.entries[i] = nullptr;
+            // Spill everything to the disk tier, if there is one, so
+            // that the next run starts with it.
+            retire_entries(entry);
         }
+        shard.most_recently_used = nullptr;
+        shard.least_recently_used = nullptr;
+        shard.num_entries = 0;
+        shard.hits = 0;
+        shard.misses = 0;
+        shard.evictions = 0;
     }
     current_cache_size = 0;
-    most_recently_used = nullptr;
-    least_recently_used = nullptr;
+    set_inflation(0);
 }
 
 namespace {
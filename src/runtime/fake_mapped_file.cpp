@@ -0,0 +1,27 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+WEAK void *halide_map_file(const char *path, size_t *size) {
+    return nullptr;
+}
+
+WEAK void halide_unmap_file(void *addr, size_t size) {
+}
+
+WEAK void *halide_create_file(const char *path) {
+    return nullptr;
+}
+
+WEAK bool halide_write_file(void *file, const void *data, size_t size) {
+    return false;
+}
+
+WEAK void halide_close_file(void *file) {
+}
+
+WEAK void halide_remove_file(const char *path) {
+}
+
+}  // extern "C"
@@ -0,0 +1,14 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+WEAK int halide_get_cpu_topology(int *cpus, int *nodes, int max_cpus) {
+    return 0;
+}
+
+WEAK int halide_pin_current_thread(int cpu) {
+    return -1;
+}
+
+}  // extern "C"
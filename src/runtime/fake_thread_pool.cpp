@@ -46,6 +46,10 @@ WEAK bool halide_default_semaphore_try_acquire(halide_semaphore_t *s, int n) {
     return false;
 }
 
+WEAK uint64_t halide_thread_id() {
+    return 0;
+}
+
 }  // extern "C"
 
 namespace Halide {
@@ -114,6 +118,14 @@ WEAK int halide_set_num_threads(int n) {
     return 1;
 }
 
+WEAK bool halide_set_work_stealing(bool enabled) {
+    return false;
+}
+
+WEAK bool halide_set_thread_affinity(bool enabled) {
+    return false;
+}
+
 WEAK halide_do_task_t halide_set_custom_do_task(halide_do_task_t f) {
     halide_do_task_t result = custom_do_task;
     custom_do_task = f;
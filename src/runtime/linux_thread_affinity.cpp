@@ -0,0 +1,118 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+// The kernel interface takes the mask size in bytes, so we can use
+// our own bitset instead of cpu_set_t.
+extern int sched_getaffinity(int pid, size_t cpusetsize, void *mask);
+extern int sched_setaffinity(int pid, size_t cpusetsize, const void *mask);
+extern size_t fread(void *, size_t, size_t, void *);
+
+}  // extern "C"
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// Enough for the affinity mask of any machine we care about.
+#define MAX_AFFINITY_CPUS 1024
+#define MAX_NUMA_NODES 64
+
+struct cpu_mask_t {
+    uint64_t bits[MAX_AFFINITY_CPUS / 64];
+
+    ALWAYS_INLINE bool contains(int cpu) const {
+        return (bits[cpu / 64] >> (cpu % 64)) & 1;
+    }
+};
+
+// Parse a sysfs cpu list such as "0-15,32-47" and record that the
+// listed cpus belong to the given node.
+WEAK void parse_cpu_list(const char *str, int node, int *node_of_cpu) {
+    while (*str) {
+        if (*str < '0' || *str > '9') {
+            str++;
+            continue;
+        }
+        int first = 0;
+        while (*str >= '0' && *str <= '9') {
+            first = first * 10 + (*str++ - '0');
+        }
+        int last = first;
+        if (*str == '-') {
+            str++;
+            last = 0;
+            while (*str >= '0' && *str <= '9') {
+                last = last * 10 + (*str++ - '0');
+            }
+        }
+        for (int cpu = first; cpu <= last && cpu < MAX_AFFINITY_CPUS; cpu++) {
+            node_of_cpu[cpu] = node;
+        }
+    }
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK int halide_get_cpu_topology(int *cpus, int *nodes, int max_cpus) {
+    cpu_mask_t mask;
+    memset(&mask, 0, sizeof(mask));
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0) {
+        return 0;
+    }
+
+    // Machines without NUMA support in the kernel have no node
+    // directories in sysfs, in which case everything is on node 0.
+    int node_of_cpu[MAX_AFFINITY_CPUS];
+    memset(node_of_cpu, 0, sizeof(node_of_cpu));
+    int num_nodes = 1;
+    for (int node = 0; node < MAX_NUMA_NODES; node++) {
+        char path[64];
+        char *dst = halide_string_to_string(path, path + sizeof(path), "/sys/devices/system/node/node");
+        dst = halide_int64_to_string(dst, path + sizeof(path), node, 1);
+        halide_string_to_string(dst, path + sizeof(path), "/cpulist");
+        void *f = fopen(path, "r");
+        if (!f) {
+            continue;
+        }
+        char cpu_list[1024];
+        size_t len = fread(cpu_list, 1, sizeof(cpu_list) - 1, f);
+        fclose(f);
+        cpu_list[len] = 0;
+        parse_cpu_list(cpu_list, node, node_of_cpu);
+        num_nodes = node + 1;
+    }
+
+    // List the cpus we may run on grouped by node, so that
+    // consecutive entries share a node wherever possible.
+    int count = 0;
+    for (int node = 0; node < num_nodes; node++) {
+        for (int cpu = 0; cpu < MAX_AFFINITY_CPUS && count < max_cpus; cpu++) {
+            if (mask.contains(cpu) && node_of_cpu[cpu] == node) {
+                cpus[count] = cpu;
+                nodes[count] = node;
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+WEAK int halide_pin_current_thread(int cpu) {
+    if (cpu < 0 || cpu >= MAX_AFFINITY_CPUS) {
+        return -1;
+    }
+    cpu_mask_t mask;
+    memset(&mask, 0, sizeof(mask));
+    mask.bits[cpu / 64] = (uint64_t)1 << (cpu % 64);
+    return sched_setaffinity(0, sizeof(mask), &mask);
+}
+
+}  // extern "C"
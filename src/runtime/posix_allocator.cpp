@@ -2,29 +2,256 @@
 #include "runtime_internal.h"
 
 #include "printer.h"
+#include "scoped_mutex_lock.h"
 
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
+}
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// An optional pool for host allocations. Freed blocks are kept on
+// free lists bucketed by size class, and handed back out to later
+// allocations of the same class instead of going back to the system
+// allocator. Classes are spaced four per power of two, so a block is
+// at most 25% larger than the size asked for.
+//
+// The runtime has no portable thread-local storage, so instead of
+// per-thread free lists there are a number of shards, picked by the
+// address of the calling thread's stack. Every thread runs on its own
+// stack, so a thread that allocates and frees the same intermediate
+// each iteration of a parallel loop keeps getting the same block back
+// without contending with other threads. A thread that misses in its
+// own shard looks in the others before calling malloc, so blocks
+// freed by a different thread than the one that allocated them are
+// still reused.
+namespace HostAllocationPool {
+
+const int num_shards = 16;
+// Classes are numbered from 32 bytes, but the smallest one used is
+// 64 bytes. Allocations larger than the biggest class (2 GB) are
+// not pooled.
+const int min_class_bits = 5;
+const int max_class_bits = 30;
+const int num_classes = (max_class_bits - min_class_bits + 1) * 4;
+const size_t unpooled = (size_t)-1;
+
+ALWAYS_INLINE size_t class_size(size_t c) {
+    const int bits = (int)(c / 4) + min_class_bits;
+    return ((size_t)(5 + c % 4)) << (bits - 2);
+}
+
+ALWAYS_INLINE size_t size_class(size_t x) {
+    if (x < 64) {
+        x = 64;
+    }
+    const uint64_t y = x - 1;
+    const int bits = 63 - __builtin_clzll(y);
+    if (bits > max_class_bits) {
+        return unpooled;
+    }
+    const int sub = (int)((y >> (bits - 2)) & 3);
+    return (size_t)((bits - min_class_bits) * 4 + sub);
+}
+
+struct Shard {
+    halide_mutex mutex;
+    // Singly-linked lists of free blocks, threaded through the first
+    // word of each block.
+    void *free_lists[num_classes];
+    // A bit per non-empty free list, which other shards read without
+    // holding the lock to decide whether it's worth stealing from
+    // this one.
+    uint64_t nonempty[(num_classes + 63) / 64];
+    uint64_t allocations, hits, cached_blocks, cached_bytes;
+    // Keep shards on separate cache lines.
+    char padding[64];
+};
+
+WEAK Shard shards[num_shards];
+
+// -1 means HL_HOST_ALLOCATION_POOLING has not been consulted yet.
+WEAK int enabled = -1;
+
+ALWAYS_INLINE int current_shard() {
+    int dummy;
+    // Hash the address at a granularity coarser than a stack frame
+    // but finer than the spacing between thread stacks.
+    uint64_t a = ((uint64_t)(uintptr_t)&dummy) >> 18;
+    return (int)((a * 0x9E3779B97F4A7C15ULL) >> 60) % num_shards;
+}
+
+WEAK bool is_enabled() {
+    int e = __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+    if (e < 0) {
+        char *pooling_str = getenv("HL_HOST_ALLOCATION_POOLING");
+        int expected = -1;
+        __atomic_compare_exchange_n(&enabled, &expected, (pooling_str && atoi(pooling_str) != 0) ? 1 : 0,
+                                    false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        e = __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+    }
+    return e != 0;
+}
+
+ALWAYS_INLINE bool has_free_block(Shard *s, size_t c) {
+    return (__atomic_load_n(&s->nonempty[c / 64], __ATOMIC_RELAXED) >> (c % 64)) & 1;
+}
+
+// Must hold the shard's lock.
+WEAK void *pop(Shard *s, size_t c) {
+    void *ptr = s->free_lists[c];
+    if (ptr) {
+        void *next = *(void **)ptr;
+        s->free_lists[c] = next;
+        if (!next) {
+            __atomic_and_fetch(&s->nonempty[c / 64], ~((uint64_t)1 << (c % 64)), __ATOMIC_RELAXED);
+        }
+        s->cached_blocks--;
+        s->cached_bytes -= class_size(c);
+    }
+    return ptr;
+}
+
+// Must hold the shard's lock.
+WEAK void push(Shard *s, size_t c, void *ptr) {
+    *(void **)ptr = s->free_lists[c];
+    s->free_lists[c] = ptr;
+    __atomic_or_fetch(&s->nonempty[c / 64], (uint64_t)1 << (c % 64), __ATOMIC_RELAXED);
+    s->cached_blocks++;
+    s->cached_bytes += class_size(c);
+}
+
+WEAK void *get(size_t c) {
+    const int home = current_shard();
+    {
+        Shard *s = &shards[home];
+        ScopedMutexLock lock(&s->mutex);
+        s->allocations++;
+        if (void *ptr = pop(s, c)) {
+            s->hits++;
+            return ptr;
+        }
+    }
+    for (int i = 1; i < num_shards; i++) {
+        Shard *s = &shards[(home + i) % num_shards];
+        if (!has_free_block(s, c)) {
+            continue;
+        }
+        ScopedMutexLock lock(&s->mutex);
+        if (void *ptr = pop(s, c)) {
+            s->hits++;
+            return ptr;
+        }
+    }
+    return nullptr;
+}
+
+WEAK void put(size_t c, void *ptr) {
+    Shard *s = &shards[current_shard()];
+    ScopedMutexLock lock(&s->mutex);
+    push(s, c, ptr);
+}
+
+}  // namespace HostAllocationPool
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+extern "C" {
 
 WEAK void *halide_default_malloc(void *user_context, size_t x) {
+    using namespace Halide::Runtime::Internal::HostAllocationPool;
+
+    size_t c = unpooled;
+    if (is_enabled()) {
+        c = size_class(x);
+        if (c != unpooled) {
+            if (void *ptr = get(c)) {
+                return ptr;
+            }
+            x = class_size(c);
+        }
+    }
+
     // Allocate enough space for aligning the pointer we return.
     const size_t alignment = halide_malloc_alignment();
-    void *orig = malloc(x + alignment);
+    void *orig = malloc(x + alignment + 2 * sizeof(void *));
     if (orig == nullptr) {
         // Will result in a failed assertion and a call to halide_error
         return nullptr;
     }
-    // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void *) - 1) & ~(alignment - 1));
+    // We want to store the original pointer and the size class prior
+    // to the pointer we return.
+    void *ptr = (void *)(((size_t)orig + alignment + 2 * sizeof(void *) - 1) & ~(alignment - 1));
     ((void **)ptr)[-1] = orig;
+    ((size_t *)ptr)[-2] = c;
     return ptr;
 }
 
 WEAK void halide_default_free(void *user_context, void *ptr) {
+    using namespace Halide::Runtime::Internal::HostAllocationPool;
+
+    const size_t c = ((size_t *)ptr)[-2];
+    if (c != unpooled && is_enabled()) {
+        put(c, ptr);
+        return;
+    }
     free(((void **)ptr)[-1]);
 }
+
+WEAK bool halide_set_host_allocation_pooling(bool enabled) {
+    using namespace Halide::Runtime::Internal;
+
+    bool old = HostAllocationPool::is_enabled();
+    __atomic_store_n(&HostAllocationPool::enabled, enabled ? 1 : 0, __ATOMIC_RELAXED);
+    if (!enabled) {
+        halide_trim_host_allocation_pool(nullptr, 0);
+    }
+    return old;
+}
+
+WEAK void halide_trim_host_allocation_pool(void *user_context, uint64_t max_cached_bytes) {
+    using namespace Halide::Runtime::Internal::HostAllocationPool;
+
+    uint64_t total = 0;
+    for (int i = 0; i < num_shards; i++) {
+        total += __atomic_load_n(&shards[i].cached_bytes, __ATOMIC_RELAXED);
+    }
+    // Release the biggest blocks from each shard first.
+    for (int i = 0; i < num_shards && total > max_cached_bytes; i++) {
+        Shard *s = &shards[i];
+        ScopedMutexLock lock(&s->mutex);
+        for (int c = num_classes - 1; c >= 0 && total > max_cached_bytes; c--) {
+            while (total > max_cached_bytes) {
+                void *ptr = pop(s, c);
+                if (!ptr) {
+                    break;
+                }
+                total -= class_size(c);
+                free(((void **)ptr)[-1]);
+            }
+        }
+    }
+}
+
+WEAK void halide_get_host_allocation_pool_stats(void *user_context, struct halide_host_allocation_pool_stats *stats) {
+    using namespace Halide::Runtime::Internal::HostAllocationPool;
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < num_shards; i++) {
+        Shard *s = &shards[i];
+        ScopedMutexLock lock(&s->mutex);
+        stats->allocations += s->allocations;
+        stats->hits += s->hits;
+        stats->cached_blocks += s->cached_blocks;
+        stats->cached_bytes += s->cached_bytes;
+    }
+}
 }
 
 namespace Halide {
@@ -0,0 +1,78 @@
+#include "HalideRuntime.h"
+#include "runtime_internal.h"
+
+extern "C" {
+
+extern void *mmap(void *addr, size_t length, int prot, int flags, int fd, long offset);
+extern int munmap(void *addr, size_t length);
+extern int fseek(void *stream, long offset, int whence);
+extern long ftell(void *stream);
+
+}  // extern "C"
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// These have the same values on every posix platform we support.
+#define HALIDE_PROT_READ 1
+#define HALIDE_PROT_WRITE 2
+#define HALIDE_MAP_PRIVATE 2
+#define HALIDE_SEEK_END 2
+#define HALIDE_MAP_FAILED ((void *)-1)
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+using namespace Halide::Runtime::Internal;
+
+extern "C" {
+
+WEAK void *halide_map_file(const char *path, size_t *size) {
+    void *f = fopen(path, "rb");
+    if (!f) {
+        return nullptr;
+    }
+    void *addr = nullptr;
+    long length = (fseek(f, 0, HALIDE_SEEK_END) == 0) ? ftell(f) : -1;
+    if (length > 0) {
+        // A private writable mapping, so that callers can scribble on
+        // the pages they need to (which are then copied) without
+        // touching the file. The mapping outlives the file handle.
+        addr = mmap(nullptr, (size_t)length, HALIDE_PROT_READ | HALIDE_PROT_WRITE,
+                    HALIDE_MAP_PRIVATE, fileno(f), 0);
+        if (addr == HALIDE_MAP_FAILED) {
+            addr = nullptr;
+        } else {
+            *size = (size_t)length;
+        }
+    }
+    fclose(f);
+    return addr;
+}
+
+WEAK void halide_unmap_file(void *addr, size_t size) {
+    munmap(addr, size);
+}
+
+WEAK void *halide_create_file(const char *path) {
+    // Unlink any existing file first rather than truncating it, as it
+    // may still be mapped.
+    remove(path);
+    return fopen(path, "wb");
+}
+
+WEAK bool halide_write_file(void *file, const void *data, size_t size) {
+    return size == 0 || fwrite(data, size, 1, file) == 1;
+}
+
+WEAK void halide_close_file(void *file) {
+    fclose(file);
+}
+
+WEAK void halide_remove_file(const char *path) {
+    remove(path);
+}
+
+}  // extern "C"
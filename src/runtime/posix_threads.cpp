@@ -18,6 +18,7 @@ struct pthread_cond_t {
 };
 
 typedef long pthread_t;
+extern pthread_t pthread_self();
 extern int pthread_create(pthread_t *, const void *attr,
                           void *(*start_routine)(void *), void *arg);
 extern int pthread_join(pthread_t thread, void **retval);
@@ -76,6 +77,10 @@ WEAK void halide_join_thread(struct halide_thread *thread_arg) {
     pthread_join(t->handle, &ret);
     free(t);
 }
+
+WEAK uint64_t halide_thread_id() {
+    return (uint64_t)pthread_self();
+}
 }
 
 namespace Halide {
@@ -137,6 +137,278 @@ WEAK void sampling_profiler_thread(void *) {
     halide_mutex_unlock(&s->lock);
 }
 
+// The event-based profiler, used by pipelines compiled with
+// Target::ProfileEvents. Each thread records events into its own ring
+// buffer without taking any locks, and the buffers are written out as
+// a Chrome trace when the profiler reports.
+enum profiler_event_kind {
+    // The thread started working on behalf of a Func.
+    profiler_event_begin,
+    // The thread stopped working, e.g. to wait for a parallel loop or
+    // a semaphore, or because its task finished.
+    profiler_event_end,
+    // The thread moved on to a different Func.
+    profiler_event_enter,
+    // The heap usage of a pipeline changed. The value is the new total.
+    profiler_event_memory,
+};
+
+struct profiler_event {
+    uint64_t time;
+    uint64_t value;
+    int32_t func;
+    int32_t kind;
+};
+
+#define MAX_EVENT_THREADS 256
+#define EVENTS_PER_THREAD (1 << 16)
+
+struct profiler_event_buffer {
+    uint64_t thread_id;
+    // The number of events ever recorded. The last EVENTS_PER_THREAD
+    // of them are kept. Only the owning thread writes this.
+    uint64_t count;
+    profiler_event events[EVENTS_PER_THREAD];
+};
+
+// Threads claim a buffer by hashing their thread id. The owner of a
+// slot is the thread id plus one, or zero if the slot is free.
+WEAK uint64_t event_buffer_owners[MAX_EVENT_THREADS];
+WEAK profiler_event_buffer *event_buffers[MAX_EVENT_THREADS];
+WEAK bool recording_events = false;
+
+WEAK profiler_event_buffer *claim_event_buffer(uint64_t owner, int slot) {
+    profiler_event_buffer *b = (profiler_event_buffer *)malloc(sizeof(profiler_event_buffer));
+    if (!b) {
+        return nullptr;
+    }
+    b->thread_id = owner - 1;
+    b->count = 0;
+    uint64_t expected = 0;
+    if (!__atomic_compare_exchange_n(&event_buffer_owners[slot], &expected, owner,
+                                     false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        free(b);
+        return nullptr;
+    }
+    __atomic_store_n(&event_buffers[slot], b, __ATOMIC_RELEASE);
+    __atomic_store_n(&recording_events, true, __ATOMIC_RELAXED);
+    return b;
+}
+
+WEAK profiler_event_buffer *get_event_buffer() {
+    uint64_t owner = halide_thread_id() + 1;
+    int start = (int)(((owner * 0x9E3779B97F4A7C15ULL) >> 32) % MAX_EVENT_THREADS);
+    for (int i = 0; i < MAX_EVENT_THREADS; i++) {
+        int slot = (start + i) % MAX_EVENT_THREADS;
+        uint64_t o = __atomic_load_n(&event_buffer_owners[slot], __ATOMIC_ACQUIRE);
+        if (o == owner) {
+            return event_buffers[slot];
+        } else if (o == 0) {
+            profiler_event_buffer *b = claim_event_buffer(owner, slot);
+            if (b) {
+                return b;
+            }
+            // Another thread got there first. Keep looking.
+        }
+    }
+    // Too many threads. Drop the event.
+    return nullptr;
+}
+
+WEAK void record_event(int kind, int func, uint64_t value) {
+    profiler_event_buffer *b = get_event_buffer();
+    if (!b) {
+        return;
+    }
+    profiler_event &e = b->events[b->count % EVENTS_PER_THREAD];
+    e.time = halide_current_time_ns(nullptr);
+    e.value = value;
+    e.func = func;
+    e.kind = kind;
+    // Publish the event to whoever writes the trace.
+    __atomic_store_n(&b->count, b->count + 1, __ATOMIC_RELEASE);
+}
+
+WEAK halide_profiler_pipeline_stats *find_pipeline_for_func(halide_profiler_state *s, int func_id) {
+    for (halide_profiler_pipeline_stats *p = s->pipelines; p;
+         p = (halide_profiler_pipeline_stats *)(p->next)) {
+        if (func_id >= p->first_func_id && func_id < p->first_func_id + p->num_funcs) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Appends JSON string contents, escaping as necessary.
+template<typename PrinterType>
+void print_json_string(PrinterType &sstr, const char *str) {
+    char buf[128];
+    while (*str) {
+        size_t i = 0;
+        while (*str && i < sizeof(buf) - 3) {
+            if (*str == '"' || *str == '\\') {
+                buf[i++] = '\\';
+            }
+            buf[i++] = *str++;
+        }
+        buf[i] = 0;
+        sstr << buf;
+    }
+}
+
+class TraceEventWriter {
+    void *file;
+    uint64_t start_time;
+    bool first = true;
+    char line_buf[1024];
+    Printer<StringStreamPrinter, sizeof(line_buf)> sstr;
+
+    void start_event(const char *ph, uint64_t time, int tid) {
+        // Timestamps are in microseconds. Print them exactly rather
+        // than going through a float.
+        uint64_t ns = time > start_time ? time - start_time : 0;
+        uint64_t frac = ns % 1000;
+        sstr.clear();
+        sstr << (first ? "" : ",\n") << "{\"ph\":\"" << ph << "\",\"pid\":1,\"tid\":" << tid
+             << ",\"ts\":" << ns / 1000 << "."
+             << (frac < 100 ? "0" : "") << (frac < 10 ? "0" : "") << frac;
+        first = false;
+    }
+
+    void finish_event() {
+        sstr << "}";
+        fwrite(sstr.str(), sstr.size(), 1, file);
+    }
+
+public:
+    TraceEventWriter(void *user_context, void *f, uint64_t start_time)
+        : file(f), start_time(start_time), sstr(user_context, line_buf) {
+        const char *header = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        fwrite(header, strlen(header), 1, file);
+    }
+
+    ~TraceEventWriter() {
+        const char *footer = "\n]}\n";
+        fwrite(footer, strlen(footer), 1, file);
+    }
+
+    void thread_name(int tid, uint64_t thread_id) {
+        start_event("M", 0, tid);
+        sstr << ",\"name\":\"thread_name\",\"args\":{\"name\":\"thread " << thread_id << "\"}";
+        finish_event();
+    }
+
+    void begin(halide_profiler_state *s, uint64_t time, int tid, int func_id) {
+        start_event("B", time, tid);
+        halide_profiler_pipeline_stats *p = find_pipeline_for_func(s, func_id);
+        sstr << ",\"name\":\"";
+        print_json_string(sstr, p ? p->funcs[func_id - p->first_func_id].name : "unknown");
+        sstr << "\",\"cat\":\"";
+        print_json_string(sstr, p ? p->name : "unknown");
+        sstr << "\"";
+        finish_event();
+    }
+
+    void end(uint64_t time, int tid) {
+        start_event("E", time, tid);
+        finish_event();
+    }
+
+    void memory(halide_profiler_state *s, uint64_t time, int tid, int func_id, uint64_t bytes) {
+        start_event("C", time, tid);
+        halide_profiler_pipeline_stats *p = find_pipeline_for_func(s, func_id);
+        sstr << ",\"name\":\"heap: ";
+        print_json_string(sstr, p ? p->name : "unknown");
+        sstr << "\",\"args\":{\"bytes\":" << bytes << "}";
+        finish_event();
+    }
+};
+
+// Turn each thread's events into nested begin and end events. Each
+// thread has a stack of the Funcs it is working on: it may run other
+// tasks while it waits for a parallel loop it launched.
+WEAK void write_thread_trace_events(halide_profiler_state *s, TraceEventWriter &writer,
+                                    int tid, profiler_event_buffer *b) {
+    const int max_depth = 64;
+    int stack[max_depth];
+    int depth = 0, overflow = 0;
+    uint64_t count = __atomic_load_n(&b->count, __ATOMIC_ACQUIRE);
+    uint64_t first = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+    uint64_t last_time = 0;
+    writer.thread_name(tid, b->thread_id);
+    for (uint64_t i = first; i < count; i++) {
+        const profiler_event &e = b->events[i % EVENTS_PER_THREAD];
+        last_time = e.time;
+        switch (e.kind) {
+        case profiler_event_begin:
+            if (depth == max_depth) {
+                overflow++;
+            } else {
+                stack[depth++] = e.func;
+                writer.begin(s, e.time, tid, e.func);
+            }
+            break;
+        case profiler_event_end:
+            // The matching begin may have been overwritten.
+            if (overflow) {
+                overflow--;
+            } else if (depth) {
+                depth--;
+                writer.end(e.time, tid);
+            }
+            break;
+        case profiler_event_enter:
+            if (overflow) {
+                break;
+            }
+            if (depth) {
+                writer.end(e.time, tid);
+                stack[depth - 1] = e.func;
+            } else {
+                stack[depth++] = e.func;
+            }
+            writer.begin(s, e.time, tid, e.func);
+            break;
+        case profiler_event_memory:
+            writer.memory(s, e.time, tid, e.func, e.value);
+            break;
+        }
+    }
+    while (depth--) {
+        writer.end(last_time, tid);
+    }
+}
+
+WEAK int write_trace_events_unlocked(void *user_context, halide_profiler_state *s, const char *filename) {
+    void *f = fopen(filename, "w");
+    if (!f) {
+        error(user_context) << "Could not open " << filename << " to write profiler trace events\n";
+        return halide_error_code_generic_error;
+    }
+    // Make the timestamps relative to the earliest surviving event.
+    uint64_t start_time = ~(uint64_t)0;
+    for (int i = 0; i < MAX_EVENT_THREADS; i++) {
+        profiler_event_buffer *b = __atomic_load_n(&event_buffers[i], __ATOMIC_ACQUIRE);
+        uint64_t count = b ? __atomic_load_n(&b->count, __ATOMIC_ACQUIRE) : 0;
+        if (count) {
+            uint64_t first = count > EVENTS_PER_THREAD ? count - EVENTS_PER_THREAD : 0;
+            uint64_t t = b->events[first % EVENTS_PER_THREAD].time;
+            start_time = t < start_time ? t : start_time;
+        }
+    }
+    {
+        TraceEventWriter writer(user_context, f, start_time);
+        for (int i = 0; i < MAX_EVENT_THREADS; i++) {
+            profiler_event_buffer *b = __atomic_load_n(&event_buffers[i], __ATOMIC_ACQUIRE);
+            if (b && b->count) {
+                write_thread_trace_events(s, writer, i, b);
+            }
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
 }  // namespace Internal
 }  // namespace Runtime
 }  // namespace Halide
@@ -248,6 +520,9 @@ WEAK void halide_profiler_memory_allocate(void *user_context,
     __sync_add_and_fetch(&p_stats->memory_total, incr);
     uint64_t p_mem_current = __sync_add_and_fetch(&p_stats->memory_current, incr);
     sync_compare_max_and_swap(&p_stats->memory_peak, p_mem_current);
+    if (recording_events) {
+        record_event(profiler_event_memory, p_stats->first_func_id + func_id, p_mem_current);
+    }
 
     // Update per-func memory stats
     __sync_add_and_fetch(&f_stats->num_allocs, 1);
@@ -280,12 +555,41 @@ WEAK void halide_profiler_memory_free(void *user_context,
     // unless user specifically calls halide_profiler_reset().
 
     // Update per-pipeline memory stats
-    __sync_sub_and_fetch(&p_stats->memory_current, decr);
+    uint64_t p_mem_current = __sync_sub_and_fetch(&p_stats->memory_current, decr);
+    if (recording_events) {
+        record_event(profiler_event_memory, p_stats->first_func_id + func_id, p_mem_current);
+    }
 
     // Update per-func memory stats
     __sync_sub_and_fetch(&f_stats->memory_current, decr);
 }
 
+WEAK int halide_profiler_event_set_current_func(halide_profiler_state *state, int tok, int t) {
+    // Keep the sampling profiler up to date too.
+    volatile int *ptr = &(state->current_func);
+    *ptr = tok + t;
+    record_event(profiler_event_enter, tok + t, 0);
+    return 0;
+}
+
+WEAK int halide_profiler_event_incr_active_threads(halide_profiler_state *state, int tok, int t) {
+    __sync_fetch_and_add(&(state->active_threads), 1);
+    record_event(profiler_event_begin, tok + t, 0);
+    return 0;
+}
+
+WEAK int halide_profiler_event_decr_active_threads(halide_profiler_state *state) {
+    record_event(profiler_event_end, 0, 0);
+    __sync_fetch_and_sub(&(state->active_threads), 1);
+    return 0;
+}
+
+WEAK int halide_profiler_write_trace_events(void *user_context, const char *filename) {
+    halide_profiler_state *s = halide_profiler_get_state();
+    ScopedMutexLock lock(&s->lock);
+    return write_trace_events_unlocked(user_context, s, filename);
+}
+
 WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_state *s) {
 
     char line_buf[1024];
@@ -402,6 +706,18 @@ WEAK void halide_profiler_report_unlocked(void *user_context, halide_profiler_st
             }
         }
     }
+
+    if (recording_events) {
+        const char *filename = getenv("HL_PROFILER_TRACE_FILE");
+        if (!filename) {
+            filename = "halide_profiler_trace.json";
+        }
+        if (write_trace_events_unlocked(user_context, s, filename) == 0) {
+            sstr.clear();
+            sstr << "Wrote profiler trace events to " << filename << "\n";
+            halide_print(user_context, sstr.str());
+        }
+    }
 }
 
 WEAK void halide_profiler_report(void *user_context) {
@@ -418,6 +734,18 @@ WEAK void halide_profiler_reset_unlocked(halide_profiler_state *s) {
         free(p);
     }
     s->first_free_id = 0;
+    // No pipelines are running, so no thread is recording into its
+    // event buffer. Free them, and let threads claim new ones if they
+    // record more events.
+    for (int i = 0; i < MAX_EVENT_THREADS; i++) {
+        profiler_event_buffer *b = event_buffers[i];
+        if (b) {
+            __atomic_store_n(&event_buffers[i], nullptr, __ATOMIC_RELAXED);
+            __atomic_store_n(&event_buffer_owners[i], 0, __ATOMIC_RELEASE);
+            free(b);
+        }
+    }
+    __atomic_store_n(&recording_events, false, __ATOMIC_RELAXED);
 }
 
 WEAK void halide_profiler_reset() {
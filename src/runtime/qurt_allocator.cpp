@@ -116,6 +116,20 @@ WEAK halide_free_t halide_set_custom_free(halide_free_t user_free) {
     return result;
 }
 
+// Hexagon already keeps a small pool of buffers (see above), so the
+// host allocation pool is not supported.
+WEAK bool halide_set_host_allocation_pooling(bool enabled) {
+    return false;
+}
+
+WEAK void halide_trim_host_allocation_pool(void *user_context, uint64_t max_cached_bytes) {
+}
+
+WEAK void halide_get_host_allocation_pool_stats(void *user_context, struct halide_host_allocation_pool_stats *stats) {
+    stats->allocations = stats->hits = 0;
+    stats->cached_blocks = stats->cached_bytes = 0;
+}
+
 // TODO: These should be calling custom_malloc/custom_free, but globals are not
 // initialized correctly when using mmap_dlopen. We need to fix this, then we
 // can enable the custom allocators.
@@ -156,6 +156,15 @@ WEAK int halide_profiler_pipeline_start(void *user_context,
                                         const char *pipeline_name,
                                         int num_funcs,
                                         const uint64_t *func_names);
+
+// Called instead of halide_profiler_set_current_func and
+// halide_profiler_incr/decr_active_threads by pipelines compiled with
+// Target::ProfileEvents, to also record an event on the calling
+// thread's timeline.
+struct halide_profiler_state;
+WEAK int halide_profiler_event_set_current_func(struct halide_profiler_state *state, int tok, int t);
+WEAK int halide_profiler_event_incr_active_threads(struct halide_profiler_state *state, int tok, int t);
+WEAK int halide_profiler_event_decr_active_threads(struct halide_profiler_state *state);
 WEAK int halide_host_cpu_count();
 
 WEAK int halide_device_and_host_malloc(void *user_context, struct halide_buffer_t *buf,
@@ -189,6 +198,32 @@ WEAK_INLINE int halide_malloc_alignment();
 
 void halide_thread_yield();
 
+// An identifier for the calling thread, distinct from that of every
+// other running thread.
+WEAK uint64_t halide_thread_id();
+
+// Write the logical cpus this process may run on to cpus, grouped by
+// NUMA node, and the node of each one to nodes. Returns the number of
+// cpus written, or zero if thread affinity isn't supported.
+WEAK int halide_get_cpu_topology(int *cpus, int *nodes, int max_cpus);
+
+// Pin the calling thread to a single logical cpu. Returns zero on success.
+WEAK int halide_pin_current_thread(int cpu);
+
+// Map the whole file at path into memory. The mapping is private, and
+// writable so that callers can patch pages without touching the
+// file. Returns nullptr on failure, or if the platform can't map files,
+// and stores the size of the mapping in *size otherwise.
+WEAK void *halide_map_file(const char *path, size_t *size);
+WEAK void halide_unmap_file(void *addr, size_t size);
+
+// Minimal file writing used alongside halide_map_file. Creating a file
+// replaces any existing one without disturbing existing mappings of it.
+WEAK void *halide_create_file(const char *path);
+WEAK bool halide_write_file(void *file, const void *data, size_t size);
+WEAK void halide_close_file(void *file);
+WEAK void halide_remove_file(const char *path);
+
 }  // extern "C"
 
 namespace {
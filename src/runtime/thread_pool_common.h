@@ -23,6 +23,18 @@ namespace Halide {
 namespace Runtime {
 namespace Internal {
 
+// A contiguous range of loop iterations that one worker owns under the
+// work-stealing scheduler. The owning worker claims iterations from the
+// front, and idle workers steal from the back.
+struct work_stealing_range {
+    // Guards next and end. Only contended when a thief and the owner
+    // (or two thieves) touch the same range at the same time.
+    volatile char lock;
+    int next, end;
+    // Pad out to a cache line to avoid false sharing between workers.
+    char padding[52];
+};
+
 struct work {
     halide_parallel_task_t task;
 
@@ -43,6 +55,15 @@ struct work {
     // which condition variable is the owner sleeping on. nullptr if it isn't sleeping.
     bool owner_is_sleeping;
 
+    // If the work-stealing scheduler is in use, the iterations of the
+    // job are partitioned up front across these per-worker ranges and
+    // claimed without holding the work queue lock. nullptr for jobs
+    // that are sliced up via the shared job stack.
+    work_stealing_range *ranges;
+    int num_ranges;
+    // The next range to hand out to a worker joining the job.
+    int next_range;
+
     ALWAYS_INLINE bool make_runnable() {
         for (; next_semaphore < task.num_semaphores; next_semaphore++) {
             if (!halide_default_semaphore_try_acquire(task.semaphores[next_semaphore].semaphore,
@@ -90,6 +111,16 @@ WEAK int default_desired_num_threads() {
     return desired_num_threads;
 }
 
+WEAK bool default_work_stealing() {
+    char *work_stealing_str = getenv("HL_WORK_STEALING");
+    return work_stealing_str && atoi(work_stealing_str) != 0;
+}
+
+WEAK bool default_thread_affinity() {
+    char *affinity_str = getenv("HL_THREAD_AFFINITY");
+    return affinity_str && atoi(affinity_str) != 0;
+}
+
 // The work queue and thread pool is weak, so one big work queue is shared by all halide functions
 struct work_queue_t {
     // all fields are protected by this mutex.
@@ -98,6 +129,17 @@ struct work_queue_t {
     // The desired number threads doing work (HL_NUM_THREADS).
     int desired_threads_working;
 
+    // Whether simple parallel loops use per-worker ranges plus
+    // randomized stealing instead of claiming iterations from the job
+    // stack one at a time (HL_WORK_STEALING). Only consulted at
+    // initialization if halide_set_work_stealing has not been called.
+    bool work_stealing, work_stealing_set;
+
+    // Whether worker threads are pinned to cpus grouped by NUMA node
+    // (HL_THREAD_AFFINITY). Only consulted at initialization if
+    // halide_set_thread_affinity has not been called.
+    bool thread_affinity, thread_affinity_set;
+
     // All fields after this must be zero in the initial state. See assert_zeroed
     // Field serves both to mark the offset in struct and as layout padding.
     int zero_marker;
@@ -138,6 +180,15 @@ struct work_queue_t {
     // to prevent deadlock due to oversubscription of threads.
     int threads_reserved;
 
+    // If thread affinity is enabled, the cpus to pin threads to,
+    // grouped by NUMA node, and the node of each. Worker slot i (slot 0
+    // being the calling thread) is pinned to cpus[i % num_cpus] and
+    // has work-stealing range i as its home. Zero if thread affinity
+    // is disabled or unsupported on this platform.
+    int num_cpus;
+    int cpus[MAX_THREADS];
+    int cpu_nodes[MAX_THREADS];
+
     ALWAYS_INLINE bool running() const {
         return !shutdown;
     }
@@ -193,8 +244,130 @@ WEAK void dump_job_state() {
 #endif
 
 WEAK void worker_thread(void *);
+WEAK void pinned_worker_thread(void *);
+
+// Claim one iteration from the front of a range. Returns false if the
+// range is empty.
+ALWAYS_INLINE bool claim_from_range(work_stealing_range *range, int *iter) {
+    ScopedSpinLock lock(&range->lock);
+    if (range->next >= range->end) {
+        return false;
+    }
+    *iter = range->next++;
+    return true;
+}
+
+// Move the back half of the victim's range into the thief's range,
+// which should be empty. Returns true if the thief's range has work in
+// it afterwards.
+WEAK bool steal_from_range(work_stealing_range *victim, work_stealing_range *thief) {
+    // Take the locks in address order so that two workers stealing from
+    // each other can't deadlock.
+    work_stealing_range *first = victim < thief ? victim : thief;
+    work_stealing_range *second = victim < thief ? thief : victim;
+    ScopedSpinLock lock_first(&first->lock);
+    ScopedSpinLock lock_second(&second->lock);
+    if (thief->next < thief->end) {
+        // Another worker sharing this home range refilled it already.
+        return true;
+    }
+    int remaining = victim->end - victim->next;
+    if (remaining <= 0) {
+        return false;
+    }
+    int stolen = (remaining + 1) / 2;
+    thief->end = victim->end;
+    thief->next = victim->end - stolen;
+    victim->end = thief->next;
+    return true;
+}
+
+// Split [min, min + extent) into num_ranges nearly equal pieces.
+WEAK void init_work_stealing_ranges(work_stealing_range *ranges, int num_ranges, int min, int extent) {
+    for (int i = 0; i < num_ranges; i++) {
+        ranges[i].lock = 0;
+        ranges[i].next = min + (int)(((int64_t)extent * i) / num_ranges);
+        ranges[i].end = min + (int)(((int64_t)extent * (i + 1)) / num_ranges);
+    }
+}
+
+// Whether two ranges of a job belong to worker slots on the same NUMA
+// node. Always true if thread affinity is off.
+ALWAYS_INLINE bool ranges_share_node(int a, int b) {
+    const int num_cpus = work_queue.num_cpus;
+    return num_cpus == 0 ||
+           work_queue.cpu_nodes[a % num_cpus] == work_queue.cpu_nodes[b % num_cpus];
+}
+
+// Run iterations of a job using the work-stealing scheduler until all of
+// its ranges are empty or an iteration fails. Called without the work
+// queue lock held.
+WEAK int run_work_stealing_job(work *job, int home) {
+    work_stealing_range *ranges = job->ranges;
+    const int num_ranges = job->num_ranges;
+    // With thread affinity on, try to steal from workers on our own
+    // node before going to other nodes.
+    const int first_pass = work_queue.num_cpus ? 0 : 1;
+    // A per-call xorshift generator for picking victims.
+    uint32_t seed = (uint32_t)home * 2654435761U + 1;
+    int result = 0;
+    while (result == 0) {
+        // Stop early if another worker's iteration failed, or the
+        // enclosing job did. These are written under the lock, so this
+        // may see them late, but then we just do a little extra work.
+        if (__atomic_load_n(&job->exit_status, __ATOMIC_RELAXED) != 0 ||
+            (job->parent_job &&
+             __atomic_load_n(&job->parent_job->exit_status, __ATOMIC_RELAXED) != 0)) {
+            break;
+        }
+
+        int iter;
+        if (claim_from_range(ranges + home, &iter)) {
+            if (job->task_fn) {
+                result = halide_do_task(job->user_context, job->task_fn, iter,
+                                        job->task.closure);
+            } else {
+                result = halide_do_loop_task(job->user_context, job->task.fn,
+                                             iter, 1, job->task.closure, job);
+            }
+            continue;
+        }
+
+        // Our home range is empty. Visit the other ranges starting at
+        // a random victim and steal from the first one with work left.
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        bool stole = false;
+        for (int pass = first_pass; pass < 2 && !stole; pass++) {
+            int victim = seed % num_ranges;
+            for (int i = 0; i < num_ranges && !stole; i++) {
+                if (victim != home && (pass == 1 || ranges_share_node(victim, home))) {
+                    stole = steal_from_range(ranges + victim, ranges + home);
+                }
+                victim = (victim + 1 == num_ranges) ? 0 : victim + 1;
+            }
+        }
+        if (!stole) {
+            break;
+        }
+    }
+    return result;
+}
+
+WEAK void remove_job_already_locked(work *job) {
+    work **prev_ptr = &work_queue.jobs;
+    while (*prev_ptr && *prev_ptr != job) {
+        prev_ptr = &((*prev_ptr)->next_job);
+    }
+    if (*prev_ptr) {
+        *prev_ptr = job->next_job;
+    }
+}
 
-WEAK void worker_thread_already_locked(work *owned_job) {
+// slot identifies a pinned worker thread, or is -1 for unpinned
+// workers and for threads waiting on their own jobs.
+WEAK void worker_thread_already_locked(work *owned_job, int slot = -1) {
     while (owned_job ? owned_job->running() : !work_queue.shutdown) {
         work *job = work_queue.jobs;
         work **prev_ptr = &work_queue.jobs;
@@ -310,7 +483,30 @@ WEAK void worker_thread_already_locked(work *owned_job) {
 
         int result = 0;
 
-        if (job->task.serial) {
+        if (job->ranges) {
+            // Pick a home range and work on the job without the lock
+            // until every range has been drained. Pinned workers
+            // always take the range for their slot, so that the same
+            // iterations land on the same NUMA node every time.
+            int home;
+            if (slot >= 0) {
+                home = slot % job->num_ranges;
+            } else {
+                home = job->next_range;
+                job->next_range = (job->next_range + 1) % job->num_ranges;
+            }
+
+            halide_mutex_unlock(&work_queue.mutex);
+            result = run_work_stealing_job(job, home);
+            halide_mutex_lock(&work_queue.mutex);
+
+            // Every iteration has been claimed (or we failed), so take
+            // the job off the stack unless another worker already did.
+            if (job->task.extent != 0) {
+                job->task.extent = 0;
+                remove_job_already_locked(job);
+            }
+        } else if (job->task.serial) {
             // Remove it from the stack while we work on it
             *prev_ptr = job->next_job;
 
@@ -419,7 +615,17 @@ WEAK void worker_thread(void *arg) {
     halide_mutex_unlock(&work_queue.mutex);
 }
 
-WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_parent) {
+// The entry point for worker threads when thread affinity is
+// enabled. The argument is the worker's slot.
+WEAK void pinned_worker_thread(void *arg) {
+    int slot = (int)(intptr_t)arg;
+    halide_pin_current_thread(work_queue.cpus[slot % work_queue.num_cpus]);
+    halide_mutex_lock(&work_queue.mutex);
+    worker_thread_already_locked(nullptr, slot);
+    halide_mutex_unlock(&work_queue.mutex);
+}
+
+WEAK void initialize_work_queue_already_locked() {
     if (!work_queue.initialized) {
         work_queue.assert_zeroed();
 
@@ -430,8 +636,41 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             work_queue.desired_threads_working = default_desired_num_threads();
         }
         work_queue.desired_threads_working = clamp_num_threads(work_queue.desired_threads_working);
+        if (!work_queue.work_stealing_set) {
+            work_queue.work_stealing = default_work_stealing();
+        }
+        if (!work_queue.thread_affinity_set) {
+            work_queue.thread_affinity = default_thread_affinity();
+        }
+        if (work_queue.thread_affinity) {
+            work_queue.num_cpus = halide_get_cpu_topology(work_queue.cpus, work_queue.cpu_nodes, MAX_THREADS);
+        }
         work_queue.initialized = true;
     }
+}
+
+// The number of per-worker ranges to split a job of the given extent
+// into, or zero if the job should go through the job stack alone. Only
+// simple parallel loops that can't block qualify. Thread affinity
+// implies per-worker ranges, as they are what keep contiguous blocks
+// of iterations on the same NUMA node.
+WEAK int num_work_stealing_ranges_already_locked(const halide_parallel_task_t &task) {
+    if (!(work_queue.work_stealing || work_queue.num_cpus) ||
+        task.serial ||
+        task.num_semaphores != 0 ||
+        task.min_threads != 0 ||
+        task.extent <= 1) {
+        return 0;
+    }
+    int num_ranges = work_queue.desired_threads_working;
+    if (num_ranges > task.extent) {
+        num_ranges = task.extent;
+    }
+    return num_ranges;
+}
+
+WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_parent) {
+    initialize_work_queue_already_locked();
 
     // Gather some information about the work.
 
@@ -489,8 +728,15 @@ WEAK void enqueue_work_already_locked(int num_jobs, work *jobs, work *task_paren
             // We might need to make some new threads, if work_queue.desired_threads_working has
             // increased, or if there aren't enough threads to complete this new task.
             work_queue.a_team_size++;
-            work_queue.threads[work_queue.threads_created++] =
-                halide_spawn_thread(worker_thread, nullptr);
+            if (work_queue.num_cpus) {
+                // Slot 0 is the calling thread, so workers start at 1.
+                intptr_t slot = work_queue.threads_created + 1;
+                work_queue.threads[work_queue.threads_created++] =
+                    halide_spawn_thread(pinned_worker_thread, (void *)slot);
+            } else {
+                work_queue.threads[work_queue.threads_created++] =
+                    halide_spawn_thread(worker_thread, nullptr);
+            }
         }
         log_message("enqueue_work_already_locked top level job " << jobs[0].task.name << " with min_threads " << min_threads << " work_queue.threads_created " << work_queue.threads_created << " work_queue.threads_reserved " << work_queue.threads_reserved);
         if (job_has_acquires || job_may_block) {
@@ -605,7 +851,17 @@ WEAK int halide_default_do_par_for(void *user_context, halide_task_t f,
     job.siblings = &job;  // guarantees no other job points to the same siblings.
     job.sibling_count = 0;
     job.parent_job = nullptr;
+    job.ranges = nullptr;
+    job.num_ranges = 0;
+    job.next_range = 0;
     halide_mutex_lock(&work_queue.mutex);
+    initialize_work_queue_already_locked();
+    int num_ranges = num_work_stealing_ranges_already_locked(job.task);
+    if (num_ranges) {
+        job.ranges = (work_stealing_range *)__builtin_alloca(sizeof(work_stealing_range) * num_ranges);
+        job.num_ranges = num_ranges;
+        init_work_stealing_ranges(job.ranges, num_ranges, min, size);
+    }
     enqueue_work_already_locked(1, &job, nullptr);
     worker_thread_already_locked(&job);
     halide_mutex_unlock(&work_queue.mutex);
@@ -631,6 +887,9 @@ WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
         jobs[i].next_semaphore = 0;
         jobs[i].owner_is_sleeping = false;
         jobs[i].parent_job = (work *)task_parent;
+        jobs[i].ranges = nullptr;
+        jobs[i].num_ranges = 0;
+        jobs[i].next_range = 0;
     }
 
     if (num_tasks == 0) {
@@ -638,6 +897,15 @@ WEAK int halide_default_do_parallel_tasks(void *user_context, int num_tasks,
     }
 
     halide_mutex_lock(&work_queue.mutex);
+    initialize_work_queue_already_locked();
+    for (int i = 0; i < num_tasks; i++) {
+        int num_ranges = num_work_stealing_ranges_already_locked(jobs[i].task);
+        if (num_ranges) {
+            jobs[i].ranges = (work_stealing_range *)__builtin_alloca(sizeof(work_stealing_range) * num_ranges);
+            jobs[i].num_ranges = num_ranges;
+            init_work_stealing_ranges(jobs[i].ranges, num_ranges, jobs[i].task.min, jobs[i].task.extent);
+        }
+    }
     enqueue_work_already_locked(num_tasks, jobs, (work *)task_parent);
     int exit_status = 0;
     for (int i = 0; i < num_tasks; i++) {
@@ -669,6 +937,30 @@ WEAK int halide_set_num_threads(int n) {
     return old;
 }
 
+WEAK bool halide_set_work_stealing(bool enabled) {
+    halide_mutex_lock(&work_queue.mutex);
+    bool old = work_queue.work_stealing;
+    if (!work_queue.initialized && !work_queue.work_stealing_set) {
+        old = default_work_stealing();
+    }
+    work_queue.work_stealing = enabled;
+    work_queue.work_stealing_set = true;
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
+WEAK bool halide_set_thread_affinity(bool enabled) {
+    halide_mutex_lock(&work_queue.mutex);
+    bool old = work_queue.thread_affinity;
+    if (!work_queue.initialized && !work_queue.thread_affinity_set) {
+        old = default_thread_affinity();
+    }
+    work_queue.thread_affinity = enabled;
+    work_queue.thread_affinity_set = true;
+    halide_mutex_unlock(&work_queue.mutex);
+    return old;
+}
+
 WEAK void halide_shutdown_thread_pool() {
     if (work_queue.initialized) {
         // Wake everyone up and tell them the party's over and it's time
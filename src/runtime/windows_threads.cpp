@@ -28,6 +28,7 @@ extern WIN32API void DeleteCriticalSection(CriticalSection *);
 extern WIN32API void EnterCriticalSection(CriticalSection *);
 extern WIN32API void LeaveCriticalSection(CriticalSection *);
 extern WIN32API int32_t WaitForSingleObject(Thread, int32_t timeout);
+extern WIN32API uint32_t GetCurrentThreadId();
 
 }  // extern "C"
 
@@ -76,6 +77,10 @@ WEAK void halide_join_thread(halide_thread *thread_arg) {
     free(thread);
 }
 
+WEAK uint64_t halide_thread_id() {
+    return GetCurrentThreadId();
+}
+
 }  // extern "C"
 
 namespace Halide {
@@ -9,8 +9,9 @@ extern "C" void x86_cpuid_halide(int32_t *);
 
 namespace {
 
-ALWAYS_INLINE void cpuid(int32_t fn_id, int32_t *info) {
+ALWAYS_INLINE void cpuid(int32_t fn_id, int32_t *info, int32_t sub_fn_id = 0) {
     info[0] = fn_id;
+    info[2] = sub_fn_id;
     x86_cpuid_halide(info);
 }
 
@@ -27,6 +28,9 @@ WEAK CpuFeatures halide_get_cpu_features() {
     features.set_known(halide_target_feature_avx512_knl);
     features.set_known(halide_target_feature_avx512_skylake);
     features.set_known(halide_target_feature_avx512_cannonlake);
+    features.set_known(halide_target_feature_avx512_cascadelake);
+    features.set_known(halide_target_feature_avx512_cooperlake);
+    features.set_known(halide_target_feature_avx512_sapphirerapids);
 
     int32_t info[4];
     cpuid(1, info);
@@ -80,6 +84,25 @@ WEAK CpuFeatures halide_get_cpu_features() {
             if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
                 features.set_available(halide_target_feature_avx512_cannonlake);
             }
+
+            // AVX512-VNNI is reported in ecx of leaf 7, and
+            // AVX512-BF16 in eax of sub-leaf 1 of leaf 7.
+            const uint32_t avx512vnni = 1U << 11;
+            const uint32_t avx512bf16 = 1U << 5;
+            int info3[4];
+            cpuid(7, info3, 1);
+            const bool have_cascadelake = ((info2[1] & avx512_skylake) == avx512_skylake &&
+                                           (info2[2] & avx512vnni) == avx512vnni);
+            const bool have_cooperlake = have_cascadelake && (info3[0] & avx512bf16) == avx512bf16;
+            if (have_cascadelake) {
+                features.set_available(halide_target_feature_avx512_cascadelake);
+            }
+            if (have_cooperlake) {
+                features.set_available(halide_target_feature_avx512_cooperlake);
+                if ((info2[1] & avx512_cannonlake) == avx512_cannonlake) {
+                    features.set_available(halide_target_feature_avx512_sapphirerapids);
+                }
+            }
         }
     }
     return features;
@@ -0,0 +1,110 @@
+#include "Halide.h"
+
+#include <atomic>
+#include <cstdio>
+
+using namespace Halide;
+
+// Counts how many times the pipeline is lowered.
+class CountLowerings : public Internal::IRMutator {
+public:
+    std::atomic<int> count{0};
+
+    using IRMutator::mutate;
+    Internal::Stmt mutate(const Internal::Stmt &s) override {
+        count++;
+        return s;
+    }
+};
+
+bool check(const Buffer<int> &buf) {
+    for (int y = 0; y < buf.height(); y++) {
+        for (int x = 0; x < buf.width(); x++) {
+            int correct = x * 3 + y;
+            if (buf(x, y) != correct) {
+                printf("buf(%d, %d) = %d instead of %d\n", x, y, buf(x, y), correct);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support compiling on other threads.\n");
+        return 0;
+    }
+
+    Var x, y;
+
+    {
+        // Compile in the background, then realize.
+        CountLowerings counter;
+        Func f;
+        f(x, y) = x * 3 + y;
+        f.vectorize(x, 8).parallel(y);
+        f.add_custom_lowering_pass(&counter, nullptr);
+
+        std::shared_future<void> done = f.compile_jit_async(target);
+        done.wait();
+        if (counter.count != 1) {
+            printf("Expected one lowering, got %d\n", counter.count.load());
+            return -1;
+        }
+
+        // The code compiled in the background should be used without
+        // compiling again.
+        if (!check(f.realize({64, 64}, target)) ||
+            !check(f.realize({64, 64}))) {
+            return -1;
+        }
+        if (counter.count != 1) {
+            printf("Expected the background compilation to be reused, but lowered %d times\n", counter.count.load());
+            return -1;
+        }
+    }
+
+    {
+        // With a fallback, realize runs whichever code is ready, and
+        // switches over once the background compilation is done.
+        CountLowerings counter;
+        Func f;
+        f(x, y) = x * 3 + y;
+        f.vectorize(x, 8).parallel(y);
+        f.add_custom_lowering_pass(&counter, nullptr);
+
+        Target fast = target.with_feature(Target::NoAsserts);
+        std::shared_future<void> done = f.compile_jit_async(fast, target);
+        // The fallback is compiled up front.
+        if (counter.count < 1) {
+            printf("Expected the fallback to be compiled already\n");
+            return -1;
+        }
+        for (int i = 0; i < 10; i++) {
+            if (!check(f.realize({64, 64}))) {
+                return -1;
+            }
+        }
+        done.wait();
+        if (!check(f.realize({64, 64}))) {
+            return -1;
+        }
+        if (counter.count != 2) {
+            printf("Expected two lowerings, got %d\n", counter.count.load());
+            return -1;
+        }
+        // Still no more compiling.
+        if (!check(f.realize({64, 64}, fast))) {
+            return -1;
+        }
+        if (counter.count != 2) {
+            printf("Expected two lowerings, got %d\n", counter.count.load());
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using Halide::Internal::JITSharedRuntime;
+
+int main(int argc, char **argv) {
+    Func f("f"), g("g"), h("h");
+    Var x("x"), y("y");
+    f(x, y) = x + y;
+    g(x, y) = f(x - 1, y) + f(x + 1, y);
+    h(x, y) = g(x, y - 1) + g(x, y + 1);
+    // One big intermediate allocated once per run, and a row of g
+    // allocated per iteration of a parallel loop.
+    f.compute_root();
+    g.compute_at(h, y);
+    h.parallel(y);
+    h.compile_jit();
+
+    const int W = 1024, H = 256;
+    auto check = [&](const Buffer<int> &out) {
+        for (int yy = 0; yy < H; yy++) {
+            for (int xx = 0; xx < W; xx++) {
+                int correct = 4 * (xx + yy);
+                if (out(xx, yy) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", xx, yy, out(xx, yy), correct);
+                    exit(-1);
+                }
+            }
+        }
+    };
+
+    JITSharedRuntime::set_host_allocation_pooling(true);
+
+    check(h.realize({W, H}));
+    halide_host_allocation_pool_stats first = JITSharedRuntime::get_host_allocation_pool_stats();
+    check(h.realize({W, H}));
+    halide_host_allocation_pool_stats second = JITSharedRuntime::get_host_allocation_pool_stats();
+
+    if (second.allocations <= first.allocations) {
+        printf("The second run made no pooled allocations\n");
+        return -1;
+    }
+    // The second run's allocations are all the same sizes as the
+    // first's, so they should have reused its blocks.
+    if (second.hits == 0) {
+        printf("The second run didn't reuse any blocks: %llu allocations, %llu hits\n",
+               (unsigned long long)second.allocations, (unsigned long long)second.hits);
+        return -1;
+    }
+    if (second.cached_blocks == 0 || second.cached_bytes < W * H * sizeof(int)) {
+        printf("Expected the pool to hold at least the root intermediate: %llu blocks, %llu bytes\n",
+               (unsigned long long)second.cached_blocks, (unsigned long long)second.cached_bytes);
+        return -1;
+    }
+
+    const uint64_t bound = 64 * 1024;
+    JITSharedRuntime::trim_host_allocation_pool(bound);
+    halide_host_allocation_pool_stats trimmed = JITSharedRuntime::get_host_allocation_pool_stats();
+    if (trimmed.cached_bytes > bound) {
+        printf("After trimming to %llu bytes, the pool still holds %llu bytes\n",
+               (unsigned long long)bound, (unsigned long long)trimmed.cached_bytes);
+        return -1;
+    }
+
+    // Turning pooling off releases everything.
+    check(h.realize({W, H}));
+    JITSharedRuntime::set_host_allocation_pooling(false);
+    halide_host_allocation_pool_stats off = JITSharedRuntime::get_host_allocation_pool_stats();
+    if (off.cached_blocks != 0 || off.cached_bytes != 0) {
+        printf("Turning pooling off left %llu blocks, %llu bytes in the pool\n",
+               (unsigned long long)off.cached_blocks, (unsigned long long)off.cached_bytes);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -1,5 +1,5 @@
 #include "Halide.h"
-#include "halide_image_io.h"
+#include "halide_image_io_mmap.h"
 #include "halide_test_dirs.h"
 
 #include <fstream>
@@ -185,7 +185,7 @@ void do_test() {
     luma_buf.copy_from(color_buf);
     luma_buf.slice(2);
 
-    std::vector<std::string> formats = {"ppm", "pgm", "tmp", "mat", "tiff"};
+    std::vector<std::string> formats = {"ppm", "pgm", "tmp", "mat", "npy", "tiff"};
 #ifndef HALIDE_NO_JPEG
     formats.push_back("jpg");
 #endif
@@ -255,10 +255,110 @@ void test_mat_header() {
     }
 }
 
+void test_load_mapped() {
+    Buffer<uint8_t> buf(37, 29);
+    buf.for_each_element([&](int x, int y) {
+        buf(x, y) = (uint8_t)(x * 7 + y * 3);
+    });
+
+    for (std::string format : {"tmp", "mat", "pgm", "npy", "ppm"}) {
+        std::cout << "Testing load_mapped for format: " << format << "\n";
+        std::string filename = Internal::get_test_tmp_dir() + "test_load_mapped." + format;
+        Buffer<uint8_t> src = buf;
+        if (format == "tmp") {
+            src = buf.embedded(2).embedded(3);
+        } else if (format == "ppm") {
+            Buffer<uint8_t> color(37, 29, 3);
+            color.fill(17);
+            src = color;
+        }
+        Tools::save_image(src, filename);
+
+        Buffer<uint8_t> mapped;
+        std::shared_ptr<void> mapping;
+        if (!Tools::load_mapped(filename, &mapped, &mapping)) {
+            std::cout << "load_mapped failed for " << filename << "\n";
+            abort();
+        }
+        // ppm is interleaved, so it can't be mapped, and should be read
+        // normally instead.
+        if ((mapping != nullptr) != (format != "ppm")) {
+            std::cout << "Unexpected mapping state for " << filename << "\n";
+            abort();
+        }
+        if (mapped.dimensions() != src.dimensions()) {
+            std::cout << "Wrong number of dimensions for " << filename << "\n";
+            abort();
+        }
+        src.for_each_element([&](const int *pos) {
+            if (mapped(pos) != src(pos)) {
+                std::cout << "Mismatch when mapping " << filename << "\n";
+                abort();
+            }
+        });
+
+        // Writing to the image must not change the file.
+        mapped.fill(0);
+        Buffer<uint8_t> reloaded = Tools::load_image(filename);
+        src.for_each_element([&](const int *pos) {
+            if (reloaded(pos) != src(pos)) {
+                std::cout << "Writing to the mapped image changed " << filename << "\n";
+                abort();
+            }
+        });
+    }
+}
+
+void test_npy_c_order() {
+    // A 2x3 array of int16 in C order, as written by numpy.save.
+    std::string header = "{'descr': '<i2', 'fortran_order': False, 'shape': (2, 3), }";
+    header.resize(128 - 10 - 1, ' ');
+    header += '\n';
+    std::string filename = Internal::get_test_tmp_dir() + "test_npy_c_order.npy";
+    {
+        std::ofstream fs(filename.c_str(), std::ofstream::binary);
+        const char prefix[10] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0, (char)header.size(), 0};
+        fs.write(prefix, sizeof(prefix));
+        fs.write(header.data(), header.size());
+        for (int16_t i = 0; i < 6; i++) {
+            int16_t v = i * 100 - 200;
+            fs.write((const char *)&v, sizeof(v));
+        }
+    }
+
+    for (bool use_mapping : {false, true}) {
+        Buffer<int16_t> im;
+        std::shared_ptr<void> mapping;
+        if (use_mapping) {
+            if (!Tools::load_mapped(filename, &im, &mapping) || !mapping) {
+                std::cout << "Could not map " << filename << "\n";
+                abort();
+            }
+        } else {
+            im = Tools::load_image(filename);
+        }
+        if (im.dimensions() != 2 || im.dim(0).extent() != 2 || im.dim(1).extent() != 3) {
+            std::cout << "Wrong shape loading " << filename << "\n";
+            abort();
+        }
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 3; j++) {
+                int correct = (i * 3 + j) * 100 - 200;
+                if (im(i, j) != correct) {
+                    std::cout << "im(" << i << ", " << j << ") = " << im(i, j) << " instead of " << correct << "\n";
+                    abort();
+                }
+            }
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     do_test<uint8_t>();
     do_test<uint16_t>();
     test_mat_header();
+    test_load_mapped();
+    test_npy_c_order();
     printf("Success!\n");
     return 0;
 }
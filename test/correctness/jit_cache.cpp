@@ -0,0 +1,139 @@
+#include "Halide.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+using namespace Halide;
+
+#ifndef _WIN32
+std::vector<std::string> cache_entries(const std::string &dir) {
+    std::vector<std::string> result;
+    DIR *d = opendir(dir.c_str());
+    while (struct dirent *e = readdir(d)) {
+        std::string name = e->d_name;
+        if (name.size() > 9 && name.substr(name.size() - 9) == ".jitcache") {
+            result.push_back(dir + "/" + name);
+        }
+    }
+    closedir(d);
+    return result;
+}
+
+ino_t inode(const std::string &path) {
+    struct stat s;
+    if (stat(path.c_str(), &s) != 0) {
+        return 0;
+    }
+    return s.st_ino;
+}
+
+bool run_and_check(const Module &module, const std::string &name, float scale) {
+    Internal::JITModule jit_module(module, module.get_function_by_name(name), {});
+    auto main_function = (int (*)(halide_buffer_t * buf)) jit_module.main_function();
+    Buffer<float> buf(64, 64);
+    if (main_function(buf.raw_buffer()) != 0) {
+        printf("Pipeline returned an error\n");
+        return false;
+    }
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++) {
+            float correct = x * scale + y;
+            if (std::abs(buf(x, y) - correct) > 1e-4f) {
+                printf("buf(%d, %d) = %f instead of %f\n", x, y, buf(x, y), correct);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+    printf("[SKIP] Windows does not have a working setenv\n");
+    return 0;
+#else
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not use the JIT cache.\n");
+        return 0;
+    }
+
+    std::string dir = Internal::dir_make_temp();
+    setenv("HL_JIT_CACHE_DIR", dir.c_str(), 1);
+
+    Var x("x"), y("y");
+    Func f("f");
+    f(x, y) = x * 0.25f + y;
+    f.vectorize(x, 8).parallel(y);
+
+    Module module = f.compile_to_module({}, "jit_cache_f", target);
+
+    // The first compilation misses, and writes an entry.
+    if (!run_and_check(module, "jit_cache_f", 0.25f)) {
+        return -1;
+    }
+    std::vector<std::string> entries = cache_entries(dir);
+    if (entries.size() != 1) {
+        printf("Expected one JIT cache entry, found %d\n", (int)entries.size());
+        return -1;
+    }
+    ino_t first_inode = inode(entries[0]);
+
+    // The second compilation of the same module hits, and loads the
+    // object code instead of writing a new entry.
+    if (!run_and_check(module, "jit_cache_f", 0.25f)) {
+        return -1;
+    }
+    entries = cache_entries(dir);
+    if (entries.size() != 1 || inode(entries[0]) != first_inode) {
+        printf("Expected the JIT cache entry to be reused\n");
+        return -1;
+    }
+
+    // A corrupt entry is discarded and replaced.
+    {
+        std::ofstream corrupt(entries[0], std::ios::binary | std::ios::trunc);
+        corrupt << "halide_jit_cache 1\nnot a real entry\n";
+    }
+    if (!run_and_check(module, "jit_cache_f", 0.25f)) {
+        return -1;
+    }
+    entries = cache_entries(dir);
+    if (entries.size() != 1 || Internal::file_stat(entries[0]).file_size < 100) {
+        printf("Expected the corrupt JIT cache entry to be replaced\n");
+        return -1;
+    }
+
+    // Changing a constant changes the key, even when the IR prints
+    // the same.
+    Func g("f");
+    g(x, y) = x * 0.25000003f + y;
+    g.vectorize(x, 8).parallel(y);
+    Module other_module = g.compile_to_module({}, "jit_cache_f", target);
+    if (!run_and_check(other_module, "jit_cache_f", 0.25000003f)) {
+        return -1;
+    }
+    if (cache_entries(dir).size() != 2) {
+        printf("Expected a second JIT cache entry\n");
+        return -1;
+    }
+
+    for (const std::string &e : cache_entries(dir)) {
+        Internal::file_unlink(e);
+    }
+    Internal::dir_rmdir(dir);
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
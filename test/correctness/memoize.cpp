@@ -1,8 +1,13 @@
 #include "Halide.h"
 #include "HalideRuntime.h"
+#include "halide_test_dirs.h"
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
 
 using namespace Halide;
 
@@ -34,6 +39,20 @@ extern "C" DLLEXPORT int count_calls_with_arg(uint8_t val, halide_buffer_t *out)
     return 0;
 }
 
+int call_count_with_cost[256];
+
+// Values below 4 take a while to compute.
+extern "C" DLLEXPORT int count_calls_with_cost(uint8_t val, halide_buffer_t *out) {
+    if (!out->is_bounds_query()) {
+        call_count_with_cost[val]++;
+        if (val < 4) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        Halide::Runtime::Buffer<uint8_t>(*out).fill(val);
+    }
+    return 0;
+}
+
 int call_count_with_arg_parallel[8];
 
 extern "C" DLLEXPORT int count_calls_with_arg_parallel(uint8_t val, halide_buffer_t *out) {
@@ -77,7 +96,54 @@ void record_error(void *user_context, const char *msg) {
     error_occured = true;
 }
 
+// Realize a pipeline whose names are all given explicitly, so that it
+// gets the same cache keys in every process, for each of 16 values of
+// its parameter. Returns the number of results that came from the disk
+// tier.
+int realize_disk_tier_pipeline() {
+    Param<float> val("disk_tier_val");
+    Func count_calls("disk_tier_count_calls");
+    count_calls.define_extern("count_calls_with_arg", {cast<uint8_t>(val)}, UInt(8), 2);
+
+    Func f("disk_tier_f");
+    Var x("x"), y("y");
+    f(x, y) = count_calls(x, y) + cast<uint8_t>(x);
+    count_calls.compute_root().memoize();
+
+    halide_memoization_cache_stats_t before = Internal::JITSharedRuntime::memoization_cache_get_stats();
+    for (int v = 0; v < 16; v++) {
+        val.set((float)v);
+        Buffer<uint8_t> out = f.realize(256, 256);
+        assert(out(10, 10) == (uint8_t)(v + 10));
+    }
+    halide_memoization_cache_stats_t after = Internal::JITSharedRuntime::memoization_cache_get_stats();
+    return (int)(after.disk_hits - before.disk_hits);
+}
+
+// Run in a fresh process by the disk tier test below: check that the
+// results written to the given directory by the parent are found.
+int disk_tier_child(const char *dir) {
+    if (Internal::JITSharedRuntime::memoization_cache_set_disk_tier(dir, 16 * 1024 * 1024) != 0) {
+        printf("Can't use a disk tier in %s in the child process.\n", dir);
+        return 1;
+    }
+    Internal::JITSharedRuntime::memoization_cache_set_size(200000);
+    call_count_with_arg = 0;
+    int disk_hits = realize_disk_tier_pipeline();
+    printf("Disk tier in a fresh process: %d hits from disk, %d calls.\n",
+           disk_hits, call_count_with_arg);
+    // Turning the tier off removes the files.
+    Internal::JITSharedRuntime::memoization_cache_set_disk_tier(nullptr, 0);
+    if (disk_hits == 0 || call_count_with_arg + disk_hits > 16) {
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--disk-tier-child") == 0) {
+        return disk_tier_child(argv[2]);
+    }
 
     {
         call_count = 0;
@@ -610,6 +676,146 @@ int main(int argc, char **argv) {
         printf("In 100 attempts with flakey malloc, %d errors and %d full completions occured.\n", total_errors, completed);
     }
 
+    {
+        // Test the cache statistics and the cost-aware eviction policy.
+        Param<uint8_t> val;
+
+        memset(call_count_with_cost, 0, sizeof(call_count_with_cost));
+        Func count_calls;
+        count_calls.define_extern("count_calls_with_cost", {val}, UInt(8), 2);
+
+        Func f;
+        Var x, y;
+        f(x, y) = count_calls(x, y) + cast<uint8_t>(x);
+        count_calls.compute_root().memoize();
+
+        Internal::JITSharedRuntime::memoization_cache_set_size(1000000);
+        Internal::JITSharedRuntime::memoization_cache_set_eviction_policy(halide_memoization_cache_evict_cost_aware);
+        halide_memoization_cache_stats_t before = Internal::JITSharedRuntime::memoization_cache_get_stats();
+
+        auto run = [&](int v) {
+            val.set((uint8_t)v);
+            Buffer<uint8_t> out = f.realize(256, 256);
+            assert(out(10, 10) == (uint8_t)(v + 10));
+        };
+
+        // Each value is 64k, so only about fifteen of them fit in the
+        // cache. Compute four expensive values, then cycle through many
+        // more cheap ones than fit, twice.
+        for (int v = 0; v < 4; v++) {
+            run(v);
+        }
+        for (int i = 0; i < 2; i++) {
+            for (int v = 100; v < 140; v++) {
+                run(v);
+            }
+        }
+
+        halide_memoization_cache_stats_t after = Internal::JITSharedRuntime::memoization_cache_get_stats();
+        uint64_t hits = after.hits - before.hits;
+        uint64_t misses = after.misses - before.misses;
+        printf("Cost-aware cache: %d hits, %d misses, %d evictions, %d entries using %d bytes.\n",
+               (int)hits, (int)misses, (int)(after.evictions - before.evictions),
+               (int)after.entries, (int)after.current_size);
+        assert(hits + misses == 84);
+        assert(after.evictions > before.evictions);
+        assert(after.current_size <= after.max_size);
+
+        // The cheap values were evicted to make room for each other.
+        // At most the dozen or so that fit alongside the expensive ones
+        // can have survived until the second time around...
+        int cheap_calls = 0;
+        for (int v = 100; v < 140; v++) {
+            assert(call_count_with_cost[v] >= 1);
+            cheap_calls += call_count_with_cost[v];
+        }
+        assert(cheap_calls >= 40 + 40 - 12);
+
+        // ...but the expensive ones survived, where LRU would have
+        // evicted them first, so they don't need computing again.
+        for (int v = 0; v < 4; v++) {
+            assert(call_count_with_cost[v] == 1);
+            run(v);
+            assert(call_count_with_cost[v] == 1);
+        }
+
+        // Return cache to default.
+        Internal::JITSharedRuntime::memoization_cache_set_eviction_policy(halide_memoization_cache_evict_lru);
+        Internal::JITSharedRuntime::memoization_cache_set_size(0);
+    }
+
+    {
+        // Test spilling entries to the disk tier and mapping them back in.
+        Param<float> val;
+
+        call_count_with_arg = 0;
+        Func count_calls;
+        count_calls.define_extern("count_calls_with_arg", {cast<uint8_t>(val)}, UInt(8), 2);
+
+        Func f;
+        Var x, y;
+        f(x, y) = count_calls(x, y) + cast<uint8_t>(x);
+        count_calls.compute_root().memoize();
+
+        std::string dir = Internal::get_test_tmp_dir();
+        if (Internal::JITSharedRuntime::memoization_cache_set_disk_tier(dir.c_str(), 16 * 1024 * 1024) != 0) {
+            printf("Can't use a disk tier in %s, skipping its test.\n", dir.c_str());
+        } else {
+            Internal::JITSharedRuntime::memoization_cache_set_size(200000);
+            halide_memoization_cache_stats_t before = Internal::JITSharedRuntime::memoization_cache_get_stats();
+
+            // Each distinct value is 64k, so only a few of them fit in
+            // memory, and the rest must come back from disk on the
+            // second pass.
+            for (int v = 0; v < 32; v++) {
+                val.set((float)(v % 16));
+                Buffer<uint8_t> out = f.realize(256, 256);
+                assert(out(10, 10) == (uint8_t)(v % 16 + 10));
+            }
+
+            halide_memoization_cache_stats_t after = Internal::JITSharedRuntime::memoization_cache_get_stats();
+            uint64_t hits = after.hits - before.hits;
+            uint64_t misses = after.misses - before.misses;
+            uint64_t disk_hits = after.disk_hits - before.disk_hits;
+            printf("Disk tier: %d hits, %d of them from disk, %d misses, %d bytes on disk.\n",
+                   (int)hits, (int)disk_hits, (int)misses, (int)after.disk_size);
+            assert(hits + misses == 32);
+            assert(misses == (uint64_t)call_count_with_arg);
+            assert(disk_hits > 0);
+            assert(after.disk_size <= after.disk_max_size);
+
+            // Return cache to default.
+            Internal::JITSharedRuntime::memoization_cache_set_disk_tier(nullptr, 0);
+            Internal::JITSharedRuntime::memoization_cache_set_size(0);
+        }
+    }
+
+    {
+        // Test that the disk tier is still warm in a fresh process.
+        std::string dir = Internal::get_test_tmp_dir();
+        if (Internal::JITSharedRuntime::memoization_cache_set_disk_tier(dir.c_str(), 16 * 1024 * 1024) != 0) {
+            printf("Can't use a disk tier in %s, skipping its test.\n", dir.c_str());
+        } else {
+            // Most of the results are evicted from memory to disk.
+            Internal::JITSharedRuntime::memoization_cache_set_size(200000);
+            call_count_with_arg = 0;
+            realize_disk_tier_pipeline();
+            assert(call_count_with_arg == 16);
+
+            std::string command = std::string("\"") + argv[0] + "\" --disk-tier-child \"" + dir + "\"";
+            int status = system(command.c_str());
+
+            // The child removes the files it used; this removes the rest.
+            Internal::JITSharedRuntime::memoization_cache_set_disk_tier(nullptr, 0);
+            Internal::JITSharedRuntime::memoization_cache_set_size(0);
+
+            if (status != 0) {
+                printf("The disk tier was not warm in a fresh process.\n");
+                return 1;
+            }
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
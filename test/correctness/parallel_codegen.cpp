@@ -0,0 +1,76 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Halide;
+
+// Count the members of a static library.
+int count_members(const std::string &lib) {
+    std::vector<char> data = Internal::read_entire_file(lib);
+    if (data.size() < 8 || std::string(data.data(), 8) != "!<arch>\n") {
+        printf("%s is not an archive\n", lib.c_str());
+        exit(-1);
+    }
+    int members = 0;
+    size_t offset = 8;
+    while (offset + 60 <= data.size()) {
+        size_t size = std::strtoul(std::string(data.data() + offset + 48, 10).c_str(), nullptr, 10);
+        members++;
+        offset += 60 + size;
+        offset += offset & 1;
+    }
+    return members;
+}
+
+void set_codegen_jobs(const char *jobs) {
+#ifdef _WIN32
+    _putenv_s("HL_LLVM_CODEGEN_JOBS", jobs);
+#else
+    setenv("HL_LLVM_CODEGEN_JOBS", jobs, 1);
+#endif
+}
+
+int main(int argc, char **argv) {
+    // Several parallel loops, so that there are several closures to
+    // spread across the partitions, along with the runtime.
+    Func f("f"), g("g"), h("h");
+    Var x("x"), y("y");
+    ImageParam input(Float(32), 2, "input");
+    f(x, y) = sin(input(x, y));
+    g(x, y) = f(x - 1, y) + f(x + 1, y);
+    h(x, y) = g(x, y - 1) * g(x, y + 1);
+    f.compute_root().parallel(y).vectorize(x, 8);
+    g.compute_root().parallel(y).vectorize(x, 8);
+    h.parallel(y).vectorize(x, 8);
+
+    Target target = get_host_target();
+    const char *a = target.os == Target::Windows ? ".lib" : ".a";
+    std::string serial = Internal::get_test_tmp_dir() + "halide_test_correctness_parallel_codegen_serial";
+    std::string parallel = Internal::get_test_tmp_dir() + "halide_test_correctness_parallel_codegen_parallel";
+    Internal::ensure_no_file_exists(serial + a);
+    Internal::ensure_no_file_exists(parallel + a);
+
+    set_codegen_jobs("1");
+    h.compile_to_static_library(serial, {input}, "parallel_codegen", target);
+    set_codegen_jobs("4");
+    h.compile_to_static_library(parallel, {input}, "parallel_codegen", target);
+    set_codegen_jobs("");
+
+    Internal::assert_file_exists(serial + a);
+    Internal::assert_file_exists(parallel + a);
+
+    // The parallel build should split the code across four objects
+    // instead of one.
+    int serial_members = count_members(serial + a);
+    int parallel_members = count_members(parallel + a);
+    if (parallel_members != serial_members + 3) {
+        printf("Expected the parallel build to have 3 more members than the serial one: %d vs %d\n",
+               parallel_members, serial_members);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -159,6 +159,124 @@ int test4(const Target &t) {
     return 0;
 }
 
+int test5(const Target &t) {
+    ImageParam in(Int(32), 2, "in");
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+
+    // A transpose, with a strided load in the innermost loop.
+    f(x, y) = in(y, x);
+    // A copy, with a dense one.
+    g(x, y) = in(x, y);
+
+    Target auto_t = t.with_feature(Target::AutoPrefetch);
+
+    {
+        Module m = f.compile_to_module({in}, "", auto_t);
+        CollectPrefetches collect;
+        m.functions()[0].body.accept(&collect);
+
+        if (collect.prefetches.size() != 1) {
+            std::cout << "Expect 1 prefetch of the transposed input instead of "
+                      << collect.prefetches.size() << "\n";
+            return -1;
+        }
+        if (!equal(collect.prefetches[0][0], Variable::make(Handle(), in.name()))) {
+            std::cout << "Expect a prefetch of " << in.name() << ", got "
+                      << collect.prefetches[0][0] << " instead\n";
+            return -1;
+        }
+    }
+
+    {
+        Module m = g.compile_to_module({in}, "", auto_t);
+        CollectPrefetches collect;
+        m.functions()[0].body.accept(&collect);
+
+        vector<vector<Expr>> expected = {};
+        if (!check(expected, collect.prefetches)) {
+            return -1;
+        }
+    }
+
+    // The prefetches run ahead of the end of the input, which must be harmless.
+    Buffer<int> input(300, 200);
+    input.for_each_element([&](int x, int y) { input(x, y) = x * 1000 + y; });
+    in.set(input);
+    Buffer<int> out = f.realize({200, 300}, auto_t);
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            if (out(x, y) != input(y, x)) {
+                std::cout << "out(" << x << ", " << y << ") = " << out(x, y)
+                          << " instead of " << input(y, x) << "\n";
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+int test6(const Target &t) {
+    ImageParam in(Int(32), 2, "in");
+    Func f("f"), g("g");
+    Var x("x"), y("y");
+
+    // The same transpose and copy, vectorized, so that the innermost
+    // serial loop has a vectorized loop inside it.
+    f(x, y) = in(y, x);
+    f.vectorize(x, 4);
+    g(x, y) = in(x, y);
+    g.vectorize(x, 4);
+
+    Target auto_t = t.with_feature(Target::AutoPrefetch);
+
+    {
+        Module m = f.compile_to_module({in}, "", auto_t);
+        CollectPrefetches collect;
+        m.functions()[0].body.accept(&collect);
+
+        // Each lane of the transposed load reads a different row.
+        if (collect.prefetches.size() != 4) {
+            std::cout << "Expect 4 prefetches of the transposed input instead of "
+                      << collect.prefetches.size() << "\n";
+            return -1;
+        }
+        for (const auto &p : collect.prefetches) {
+            if (!equal(p[0], Variable::make(Handle(), in.name()))) {
+                std::cout << "Expect a prefetch of " << in.name() << ", got "
+                          << p[0] << " instead\n";
+                return -1;
+            }
+        }
+    }
+
+    {
+        Module m = g.compile_to_module({in}, "", auto_t);
+        CollectPrefetches collect;
+        m.functions()[0].body.accept(&collect);
+
+        vector<vector<Expr>> expected = {};
+        if (!check(expected, collect.prefetches)) {
+            return -1;
+        }
+    }
+
+    Buffer<int> input(300, 200);
+    input.for_each_element([&](int x, int y) { input(x, y) = x * 1000 + y; });
+    in.set(input);
+    Buffer<int> out = f.realize({200, 300}, auto_t);
+    for (int y = 0; y < out.height(); y++) {
+        for (int x = 0; x < out.width(); x++) {
+            if (out(x, y) != input(y, x)) {
+                std::cout << "out(" << x << ", " << y << ") = " << out(x, y)
+                          << " instead of " << input(y, x) << "\n";
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
 }  // anonymous namespace
 
 int main(int argc, char **argv) {
@@ -180,6 +298,14 @@ int main(int argc, char **argv) {
     if (test4(t) != 0) {
         return -1;
     }
+    printf("Running prefetch test5\n");
+    if (test5(t) != 0) {
+        return -1;
+    }
+    printf("Running prefetch test6\n");
+    if (test6(t) != 0) {
+        return -1;
+    }
 
     printf("Success!\n");
     return 0;
@@ -0,0 +1,71 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support writing the trace file.\n");
+        return 0;
+    }
+
+    Func producer("producer"), consumer("consumer");
+    Var x, y;
+    producer(x, y) = sin(x * 0.1f) + cos(y * 0.1f);
+    consumer(x, y) = producer(x, y) + producer(x + 1, y);
+
+    consumer.parallel(y);
+    producer.compute_at(consumer, y);
+
+    // With Target::ProfileEvents, the JIT writes the trace to this
+    // file when it reports the profiling results.
+    std::string trace_file = Internal::get_test_tmp_dir() + "profiler_events_trace.json";
+    Internal::ensure_no_file_exists(trace_file);
+#ifdef _WIN32
+    _putenv_s("HL_PROFILER_TRACE_FILE", trace_file.c_str());
+#else
+    setenv("HL_PROFILER_TRACE_FILE", trace_file.c_str(), 1);
+#endif
+
+    consumer.realize({256, 256}, target.with_feature(Target::ProfileEvents));
+
+    Internal::assert_file_exists(trace_file);
+    std::ifstream in(trace_file);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    std::string trace = contents.str();
+
+    const char *expected[] = {"\"traceEvents\":[",
+                              "\"ph\":\"B\"",
+                              "\"ph\":\"E\"",
+                              "\"name\":\"producer\"",
+                              "\"name\":\"consumer\""};
+    for (const char *e : expected) {
+        if (trace.find(e) == std::string::npos) {
+            printf("Could not find %s in trace events:\n%s\n", e, trace.c_str());
+            return -1;
+        }
+    }
+
+    // Every begin event should be matched by an end event.
+    size_t begins = 0, ends = 0;
+    for (size_t p = 0; (p = trace.find("\"ph\":\"B\"", p)) != std::string::npos; p++) {
+        begins++;
+    }
+    for (size_t p = 0; (p = trace.find("\"ph\":\"E\"", p)) != std::string::npos; p++) {
+        ends++;
+    }
+    if (begins != ends) {
+        printf("Mismatched begin and end events: %d vs %d\n", (int)begins, (int)ends);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "Halide.h"
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support running pipelines on other threads.\n");
+        return 0;
+    }
+
+    const int W = 500, H = 300;
+
+    // A separable blur of a streamed input, plus a small input that
+    // stays bound the whole time.
+    ImageParam input(Int(32), 2, "input");
+    Buffer<int> weights(3);
+    weights(0) = 1;
+    weights(1) = 2;
+    weights(2) = 1;
+
+    Var x("x"), y("y");
+    Func blur_x("blur_x"), blur_y("blur_y");
+    blur_x(x, y) = (weights(0) * input(x - 1, y) +
+                    weights(1) * input(x, y) +
+                    weights(2) * input(x + 1, y));
+    blur_y(x, y) = (weights(0) * blur_x(x, y - 1) +
+                    weights(1) * blur_x(x, y) +
+                    weights(2) * blur_x(x, y + 1));
+    blur_x.compute_at(blur_y, y);
+
+    // The input is computed on demand, so it never exists in full.
+    auto input_value = [](int x, int y) {
+        return x * 7 + y * 13;
+    };
+
+    // The reference, computed in one go.
+    Buffer<int> full_input(W + 2, H + 2);
+    full_input.set_min(-1, -1);
+    full_input.for_each_element([&](int x, int y) {
+        full_input(x, y) = input_value(x, y);
+    });
+    input.set(full_input);
+    Buffer<int> correct = blur_y.realize({W, H}, target);
+    input.reset();
+
+    const int tile_w = 128, tile_h = 64;
+    std::atomic<int> reads{0};
+    std::atomic<size_t> max_region{0};
+    std::mutex write_mutex;
+    int writes = 0;
+    Buffer<int> output(W, H);
+    output.fill(-1);
+
+    Pipeline p(blur_y);
+    p.realize_tiled(
+        {W, H}, {tile_w, tile_h}, {input},
+        [&](const ImageParam &param, Buffer<> &region) {
+            if (param.name() != input.name()) {
+                printf("Asked to read %s\n", param.name().c_str());
+                exit(-1);
+            }
+            Buffer<int> r = region;
+            r.for_each_element([&](int x, int y) {
+                r(x, y) = input_value(x, y);
+            });
+            reads++;
+            size_t n = r.number_of_elements();
+            size_t m = max_region.load();
+            while (n > m && !max_region.compare_exchange_weak(m, n)) {
+            }
+        },
+        [&](Realization &tile) {
+            std::lock_guard<std::mutex> lock(write_mutex);
+            Buffer<int> t = tile[0];
+            if (t.width() != tile_w || t.height() != tile_h) {
+                printf("Tile was %d x %d instead of %d x %d\n", t.width(), t.height(), tile_w, tile_h);
+                exit(-1);
+            }
+            // copy_from only copies the region the two have in common.
+            output.copy_from(t);
+            writes++;
+        },
+        target);
+
+    // 4 x 5 tiles, the last ones in each dimension shifted inwards.
+    if (writes != 20 || reads != 20) {
+        printf("Expected 20 tiles, but got %d writes and %d reads\n", writes, reads.load());
+        return -1;
+    }
+
+    // Each read should cover just a tile plus the blur's footprint.
+    if (max_region > (size_t)(tile_w + 2) * (tile_h + 2)) {
+        printf("Read a region of %d pixels, larger than a tile plus its halo\n", (int)max_region);
+        return -1;
+    }
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (output(x, y) != correct(x, y)) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), correct(x, y));
+                return -1;
+            }
+        }
+    }
+
+    // The input should not have been left bound.
+    if (input.get().defined()) {
+        printf("realize_tiled bound the streamed input\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,166 @@
+#include "Halide.h"
+
+#include <map>
+#include <stdio.h>
+
+using namespace Halide;
+
+int mallocs = 0;
+size_t live_bytes = 0, peak_bytes = 0;
+std::map<void *, size_t> allocation_sizes;
+
+void *my_malloc(void *user_context, size_t x) {
+    mallocs++;
+    live_bytes += x;
+    peak_bytes = std::max(peak_bytes, live_bytes);
+    void *orig = malloc(x + 32);
+    void *ptr = (void *)((((size_t)orig + 32) >> 5) << 5);
+    ((void **)ptr)[-1] = orig;
+    allocation_sizes[ptr] = x;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    live_bytes -= allocation_sizes[ptr];
+    allocation_sizes.erase(ptr);
+    free(((void **)ptr)[-1]);
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support set_custom_allocator().\n");
+        return 0;
+    }
+
+    const int W = 1000, H = 100;
+
+    {
+        // A chain of compute_root stencils, each of which is slightly
+        // smaller than the last. Each stage is freed once the next one
+        // has been computed, so the stages can take turns using two
+        // buffers.
+        const int stages = 6;
+        Var x, y;
+        std::vector<Func> f(stages);
+        f[0](x, y) = x + y;
+        for (int i = 1; i < stages; i++) {
+            f[i](x, y) = f[i - 1](x - 1, y) + f[i - 1](x + 1, y);
+            f[i - 1].compute_root();
+        }
+        Func out;
+        out(x, y) = f[stages - 1](x, y);
+        f[stages - 1].compute_root();
+
+        out.set_custom_allocator(my_malloc, my_free);
+        Buffer<int> result = out.realize({W, H});
+
+        if (mallocs != 2) {
+            printf("There were %d mallocs instead of 2\n", mallocs);
+            return -1;
+        }
+
+        // The two buffers are the two largest stages.
+        size_t expected_peak = (size_t)((W + 10) + (W + 8)) * H * sizeof(int);
+        if (peak_bytes > expected_peak + 2 * 128) {
+            printf("Peak memory use was %d bytes instead of %d\n", (int)peak_bytes, (int)expected_peak);
+            return -1;
+        }
+
+        for (int j = 0; j < H; j++) {
+            for (int i = 0; i < W; i++) {
+                // Each stage doubles the sum, and shifts symmetrically.
+                int correct = 32 * (i + j);
+                if (result(i, j) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // Stages that grow can't reuse the storage of the smaller
+        // ones without increasing the peak memory use.
+        mallocs = 0;
+        Var x, y;
+        Func f0, f1, f2, out;
+        f0(x, y) = x + y;
+        f1(x, y) = f0(x / 2, y) + 1;
+        f2(x, y) = f1(x / 2, y) + 1;
+        out(x, y) = f2(x, y);
+        f0.compute_root();
+        f1.compute_root();
+        f2.compute_root();
+
+        out.set_custom_allocator(my_malloc, my_free);
+        Buffer<int> result = out.realize({W, H});
+
+        if (mallocs != 3) {
+            printf("There were %d mallocs instead of 3\n", mallocs);
+            return -1;
+        }
+
+        for (int j = 0; j < H; j++) {
+            for (int i = 0; i < W; i++) {
+                int correct = i / 4 + j + 2;
+                if (result(i, j) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    {
+        // a and b are the same size, c is twice as large, and d is half
+        // the size. d fits in the storage of a, but c is allocated after
+        // a is freed and before d, so keeping a alive for d would raise
+        // the peak memory use. d must use the storage of b instead.
+        mallocs = 0;
+        peak_bytes = live_bytes;
+        Var x, y;
+        Func a, b, c, d, out;
+        a(x, y) = x + y;
+        b(x, y) = a(x, y) * 2;
+        c(x, y) = b(x / 2, y);
+        d(x, y) = c(4 * x, y) + c(4 * x + 1, y);
+        out(x, y) = d(x, y);
+        a.compute_root();
+        b.compute_root();
+        c.compute_root();
+        d.compute_root();
+
+        out.set_custom_allocator(my_malloc, my_free);
+        Buffer<int> result = out.realize({W, H});
+
+        if (mallocs != 3) {
+            printf("There were %d mallocs instead of 3\n", mallocs);
+            return -1;
+        }
+
+        // Without reuse, the peak is when b and c are both alive.
+        size_t expected_peak = (size_t)((2 * W - 1) + (4 * W - 2)) * H * sizeof(int);
+        if (peak_bytes > expected_peak + 2 * 128) {
+            printf("Peak memory use was %d bytes instead of %d\n", (int)peak_bytes, (int)expected_peak);
+            return -1;
+        }
+
+        for (int j = 0; j < H; j++) {
+            for (int i = 0; i < W; i++) {
+                int correct = 2 * ((2 * i + j) + (2 * i + j));
+                if (result(i, j) != correct) {
+                    printf("result(%d, %d) = %d instead of %d\n", i, j, result(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    if (live_bytes != 0) {
+        printf("%d bytes were not freed\n", (int)live_bytes);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -26,8 +26,16 @@ public:
     SimdOpCheck(Target t, int w = 768, int h = 128)
         : SimdOpCheckTest(t, w, h) {
         // We only test the skylake variant of avx512 here
-        use_avx512 = (target.has_feature(Target::AVX512_Cannonlake) ||
-                      target.has_feature(Target::AVX512_Skylake));
+        use_avx512 = target.features_any_of({Target::AVX512_Cannonlake,
+                                             Target::AVX512_Skylake,
+                                             Target::AVX512_Cascadelake,
+                                             Target::AVX512_Cooperlake,
+                                             Target::AVX512_SapphireRapids});
+        use_avx512_vnni = target.features_any_of({Target::AVX512_Cascadelake,
+                                                  Target::AVX512_Cooperlake,
+                                                  Target::AVX512_SapphireRapids});
+        use_avx512_bf16 = target.features_any_of({Target::AVX512_Cooperlake,
+                                                  Target::AVX512_SapphireRapids});
         if (target.has_feature(Target::AVX512) && !use_avx512) {
             std::cerr << "Warning: This test is only configured for the skylake variant of avx512. Expect failures\n";
         }
@@ -507,6 +515,28 @@ public:
             check("vpmaxsq", 8, max(i64_1, i64_2));
             check("vpminsq", 8, min(i64_1, i64_2));
         }
+        if (use_avx512_vnni) {
+            // Dot products of unsigned and signed bytes
+            RDom r4(0, 4);
+            check("vpdpbusd*zmm", 16, sum(i32(in_u8(4 * x + r4)) * in_i8(4 * x + r4 + 32)));
+            check("vpdpbusd*zmm", 16, sum(i32(in_i8(4 * x + r4)) * in_u8(4 * x + r4 + 32)));
+            check("vpdpbusd*ymm", 8, sum(i32(in_u8(4 * x + r4)) * in_i8(4 * x + r4 + 32)));
+            check("vpdpbusd*xmm", 4, sum(i32(in_u8(4 * x + r4)) * in_i8(4 * x + r4 + 32)));
+            RDom r8(0, 8);
+            check("vpdpbusd*zmm", 16, sum(i32(in_u8(8 * x + r8)) * in_i8(8 * x + r8 + 32)));
+
+            // Dot products of pairs of signed 16-bit values, when
+            // there's something to accumulate into
+            RDom r2(0, 2);
+            check("vpdpwssd*zmm", 16, sum(i32(in_i16(2 * x + r2)) * in_i16(2 * x + r2 + 32)));
+            check("vpdpwssd*ymm", 8, sum(i32(in_i16(2 * x + r2)) * in_i16(2 * x + r2 + 32)));
+        }
+        if (use_avx512_bf16) {
+            RDom r2(0, 2);
+            check("vdpbf16ps*zmm", 16, sum(f32(in_bf16(2 * x + r2)) * in_bf16(2 * x + r2 + 32)));
+            check("vdpbf16ps*ymm", 8, sum(f32(in_bf16(2 * x + r2)) * in_bf16(2 * x + r2 + 32)));
+            check("vdpbf16ps*xmm", 4, sum(f32(in_bf16(2 * x + r2)) * in_bf16(2 * x + r2 + 32)));
+        }
     }
 
     void check_neon_all() {
@@ -1877,6 +1907,8 @@ public:
 private:
     bool use_avx2{false};
     bool use_avx512{false};
+    bool use_avx512_bf16{false};
+    bool use_avx512_vnni{false};
     bool use_avx{false};
     bool use_power_arch_2_07{false};
     bool use_sse41{false};
@@ -37,9 +37,10 @@ public:
     ImageParam in_u32{UInt(32), 1, "in_u32"};
     ImageParam in_i64{Int(64), 1, "in_i64"};
     ImageParam in_u64{UInt(64), 1, "in_u64"};
+    ImageParam in_bf16{BFloat(16), 1, "in_bf16"};
 
-    const std::vector<ImageParam> image_params{in_f32, in_f64, in_i8, in_u8, in_i16, in_u16, in_i32, in_u32, in_i64, in_u64};
-    const std::vector<Argument> arg_types{in_f32, in_f64, in_i8, in_u8, in_i16, in_u16, in_i32, in_u32, in_i64, in_u64};
+    const std::vector<ImageParam> image_params{in_f32, in_f64, in_i8, in_u8, in_i16, in_u16, in_i32, in_u32, in_i64, in_u64, in_bf16};
+    const std::vector<Argument> arg_types{in_f32, in_f64, in_i8, in_u8, in_i16, in_u16, in_i32, in_u32, in_i64, in_u64, in_bf16};
     int W;
     int H;
 
@@ -76,6 +77,8 @@ public:
         // compiled code and the host in order to run the code.
         for (Target::Feature f : {Target::SSE41, Target::AVX,
                                   Target::AVX2, Target::AVX512,
+                                  Target::AVX512_Cascadelake, Target::AVX512_Cooperlake,
+                                  Target::AVX512_SapphireRapids,
                                   Target::FMA, Target::FMA4, Target::F16C,
                                   Target::VSX, Target::POWER_ARCH_2_07,
                                   Target::ARMv7s, Target::NoNEON,
@@ -239,6 +242,8 @@ public:
                     buf.as<float>().for_each_value([&](float &f) { f = (rng() & 0xfff) / 8.0f - 0xff; });
                 } else if (t == Float(64)) {
                     buf.as<double>().for_each_value([&](double &f) { f = (rng() & 0xfff) / 8.0 - 0xff; });
+                } else if (t == BFloat(16)) {
+                    buf.as<bfloat16_t>().for_each_value([&](bfloat16_t &f) { f = bfloat16_t((rng() & 0xff) / 8.0f - 0xf); });
                 } else {
                     // Random bits is fine
                     for (uint32_t *ptr = (uint32_t *)buf.data();
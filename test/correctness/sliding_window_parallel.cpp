@@ -0,0 +1,101 @@
+#include "Halide.h"
+
+#include <atomic>
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+std::atomic<int> count{0};
+extern "C" DLLEXPORT int call_counter(int x, int y) {
+    count++;
+    return x * 3 + y;
+}
+HalideExtern_2(int, call_counter, int, int);
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("[SKIP] WebAssembly JIT does not support extern calls from parallel loops.\n");
+        return 0;
+    }
+
+    const int W = 100, H = 64, strip = 16;
+
+    for (bool store_root : {true, false}) {
+        Var x, y, yo, yi;
+        Func f, g;
+        f(x, y) = call_counter(x, y);
+        g(x, y) = f(x, y - 1) + f(x, y) + f(x, y + 1);
+
+        g.split(y, yo, yi, strip).parallel(yo);
+        if (store_root) {
+            // Stored outside the parallel loop, so the storage gets
+            // moved inside it, and f slides within each strip.
+            f.store_root().compute_at(g, yi);
+        } else {
+            f.store_at(g, yo).compute_at(g, yi);
+        }
+
+        count = 0;
+        Buffer<int> out = g.realize({W, H});
+
+        // Each strip computes two extra rows of warm-up, and then one
+        // new row per row of output.
+        int expected = (H / strip) * (strip + 2) * W;
+        if (count != expected) {
+            printf("f was called %d times instead of %d times\n", count.load(), expected);
+            return -1;
+        }
+
+        for (int j = 0; j < H; j++) {
+            for (int i = 0; i < W; i++) {
+                int correct = 3 * (i * 3 + j);
+                if (out(i, j) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", i, j, out(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    // The same thing, with the parallel strips one level further out
+    // than the compute_at and a vectorized inner loop.
+    {
+        Var x, y, yo, yi, xo, xi;
+        Func f, g, h;
+        f(x, y) = call_counter(x, y);
+        g(x, y) = f(x, y - 1) + f(x, y) + f(x, y + 1);
+        h(x, y) = g(x, y);
+
+        h.split(y, yo, yi, strip).parallel(yo);
+        g.compute_at(h, yi).vectorize(x, 4);
+        f.store_root().compute_at(g, y).vectorize(x, 4);
+
+        count = 0;
+        Buffer<int> out = h.realize({W, H});
+
+        int expected = (H / strip) * (strip + 2) * W;
+        if (count != expected) {
+            printf("f was called %d times instead of %d times\n", count.load(), expected);
+            return -1;
+        }
+
+        for (int j = 0; j < H; j++) {
+            for (int i = 0; i < W; i++) {
+                int correct = 3 * (i * 3 + j);
+                if (out(i, j) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", i, j, out(i, j), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -550,6 +550,48 @@ int main(int argc, char **argv) {
         Buffer<int> im = output.realize(64, 64);
     }
 
+    for (int radius : {5, 3000}) {
+        custom_malloc_size = 0;
+        Param<int> p;
+        Func f, g;
+        RDom r(0, p + 1);
+
+        f(x, y) = x + y;
+        g(x, y) = sum(f(x, y + r));
+        f.store_root().compute_at(g, y);
+
+        // The footprint of f in y depends on a parameter, so can't be
+        // bounded at compile time. It should be folded by a factor
+        // computed at runtime, unless that factor isn't smaller than
+        // the whole realization.
+
+        g.set_custom_allocator(my_malloc, my_free);
+
+        p.set(radius);
+        Buffer<int> im = g.realize(100, 1000);
+
+        size_t expected_size;
+        if (radius == 5) {
+            expected_size = 100 * 8 * sizeof(int) + sizeof(int);
+        } else {
+            expected_size = 100 * (1000 + radius) * sizeof(int) + sizeof(int);
+        }
+        if (custom_malloc_size == 0 || custom_malloc_size != expected_size) {
+            printf("Scratch space allocated was %d instead of %d\n", (int)custom_malloc_size, (int)expected_size);
+            return -1;
+        }
+
+        for (int y = 0; y < im.height(); y++) {
+            for (int x = 0; x < im.width(); x++) {
+                int correct = (radius + 1) * (x + y) + radius * (radius + 1) / 2;
+                if (im(x, y) != correct) {
+                    printf("im(%d, %d) = %d instead of %d\n", x, y, im(x, y), correct);
+                    return -1;
+                }
+            }
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -0,0 +1,47 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+#include "parallel_codegen.h"
+
+using namespace Halide::Runtime;
+
+const int W = 64, H = 32;
+
+int main(int argc, char **argv) {
+    Buffer<float> input(W + 2, H + 2);
+    input.set_min(-1, -1);
+    input.for_each_element([&](int x, int y) {
+        input(x, y) = (float)(x * 3 + y * 7) / 16.0f;
+    });
+
+    // Run it twice, the second time out of the cache.
+    for (int i = 0; i < 2; i++) {
+        Buffer<float> output(W, H);
+        int result = parallel_codegen(input, output);
+        if (result != 0) {
+            fprintf(stderr, "parallel_codegen failed: %d\n", result);
+            return 1;
+        }
+
+        auto g = [&](int x, int y) {
+            return sinf(input(x - 1, y)) + sinf(input(x + 1, y));
+        };
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                float expected = g(x, y - 1) * g(x, y + 1);
+                float actual = output(x, y);
+                if (fabsf(expected - actual) > 1e-4f) {
+                    fprintf(stderr, "output(%d, %d) was %f instead of %f\n", x, y, actual, expected);
+                    return 1;
+                }
+            }
+        }
+    }
+
+    halide_memoization_cache_cleanup();
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "Halide.h"
+
+#include <stdlib.h>
+
+namespace {
+
+// Split the code generation across several objects, for both the
+// pipeline and the runtime generated from this generator. It has to be
+// set before the generator runs, as the runtime is generated without
+// calling generate().
+int set_codegen_jobs() {
+#ifdef _WIN32
+    _putenv_s("HL_LLVM_CODEGEN_JOBS", "4");
+#else
+    setenv("HL_LLVM_CODEGEN_JOBS", "4", 1);
+#endif
+    return 0;
+}
+const int codegen_jobs_set = set_codegen_jobs();
+
+class ParallelCodegen : public Halide::Generator<ParallelCodegen> {
+public:
+    Input<Buffer<float>> input{"input", 2};
+    Output<Buffer<float>> output{"output", 2};
+
+    void generate() {
+        // Several parallel loops, so that there are several closures to
+        // spread across the partitions, along with the runtime. The
+        // memoized stage brings in the cache, which has a destructor.
+        Var x("x"), y("y");
+        Func f("f"), g("g");
+        f(x, y) = sin(input(x, y));
+        g(x, y) = f(x - 1, y) + f(x + 1, y);
+        output(x, y) = g(x, y - 1) * g(x, y + 1);
+
+        f.compute_root().parallel(y).vectorize(x, 8);
+        g.compute_root().memoize().parallel(y).vectorize(x, 8);
+        output.parallel(y).vectorize(x, 8);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(ParallelCodegen, parallel_codegen)
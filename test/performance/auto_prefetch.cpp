@@ -0,0 +1,87 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include <cstdio>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Compare each pipeline compiled with and without Target::AutoPrefetch.
+bool compare(const char *name, Func f, const Target &t, int w, int h) {
+    Buffer<float> out(w, h);
+    Buffer<float> out_prefetched(w, h);
+
+    f.compile_jit(t);
+    double t_plain = benchmark(10, 1, [&]() { f.realize(out); });
+
+    f.compile_jit(t.with_feature(Target::AutoPrefetch));
+    double t_prefetched = benchmark(10, 1, [&]() { f.realize(out_prefetched); });
+
+    printf("%s: %f ms without prefetching, %f ms with automatic prefetching\n",
+           name, t_plain * 1e3, t_prefetched * 1e3);
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (out(x, y) != out_prefetched(x, y)) {
+                printf("%s: out(%d, %d) = %f with prefetching instead of %f\n",
+                       name, x, y, out_prefetched(x, y), out(x, y));
+                return false;
+            }
+        }
+    }
+
+    // Prefetching shouldn't make things much worse, even on machines
+    // where the hardware prefetchers already cope.
+    if (t_prefetched > 1.5 * t_plain) {
+        printf("%s: automatic prefetching made things slower\n", name);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    const int size = 4096;
+    Buffer<float> input(size, size);
+    input.for_each_element([&](int x, int y) {
+        input(x, y) = (float)((x * 17 + y * 31) % 1024);
+    });
+
+    Var x("x"), y("y");
+
+    {
+        // A naive transpose: each iteration of the inner loop reads
+        // from a different row of the input.
+        Func transpose("transpose");
+        transpose(x, y) = input(y, x);
+        if (!compare("transpose", transpose, target, size, size)) {
+            return -1;
+        }
+    }
+
+    {
+        // A strided gather over columns, with a little arithmetic.
+        Func gather("gather");
+        gather(x, y) = input(y, x * 7) * 0.5f + input(y, x * 7 + 1);
+        if (!compare("strided gather", gather, target, size / 8, size)) {
+            return -1;
+        }
+    }
+
+    {
+        // A row-wise copy, which shouldn't get any prefetches.
+        Func copy("copy");
+        copy(x, y) = input(x, y) + 1.0f;
+        if (!compare("copy", copy, target, size, size)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
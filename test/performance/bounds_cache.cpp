@@ -0,0 +1,217 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+
+using namespace Halide;
+using namespace Halide::Internal;
+using namespace Halide::Tools;
+
+namespace {
+
+// Exposes the data the JSONCompilerLogger gathered.
+class PassLogger : public JSONCompilerLogger {
+public:
+    using JSONCompilerLogger::compilation_time;
+};
+
+// A chain of stencils, each computed at the tiles of the next one, so
+// that the loop nests get deep.
+Pipeline make_pipeline(ImageParam input, int stages) {
+    Var x("x"), y("y"), xo("xo"), yo("yo"), xi("xi"), yi("yi");
+    std::vector<Func> f(stages);
+    f[0](x, y) = input(x, y);
+    for (int i = 1; i < stages; i++) {
+        f[i](x, y) = f[i - 1](x - 1, y) + f[i - 1](x, y + 1) + f[i - 1](x + 1, y - 1);
+    }
+    Func output = f[stages - 1];
+    for (int i = stages - 2; i >= 0; i--) {
+        f[i + 1].tile(x, y, xo, yo, xi, yi, 8 + i, 8 + i);
+        f[i].compute_at(f[i + 1], xo);
+    }
+    return output;
+}
+
+// The loop bodies of a loop nest like the ones bounds inference sees.
+std::vector<Stmt> make_loop_bodies(int depth) {
+    std::vector<Func> f(depth);
+    std::vector<Var> v;
+    for (int i = 0; i < depth; i++) {
+        f[i] = Func("f" + std::to_string(i));
+        v.emplace_back("v" + std::to_string(i));
+    }
+    Var x("x");
+    for (int i = 0; i < depth; i++) {
+        f[i](x) = x;
+    }
+
+    Expr e = 0;
+    for (int i = 0; i < depth; i++) {
+        e += f[i](v[i] * 2 + v[(i + 1) % depth] - 1) * f[(i + 1) % depth](v[i] + 3);
+    }
+    Stmt s = Evaluate::make(e);
+
+    std::vector<Stmt> bodies;
+    for (int i = depth - 1; i >= 0; i--) {
+        bodies.push_back(s);
+        std::string name = v[i].name();
+        s = LetStmt::make(name + ".extent", 100 + i,
+                          For::make(name, 0, Variable::make(Int(32), name + ".extent"),
+                                    ForType::Serial, DeviceAPI::None, s));
+    }
+    bodies.push_back(s);
+    return bodies;
+}
+
+// Ask about the boxes touched by each loop body a few times, as the
+// lowering passes do.
+double query_boxes(const std::vector<Stmt> &bodies, std::vector<std::map<std::string, Box>> *boxes) {
+    return benchmark(3, 1, [&]() {
+        boxes->clear();
+        for (int i = 0; i < 3; i++) {
+            for (const Stmt &s : bodies) {
+                boxes->push_back(boxes_required(s));
+                boxes->push_back(boxes_provided(s));
+            }
+        }
+    });
+}
+
+// Lets in boxes get unique names, which differ from one query to the
+// next, so rename them in order of appearance before comparing.
+class CanonicalLetNames : public IRMutator {
+    using IRMutator::visit;
+
+    std::map<std::string, std::string> names;
+    int counter = 0;
+
+    Expr visit(const Let *op) override {
+        Expr value = mutate(op->value);
+        std::string name = "t" + std::to_string(counter++);
+        std::map<std::string, std::string> old_names = names;
+        names[op->name] = name;
+        Expr body = mutate(op->body);
+        names = old_names;
+        return Let::make(name, value, body);
+    }
+
+    Expr visit(const Variable *op) override {
+        auto it = names.find(op->name);
+        if (it == names.end()) {
+            return op;
+        }
+        return Variable::make(op->type, it->second);
+    }
+};
+
+bool same_expr(const Expr &a, const Expr &b) {
+    if (!a.defined() || !b.defined()) {
+        return a.defined() == b.defined();
+    }
+    return equal(CanonicalLetNames().mutate(a), CanonicalLetNames().mutate(b));
+}
+
+bool same_boxes(const std::map<std::string, Box> &a, const std::map<std::string, Box> &b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (const auto &it : a) {
+        auto other = b.find(it.first);
+        if (other == b.end() ||
+            it.second.size() != other->second.size() ||
+            !same_expr(it.second.used, other->second.used)) {
+            return false;
+        }
+        for (size_t i = 0; i < it.second.size(); i++) {
+            if (!same_expr(it.second[i].min, other->second[i].min) ||
+                !same_expr(it.second[i].max, other->second[i].max)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void set_env(const char *name, const char *value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+// Lower a fresh deep compute_at nest, and return the time spent
+// lowering it, and in bounds queries.
+std::pair<double, double> lowering_time(const Target &target) {
+    set_compiler_logger(std::unique_ptr<CompilerLogger>(new PassLogger));
+
+    ImageParam input(Float(32), 2, "input");
+    make_pipeline(input, 10).compile_to_module({input}, "deep_compute_at", target);
+
+    std::unique_ptr<CompilerLogger> logger = set_compiler_logger(nullptr);
+    PassLogger *passes = (PassLogger *)logger.get();
+    return {passes->compilation_time[CompilerLogger::Phase::HalideLowering],
+            passes->compilation_time[CompilerLogger::Phase::BoundsInference]};
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    {
+        std::vector<Stmt> bodies = make_loop_bodies(12);
+        std::vector<std::map<std::string, Box>> boxes_uncached, boxes_cached;
+        double t_uncached = query_boxes(bodies, &boxes_uncached);
+        double t_cached;
+        {
+            ScopedBoxesCache cache;
+            t_cached = query_boxes(bodies, &boxes_cached);
+        }
+        printf("Boxes of %d loop bodies: %f ms without the cache, %f ms with it\n",
+               (int)bodies.size(), t_uncached * 1e3, t_cached * 1e3);
+
+        for (size_t i = 0; i < boxes_uncached.size(); i++) {
+            if (!same_boxes(boxes_cached[i], boxes_uncached[i])) {
+                printf("The cache changed the boxes of loop body %d\n", (int)(i / 2) % (int)bodies.size());
+                return -1;
+            }
+        }
+    }
+
+    {
+        // Computing the key of a query costs something even when it
+        // hits, so compare lowering as a whole with and without the
+        // cache.
+        set_env("HL_BOXES_CACHE", "0");
+        std::pair<double, double> uncached = lowering_time(target);
+        set_env("HL_BOXES_CACHE", "");
+
+        // lower() uses the cache we hold instead of making its own, so
+        // we can see how often it hit.
+        std::pair<double, double> cached;
+        int hits, misses;
+        {
+            ScopedBoxesCache cache;
+            cached = lowering_time(target);
+            hits = cache.hits();
+            misses = cache.misses();
+        }
+
+        printf("Lowering a deep compute_at nest took %f s without the cache (%f s of it in bounds queries), "
+               "and %f s with it (%f s)\n",
+               uncached.first, uncached.second, cached.first, cached.second);
+        printf("The cache answered %d of %d bounds queries (%.1f%%)\n",
+               hits, hits + misses, 100.0 * hits / std::max(1, hits + misses));
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include <cstdio>
+#include <functional>
+#include <sstream>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace Halide;
+using namespace Halide::Internal;
+using namespace Halide::Tools;
+
+namespace {
+
+#ifdef __linux__
+// Run the given function in a child process, and return the peak
+// resident set size of the child in KB, or -1 on failure. The peak never
+// goes down, so each configuration needs a fresh process.
+long peak_rss_kb_of(const std::function<void()> &fn) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        fn();
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        long kb = usage.ru_maxrss;
+        ssize_t written = write(fds[1], &kb, sizeof(kb));
+        _exit(written == sizeof(kb) ? 0 : 1);
+    }
+    close(fds[1]);
+    long kb = -1;
+    if (pid < 0 || read(fds[0], &kb, sizeof(kb)) != sizeof(kb)) {
+        kb = -1;
+    }
+    close(fds[0]);
+    if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+    }
+    return kb;
+}
+#endif
+
+// A pyramid of blurs, each computed at the tiles of the level above,
+// which makes plenty of constants and Variables while lowering.
+Pipeline make_pipeline(ImageParam input) {
+    const int levels = 8;
+    Var x("x"), y("y"), xo("xo"), yo("yo"), xi("xi"), yi("yi");
+    std::vector<Func> down(levels), up(levels);
+    down[0](x, y) = input(x, y);
+    for (int i = 1; i < levels; i++) {
+        down[i](x, y) = (down[i - 1](2 * x - 1, y) + 2 * down[i - 1](2 * x, y) + down[i - 1](2 * x + 1, y) +
+                         down[i - 1](2 * x, y - 1) + down[i - 1](2 * x, y + 1)) /
+                        6;
+    }
+    up[levels - 1] = down[levels - 1];
+    for (int i = levels - 2; i >= 0; i--) {
+        up[i](x, y) = (up[i + 1](x / 2, y / 2) + up[i + 1]((x + 1) / 2, (y + 1) / 2)) / 2 + down[i](x, y);
+    }
+    for (int i = 1; i < levels; i++) {
+        down[i].compute_root().tile(x, y, xo, yo, xi, yi, 32, 8).parallel(yo).vectorize(xi, 8);
+        up[i].compute_at(up[i - 1], yo).vectorize(x, 8);
+    }
+    up[0].tile(x, y, xo, yo, xi, yi, 64, 16).parallel(yo).vectorize(xi, 8);
+    return up[0];
+}
+
+std::string lowered_stmt(const Module &m) {
+    std::ostringstream str;
+    for (const auto &f : m.functions()) {
+        str << f.body;
+    }
+    return str.str();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    ImageParam input(Float(32), 2, "input");
+    Pipeline p = make_pipeline(input);
+
+    // Make the same names both times, so that the results are
+    // comparable.
+    const std::vector<int> names = ScopedUniqueNameCounters::snapshot();
+
+#ifdef __linux__
+    // Measure the memory use first, so that the child processes start
+    // out as small as possible.
+    long rss_plain = peak_rss_kb_of([&]() {
+        ScopedUniqueNameCounters counters(names);
+        p.compile_to_module({input}, "pyramid", target);
+    });
+    long rss_interned = peak_rss_kb_of([&]() {
+        ScopedUniqueNameCounters counters(names);
+        ScopedIRInterning interning;
+        p.compile_to_module({input}, "pyramid", target);
+    });
+    printf("Peak RSS of a process lowering the pipeline: %ld KB without interning, %ld KB with it\n",
+           rss_plain, rss_interned);
+#endif
+
+    std::string plain, interned;
+    double t_plain = benchmark(3, 1, [&]() {
+        ScopedUniqueNameCounters counters(names);
+        plain = lowered_stmt(p.compile_to_module({input}, "pyramid", target));
+    });
+
+    double t_interned = benchmark(3, 1, [&]() {
+        ScopedUniqueNameCounters counters(names);
+        ScopedIRInterning interning;
+        interned = lowered_stmt(p.compile_to_module({input}, "pyramid", target));
+    });
+
+    printf("Lowering took %f ms without interning, %f ms with it\n", t_plain * 1e3, t_interned * 1e3);
+
+    if (plain != interned) {
+        printf("Interning changed the lowered Stmt\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include "halide_image_io_mmap.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    // A 64MB tensor. .tmp files are always four-dimensional.
+    Buffer<float> buf(2048, 2048, 4, 1);
+    buf.for_each_element([&](int x, int y, int c, int w) {
+        buf(x, y, c, w) = (float)(x + y * c);
+    });
+
+    for (std::string format : {"tmp", "npy"}) {
+        std::string filename = Internal::get_test_tmp_dir() + "halide_test_performance_load_mapped_image." + format;
+        Tools::save_image(buf, filename);
+
+        double t_load = Tools::benchmark(5, 1, [&]() {
+            Buffer<float> im = Tools::load_image(filename);
+        });
+
+        double t_mapped = Tools::benchmark(5, 1, [&]() {
+            Buffer<float> im;
+            std::shared_ptr<void> mapping;
+            if (!Tools::load_mapped(filename, &im, &mapping) || !mapping) {
+                printf("Could not map %s\n", filename.c_str());
+                exit(-1);
+            }
+        });
+
+        // Mapping only defers the reads, so also measure the cost of
+        // mapping and then touching every pixel.
+        float sum = 0;
+        double t_mapped_and_read = Tools::benchmark(5, 1, [&]() {
+            Buffer<float> im;
+            std::shared_ptr<void> mapping;
+            Tools::load_mapped(filename, &im, &mapping);
+            im.for_each_value([&](float v) { sum += v; });
+        });
+
+        printf("%s: load: %f ms, load_mapped: %f ms, load_mapped and read: %f ms (%f)\n",
+               format.c_str(), t_load * 1e3, t_mapped * 1e3, t_mapped_and_read * 1e3, sum);
+
+        if (t_mapped > t_load) {
+            printf("load_mapped should be faster than load\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "Halide.h"
+
+#include <algorithm>
+#include <cstdio>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+namespace {
+
+// Exposes the data the JSONCompilerLogger gathered.
+class PassLogger : public JSONCompilerLogger {
+public:
+    using JSONCompilerLogger::compilation_time;
+    using JSONCompilerLogger::lowering_passes;
+};
+
+Var x("x"), y("y"), k("k");
+
+Func downsample(Func f) {
+    Func downx, downy;
+    downx(x, y, _) = (f(2 * x - 1, y, _) + 3.0f * (f(2 * x, y, _) + f(2 * x + 1, y, _)) + f(2 * x + 2, y, _)) / 8.0f;
+    downy(x, y, _) = (downx(x, 2 * y - 1, _) + 3.0f * (downx(x, 2 * y, _) + downx(x, 2 * y + 1, _)) + downx(x, 2 * y + 2, _)) / 8.0f;
+    return downy;
+}
+
+Func upsample(Func f) {
+    Func upx, upy;
+    upx(x, y, _) = lerp(f((x + 1) / 2, y, _), f((x - 1) / 2, y, _), ((x % 2) * 2 + 1) / 4.0f);
+    upy(x, y, _) = lerp(upx(x, (y + 1) / 2, _), upx(x, (y - 1) / 2, _), ((y % 2) * 2 + 1) / 4.0f);
+    return upy;
+}
+
+// A cut-down version of apps/local_laplacian, which spends a
+// representative amount of time in most of the lowering passes.
+Pipeline make_pipeline(ImageParam input) {
+    const int J = 8;
+    const int levels = 8;
+
+    Func clamped = BoundaryConditions::repeat_edge(input);
+    Func gray;
+    gray(x, y) = clamped(x, y) / 65535.0f;
+
+    Func gPyramid[J], lPyramid[J], inGPyramid[J], outLPyramid[J], outGPyramid[J];
+    Expr level = k * (1.0f / (levels - 1));
+    gPyramid[0](x, y, k) = 0.5f * (gray(x, y) - level) + level;
+    inGPyramid[0](x, y) = gray(x, y);
+    for (int j = 1; j < J; j++) {
+        gPyramid[j](x, y, k) = downsample(gPyramid[j - 1])(x, y, k);
+        inGPyramid[j](x, y) = downsample(inGPyramid[j - 1])(x, y);
+    }
+    lPyramid[J - 1](x, y, k) = gPyramid[J - 1](x, y, k);
+    for (int j = J - 2; j >= 0; j--) {
+        lPyramid[j](x, y, k) = gPyramid[j](x, y, k) - upsample(gPyramid[j + 1])(x, y, k);
+    }
+    for (int j = 0; j < J; j++) {
+        Expr l = inGPyramid[j](x, y) * (levels - 1);
+        Expr li = clamp(cast<int>(l), 0, levels - 2);
+        Expr lf = l - li;
+        outLPyramid[j](x, y) = (1.0f - lf) * lPyramid[j](x, y, li) + lf * lPyramid[j](x, y, li + 1);
+    }
+    outGPyramid[J - 1](x, y) = outLPyramid[J - 1](x, y);
+    for (int j = J - 2; j >= 0; j--) {
+        outGPyramid[j](x, y) = upsample(outGPyramid[j + 1])(x, y) + outLPyramid[j](x, y);
+    }
+    Func output;
+    output(x, y) = cast<uint16_t>(clamp(outGPyramid[0](x, y), 0.0f, 1.0f) * 65535.0f);
+
+    Var yo("yo"), yi("yi");
+    output.split(y, yo, yi, 32).parallel(yo).vectorize(x, 8);
+    gray.compute_at(output, yo).vectorize(x, 8);
+    for (int j = 0; j < J; j++) {
+        Func fs[] = {gPyramid[j], lPyramid[j], inGPyramid[j], outGPyramid[j]};
+        for (Func f : fs) {
+            if (j < 4) {
+                f.compute_at(output, yo).store_at(output, yo).vectorize(x, 8);
+            } else {
+                f.compute_root().parallel(y).vectorize(x, 8);
+            }
+        }
+    }
+
+    return output;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    set_compiler_logger(std::unique_ptr<CompilerLogger>(new PassLogger));
+
+    ImageParam input(UInt(16), 2, "input");
+    make_pipeline(input).compile_to_module({input}, "local_laplacian", target);
+
+    std::unique_ptr<CompilerLogger> logger = set_compiler_logger(nullptr);
+    PassLogger *passes = (PassLogger *)logger.get();
+
+    if (passes->lowering_passes.size() < 30) {
+        printf("Expected at least 30 lowering passes, got %d\n", (int)passes->lowering_passes.size());
+        return -1;
+    }
+
+    double total = 0;
+    for (const auto &p : passes->lowering_passes) {
+        if (p.duration < 0 || p.ir_nodes == 0) {
+            printf("Bad record for lowering pass %s: %f s, %d nodes\n", p.name.c_str(), p.duration, (int)p.ir_nodes);
+            return -1;
+        }
+        total += p.duration;
+    }
+
+    const double lowering = passes->compilation_time[CompilerLogger::Phase::HalideLowering];
+    const double simplifier = passes->compilation_time[CompilerLogger::Phase::Simplifier];
+    const double bounds = passes->compilation_time[CompilerLogger::Phase::BoundsInference];
+    if (total > lowering || simplifier <= 0 || simplifier > lowering || bounds <= 0 || bounds > lowering) {
+        printf("Inconsistent compilation times: lowering %f, passes %f, simplifier %f, bounds inference %f\n",
+               lowering, total, simplifier, bounds);
+        return -1;
+    }
+
+    // Print the slowest few passes.
+    auto sorted = passes->lowering_passes;
+    std::sort(sorted.begin(), sorted.end(), [](const auto &a, const auto &b) {
+        return a.duration > b.duration;
+    });
+    printf("Lowering took %f s: %f s in the simplifier, %f s in bounds queries\n", lowering, simplifier, bounds);
+    for (size_t i = 0; i < std::min(sorted.size(), (size_t)8); i++) {
+        printf("  %-50s %10f s %10d IR nodes\n", sorted[i].name.c_str(), sorted[i].duration, (int)sorted[i].ir_nodes);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "Halide.h"
+#include "halide_test_dirs.h"
+
+#include <chrono>
+#include <cstdio>
+
+using namespace Halide;
+
+namespace {
+
+// Builds a fresh pipeline every time, so that it's safe to call from
+// several threads at once.
+Module make_module(const std::string &fn_name, const Target &target) {
+    ImageParam input(Float(32), 2, "input");
+    Var x("x"), y("y");
+
+    Func clamped = BoundaryConditions::repeat_edge(input);
+    Func blur = clamped;
+    for (int i = 0; i < 8; i++) {
+        Func next("blur_" + std::to_string(i));
+        if (i % 2 == 0) {
+            next(x, y) = (blur(x - 1, y) + blur(x, y) * 2 + blur(x + 1, y)) / 4;
+        } else {
+            next(x, y) = (blur(x, y - 1) + blur(x, y) * 2 + blur(x, y + 1)) / 4;
+        }
+        blur = next;
+    }
+    Func output("output");
+    output(x, y) = sqrt(blur(x, y)) + sin(input(x, y));
+
+    Var xi("xi"), yi("yi");
+    output.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8).parallel(y);
+    blur.compute_at(output, x).vectorize(x, 8);
+
+    return Pipeline(output).compile_to_module({input}, fn_name, target);
+}
+
+double compile(const std::string &fname, const std::vector<Target> &targets,
+               const std::vector<std::string> &suffixes, int num_jobs) {
+    const char *o = get_host_target().os == Target::Windows ? ".obj" : ".o";
+    std::map<Output, std::string> outputs = {{Output::object, fname + o}};
+    auto start = std::chrono::high_resolution_clock::now();
+    compile_multitarget("multitarget_compile", outputs, targets, suffixes, make_module, nullptr, num_jobs);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    std::vector<std::string> suffixes = {
+        "host-profile-no_bounds_query",
+        "host-profile",
+        "host-no_bounds_query",
+        "host",
+    };
+    std::vector<Target> targets;
+    for (const auto &s : suffixes) {
+        targets.emplace_back(s);
+    }
+
+    std::string serial = Internal::get_test_tmp_dir() + "halide_test_performance_multitarget_compile_serial";
+    std::string parallel = Internal::get_test_tmp_dir() + "halide_test_performance_multitarget_compile_parallel";
+
+    // Start both compiles with the same unique name counters, so that
+    // their outputs can be compared.
+    const std::vector<int> counters = Internal::ScopedUniqueNameCounters::snapshot();
+    double serial_time, parallel_time;
+    {
+        Internal::ScopedUniqueNameCounters names(counters);
+        serial_time = compile(serial, targets, suffixes, 1);
+    }
+    {
+        Internal::ScopedUniqueNameCounters names(counters);
+        parallel_time = compile(parallel, targets, suffixes, (int)targets.size());
+    }
+
+    printf("Compiling %d targets: %f s serially, %f s in parallel (%.2fx)\n",
+           (int)targets.size(), serial_time, parallel_time, serial_time / parallel_time);
+
+    // The output must not depend on the number of jobs.
+    const char *o = get_host_target().os == Target::Windows ? ".obj" : ".o";
+    std::vector<std::string> files = {"_runtime" + std::string(o), "_wrapper" + std::string(o)};
+    for (const auto &s : suffixes) {
+        files.push_back("-" + s + o);
+    }
+    for (const auto &f : files) {
+        std::vector<char> a = Internal::read_entire_file(serial + f);
+        std::vector<char> b = Internal::read_entire_file(parallel + f);
+        if (a != b) {
+            printf("%s differs between the serial and parallel compiles\n", f.c_str());
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
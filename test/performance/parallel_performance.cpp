@@ -1,6 +1,8 @@
 #include "Halide.h"
 #include "halide_benchmark.h"
 #include <cstdio>
+#include <cstdlib>
+#include <string>
 
 using namespace Halide;
 using namespace Halide::Tools;
@@ -8,6 +10,38 @@ using namespace Halide::Tools;
 #define W 1024
 #define H 160
 
+// Matches MAX_THREADS in src/runtime/thread_pool_common.h
+#define MAX_THREADS 256
+
+void set_env(const char *name, const std::string &value) {
+#ifdef _WIN32
+    _putenv_s(name, value.c_str());
+#else
+    setenv(name, value.c_str(), 1);
+#endif
+}
+
+// Time a finely split parallel loop with the given number of threads,
+// using either the job stack or the work-stealing scheduler, with or
+// without NUMA-aware thread pinning.
+double time_fine_grained_parallel_for(int threads, bool work_stealing, bool affinity) {
+    set_env("HL_NUM_THREADS", std::to_string(threads));
+    set_env("HL_WORK_STEALING", work_stealing ? "1" : "0");
+    set_env("HL_THREAD_AFFINITY", affinity ? "1" : "0");
+    Internal::JITSharedRuntime::release_all();
+
+    Var x, y;
+    Func f;
+    f(x, y) = cast<float>(x * y);
+    f.parallel(y);
+
+    Pipeline p(f);
+    p.compile_jit();
+    // One short row per task, so that claiming tasks dominates.
+    Buffer<float> out = p.realize(64, 16384);
+    return benchmark([&]() { p.realize(out); });
+}
+
 int main(int argc, char **argv) {
     Target target = get_jit_target_from_environment();
     if (target.arch == Target::WebAssembly) {
@@ -47,6 +81,16 @@ int main(int argc, char **argv) {
         }
     }
 
+    // Check how the task system scales with the number of threads
+    // when each task is tiny.
+    printf("Threads, job stack (ms), work stealing (ms), pinned work stealing (ms)\n");
+    for (int t = 1; t <= MAX_THREADS; t *= 2) {
+        double job_stack_time = time_fine_grained_parallel_for(t, false, false);
+        double work_stealing_time = time_fine_grained_parallel_for(t, true, false);
+        double pinned_time = time_fine_grained_parallel_for(t, true, true);
+        printf("%d, %f, %f, %f\n", t, job_stack_time * 1e3, work_stealing_time * 1e3, pinned_time * 1e3);
+    }
+
     printf("Times: %f %f\n", serialTime, parallelTime);
     double speedup = serialTime / parallelTime;
     printf("Speedup: %f\n", speedup);
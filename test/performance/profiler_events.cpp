@@ -0,0 +1,71 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Swallow the profiler's reports.
+void quiet_print(void *, const char *) {
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    std::string trace_file = Internal::get_test_tmp_dir() + "halide_test_performance_profiler_events.json";
+#ifdef _WIN32
+    _putenv_s("HL_PROFILER_TRACE_FILE", trace_file.c_str());
+#else
+    setenv("HL_PROFILER_TRACE_FILE", trace_file.c_str(), 1);
+#endif
+
+    // A chain of finely-interleaved Funcs in a parallel loop, so that
+    // every thread records lots of events.
+    const int stages = 10;
+    Func f[stages];
+    Var x("x"), y("y");
+    for (int i = 0; i < stages; i++) {
+        f[i] = Func("fn" + std::to_string(i));
+        if (i == 0) {
+            f[i](x, y) = cast<float>(x + y);
+        } else {
+            f[i](x, y) = sin(f[i - 1](x, y)) * 2.0f;
+        }
+    }
+    Func out = f[stages - 1];
+    out.parallel(y);
+    for (int i = 0; i < stages - 1; i++) {
+        f[i].compute_at(out, y);
+    }
+    out.set_custom_print(&quiet_print);
+
+    Buffer<float> im(1024, 1024);
+    double times[3];
+    const char *names[3] = {"without profiling", "with the sampling profiler", "with profiler events"};
+    Target targets[3] = {target,
+                         target.with_feature(Target::Profile),
+                         target.with_feature(Target::Profile).with_feature(Target::ProfileEvents)};
+    for (int i = 0; i < 3; i++) {
+        // Each realization reports, which in event mode includes
+        // writing out the trace, and then frees the event buffers.
+        out.compile_jit(targets[i]);
+        times[i] = benchmark(5, 5, [&]() {
+            out.realize(im, targets[i]);
+        });
+        printf("%s: %f ms\n", names[i], times[i] * 1e3);
+    }
+    printf("Recording events costs %.1f%% over the sampling profiler\n",
+           100.0 * (times[2] - times[1]) / times[1]);
+
+    Internal::ensure_no_file_exists(trace_file);
+
+    printf("Success!\n");
+    return 0;
+}
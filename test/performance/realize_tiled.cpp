@@ -0,0 +1,210 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+using namespace Halide;
+
+// The local Laplacian filter from apps/local_laplacian, run over an
+// image that's read from and written to files one tile at a time.
+
+Var x("x"), y("y"), c("c"), k("k");
+
+Func downsample(Func f) {
+    using Halide::_;
+    Func downx, downy;
+    downx(x, y, _) = (f(2 * x - 1, y, _) + 3.0f * (f(2 * x, y, _) + f(2 * x + 1, y, _)) + f(2 * x + 2, y, _)) / 8.0f;
+    downy(x, y, _) = (downx(x, 2 * y - 1, _) + 3.0f * (downx(x, 2 * y, _) + downx(x, 2 * y + 1, _)) + downx(x, 2 * y + 2, _)) / 8.0f;
+    return downy;
+}
+
+Func upsample(Func f) {
+    using Halide::_;
+    Func upx, upy;
+    upx(x, y, _) = 0.25f * f((x / 2) - 1 + 2 * (x % 2), y, _) + 0.75f * f(x / 2, y, _);
+    upy(x, y, _) = 0.25f * upx(x, (y / 2) - 1 + 2 * (y % 2), _) + 0.75f * upx(x, y / 2, _);
+    return upy;
+}
+
+Func local_laplacian(ImageParam input, int width, int height) {
+    const int J = 5;
+    const int levels = 8;
+    const float alpha = 1.0f, beta = 1.0f;
+
+    Func remap;
+    Expr fx = cast<float>(x) / 256.0f;
+    remap(x) = alpha * fx * exp(-fx * fx / 2.0f);
+
+    // Only the region of the input each tile needs is bound, so the
+    // boundary condition needs the bounds of the whole image.
+    Func clamped = BoundaryConditions::repeat_edge(input, {{0, width}, {0, height}, {0, 3}});
+
+    Func floating;
+    floating(x, y, c) = clamped(x, y, c) / 65535.0f;
+
+    Func gray;
+    gray(x, y) = 0.299f * floating(x, y, 0) + 0.587f * floating(x, y, 1) + 0.114f * floating(x, y, 2);
+
+    Func gPyramid[J];
+    Expr level = k * (1.0f / (levels - 1));
+    Expr idx = gray(x, y) * cast<float>(levels - 1) * 256.0f;
+    idx = clamp(cast<int>(idx), 0, (levels - 1) * 256);
+    gPyramid[0](x, y, k) = beta * (gray(x, y) - level) + level + remap(idx - 256 * k);
+    for (int j = 1; j < J; j++) {
+        gPyramid[j](x, y, k) = downsample(gPyramid[j - 1])(x, y, k);
+    }
+
+    Func lPyramid[J];
+    lPyramid[J - 1](x, y, k) = gPyramid[J - 1](x, y, k);
+    for (int j = J - 2; j >= 0; j--) {
+        lPyramid[j](x, y, k) = gPyramid[j](x, y, k) - upsample(gPyramid[j + 1])(x, y, k);
+    }
+
+    Func inGPyramid[J];
+    inGPyramid[0](x, y) = gray(x, y);
+    for (int j = 1; j < J; j++) {
+        inGPyramid[j](x, y) = downsample(inGPyramid[j - 1])(x, y);
+    }
+
+    Func outLPyramid[J];
+    for (int j = 0; j < J; j++) {
+        Expr level = inGPyramid[j](x, y) * cast<float>(levels - 1);
+        Expr li = clamp(cast<int>(level), 0, levels - 2);
+        Expr lf = level - cast<float>(li);
+        outLPyramid[j](x, y) = (1.0f - lf) * lPyramid[j](x, y, li) + lf * lPyramid[j](x, y, li + 1);
+    }
+
+    Func outGPyramid[J];
+    outGPyramid[J - 1](x, y) = outLPyramid[J - 1](x, y);
+    for (int j = J - 2; j >= 0; j--) {
+        outGPyramid[j](x, y) = upsample(outGPyramid[j + 1])(x, y) + outLPyramid[j](x, y);
+    }
+
+    Func color;
+    float eps = 0.01f;
+    color(x, y, c) = outGPyramid[0](x, y) * (floating(x, y, c) + eps) / (gray(x, y) + eps);
+
+    Func output("output");
+    output(x, y, c) = cast<uint16_t>(clamp(color(x, y, c), 0.0f, 1.0f) * 65535.0f);
+
+    remap.compute_root();
+    Var yo;
+    output.reorder(c, x, y).split(y, yo, y, 32).parallel(yo).vectorize(x, 8);
+    gray.compute_root().parallel(y, 32).vectorize(x, 8);
+    for (int j = 0; j < J; j++) {
+        if (j > 0) {
+            inGPyramid[j].compute_root().parallel(y, 32).vectorize(x, 8);
+            gPyramid[j].compute_root().reorder_storage(x, k, y).reorder(k, y).parallel(y, 8).vectorize(x, 8);
+        }
+        outGPyramid[j].compute_root().parallel(y, 32).vectorize(x, 8);
+    }
+
+    return output;
+}
+
+#ifdef __linux__
+// Peak resident set size so far, in bytes.
+size_t peak_rss() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (size_t)usage.ru_maxrss * 1024;
+}
+#endif
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+#ifndef __linux__
+    printf("[SKIP] Peak memory use is only measured on Linux.\n");
+    return 0;
+#else
+
+    // A 96MB planar 16-bit RGB image, which is never in memory in full.
+    const int width = 4096, height = 4096;
+    const int tile_width = 512, tile_height = 512;
+    const size_t image_bytes = (size_t)width * height * 3 * sizeof(uint16_t);
+
+    std::string in_filename = Internal::get_test_tmp_dir() + "halide_test_performance_realize_tiled_input.raw";
+    std::string out_filename = Internal::get_test_tmp_dir() + "halide_test_performance_realize_tiled_output.raw";
+    FILE *in_file = fopen(in_filename.c_str(), "wb+");
+    FILE *out_file = fopen(out_filename.c_str(), "wb+");
+    if (!in_file || !out_file) {
+        printf("Could not open temporary files\n");
+        return -1;
+    }
+    {
+        std::vector<uint16_t> row(width);
+        for (int ch = 0; ch < 3; ch++) {
+            for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                    row[i] = (uint16_t)((i * 37 + j * 11 + ch * 1000) ^ (i * j));
+                }
+                fwrite(row.data(), sizeof(uint16_t), width, in_file);
+            }
+        }
+        fflush(in_file);
+    }
+
+    ImageParam input(UInt(16), 3, "input");
+    Pipeline p(local_laplacian(input, width, height));
+    p.compile_jit(target);
+
+    auto read = [&](const ImageParam &, Buffer<> &region) {
+        Buffer<uint16_t> r = region;
+        for (int ch = r.dim(2).min(); ch <= r.dim(2).max(); ch++) {
+            for (int j = r.dim(1).min(); j <= r.dim(1).max(); j++) {
+                fseek(in_file, (((long)ch * height + j) * width + r.dim(0).min()) * sizeof(uint16_t), SEEK_SET);
+                if (fread(&r(r.dim(0).min(), j, ch), sizeof(uint16_t), r.dim(0).extent(), in_file) != (size_t)r.dim(0).extent()) {
+                    printf("Short read\n");
+                    exit(-1);
+                }
+            }
+        }
+    };
+
+    auto write = [&](Realization &tile) {
+        Buffer<uint16_t> t = tile[0];
+        for (int ch = t.dim(2).min(); ch <= t.dim(2).max(); ch++) {
+            for (int j = t.dim(1).min(); j <= t.dim(1).max(); j++) {
+                fseek(out_file, (((long)ch * height + j) * width + t.dim(0).min()) * sizeof(uint16_t), SEEK_SET);
+                fwrite(&t(t.dim(0).min(), j, ch), sizeof(uint16_t), t.dim(0).extent(), out_file);
+            }
+        }
+    };
+
+    // Warm up on a single tile, so that one-off allocations in the
+    // runtime are not counted.
+    p.realize_tiled({tile_width, tile_height, 3}, {tile_width, tile_height, 3}, {input}, read, write, target);
+
+    const size_t rss_before = peak_rss();
+    double t = Tools::benchmark(1, 1, [&]() {
+        p.realize_tiled({width, height, 3}, {tile_width, tile_height, 3}, {input}, read, write, target);
+    });
+    const size_t rss_after = peak_rss();
+
+    fclose(in_file);
+    fclose(out_file);
+    remove(in_filename.c_str());
+    remove(out_filename.c_str());
+
+    const size_t growth = rss_after > rss_before ? rss_after - rss_before : 0;
+    printf("Tiled local laplacian over %d x %d: %f ms, peak RSS grew by %f MB (the image is %f MB)\n",
+           width, height, t * 1e3, growth / (1024.0 * 1024.0), image_bytes / (1024.0 * 1024.0));
+
+    if (growth > image_bytes / 2) {
+        printf("Peak memory use should be bounded by the tile size, not the image size\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+#endif
+}
@@ -3,16 +3,21 @@
 #include "halide_benchmark.h"
 #include "halide_image_io.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <random>
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include <vector>
@@ -480,11 +485,19 @@ inline Buffer<> adjust_buffer_dims(const std::string &title, const std::string &
 // fit the metadata's requirements as needed.
 inline Buffer<> load_input_from_file(const std::string &pathname,
                                      const halide_filter_argument_t &metadata) {
+    // Inputs are mapped rather than read where the format allows it, so
+    // that large inputs don't have to be copied before the first run.
+    // The mappings are kept until exit.
+    static std::vector<std::shared_ptr<void>> mappings;
     Buffer<> b = Buffer<>(metadata.type, 0);
+    std::shared_ptr<void> mapping;
     info() << "Loading input " << metadata.name << " from " << pathname << " ...";
-    if (!Halide::Tools::load<Buffer<>, IOCheckFail>(pathname, &b)) {
+    if (!Halide::Tools::load_mapped<Buffer<>, IOCheckFail>(pathname, &b, &mapping)) {
         fail() << "Unable to load input: " << pathname;
     }
+    if (mapping) {
+        mappings.push_back(std::move(mapping));
+    }
     if (b.dimensions() != metadata.dimensions) {
         b = adjust_buffer_dims("Input", metadata.name, metadata.dimensions, b);
     }
@@ -1314,6 +1327,113 @@ public:
         }
     }
 
+    // Run the filter from `concurrency` threads at once for at least
+    // `min_time` seconds, each thread with its own copies of the input
+    // and output buffers, and report the overall throughput along with
+    // percentiles of the latency of individual calls. Unlike
+    // run_for_benchmark(), this includes any contention between callers
+    // in the runtime (thread pool, allocator, memoization cache, etc).
+    // `num_threads` is only used for reporting; 0 means the runtime's
+    // default.
+    void run_for_throughput(int concurrency, double min_time, int num_threads) {
+        std::vector<std::vector<Buffer<>>> caller_buffers(concurrency);
+        std::vector<std::vector<void *>> caller_argv(concurrency);
+        for (int c = 0; c < concurrency; c++) {
+            caller_buffers[c].resize(args.size());
+            caller_argv[c] = build_filter_argv();
+            for (auto &arg_pair : args) {
+                auto &arg = arg_pair.second;
+                if (arg.metadata->kind == halide_argument_kind_input_scalar) {
+                    continue;
+                }
+                // copy() keeps the memory layout, so any layout
+                // constraints the filter has are still satisfied.
+                caller_buffers[c][arg.index] = arg.buffer_value.copy();
+                caller_argv[c][arg.index] = caller_buffers[c][arg.index].raw_buffer();
+            }
+        }
+
+        const auto call = [this, &caller_buffers, &caller_argv](int c) {
+            // Ignore result since our halide_error() should catch everything.
+            (void)halide_argv_call(&caller_argv[c][0]);
+            for (auto &arg_pair : args) {
+                auto &arg = arg_pair.second;
+                if (arg.metadata->kind == halide_argument_kind_output_buffer) {
+                    caller_buffers[c][arg.index].device_sync();
+                }
+            }
+        };
+
+        info() << "Benchmarking filter with " << concurrency << " concurrent callers...";
+
+        // Run every caller once first, so that one-time costs (starting
+        // the thread pool, device initialization, etc) aren't counted.
+        for (int c = 0; c < concurrency; c++) {
+            call(c);
+        }
+
+        std::vector<std::vector<double>> caller_latencies(concurrency);
+        std::vector<std::thread> threads;
+        std::atomic<int> ready{0};
+        const auto start = Halide::Tools::benchmark_now();
+        for (int c = 0; c < concurrency; c++) {
+            threads.emplace_back([&, c]() {
+                // Don't start until all the callers exist, so they
+                // overlap for the whole run.
+                ready++;
+                while (ready < concurrency) {
+                    std::this_thread::yield();
+                }
+                std::vector<double> &latencies = caller_latencies[c];
+                auto t = Halide::Tools::benchmark_now();
+                do {
+                    call(c);
+                    const auto end = Halide::Tools::benchmark_now();
+                    latencies.push_back(Halide::Tools::benchmark_duration_seconds(t, end));
+                    t = end;
+                } while (Halide::Tools::benchmark_duration_seconds(start, t) < min_time);
+            });
+        }
+        for (auto &t : threads) {
+            t.join();
+        }
+        const double elapsed = Halide::Tools::benchmark_duration_seconds(start, Halide::Tools::benchmark_now());
+
+        std::vector<double> latencies;
+        for (const auto &l : caller_latencies) {
+            latencies.insert(latencies.end(), l.begin(), l.end());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        const auto percentile = [&latencies](double p) -> double {
+            // Nearest-rank percentile.
+            size_t i = (size_t)std::ceil(p / 100.0 * latencies.size());
+            return latencies[std::min(std::max(i, (size_t)1), latencies.size()) - 1];
+        };
+
+        const double calls_per_sec = latencies.size() / elapsed;
+        const double mpix_per_sec = megapixels_out() * calls_per_sec;
+        const double p50 = percentile(50), p90 = percentile(90), p99 = percentile(99);
+        if (!parsable_output) {
+            out() << "Throughput for " << md->name << " with " << concurrency << " concurrent callers"
+                  << " and " << (num_threads > 0 ? std::to_string(num_threads) : std::string("the default number of")) << " runtime threads"
+                  << " is " << calls_per_sec << " calls/sec (" << latencies.size() << " calls over " << elapsed << " sec).\n"
+                  << "Total output throughput is " << mpix_per_sec << " mpix/sec.\n"
+                  << "Latency is " << p50 * 1000 << " msec (p50), "
+                  << p90 * 1000 << " msec (p90), "
+                  << p99 * 1000 << " msec (p99).\n";
+        } else {
+            out() << md->name << "  CONCURRENCY              " << concurrency << "\n"
+                  << md->name << "  NUM_THREADS              " << num_threads << "\n"
+                  << md->name << "  CALLS                    " << latencies.size() << "\n"
+                  << md->name << "  THROUGHPUT_CALLS_PER_SEC " << calls_per_sec << "\n"
+                  << md->name << "  THROUGHPUT_MPIX_PER_SEC  " << mpix_per_sec << "\n"
+                  << md->name << "  LATENCY_P50_MSEC         " << p50 * 1000 << "\n"
+                  << md->name << "  LATENCY_P90_MSEC         " << p90 * 1000 << "\n"
+                  << md->name << "  LATENCY_P99_MSEC         " << p99 * 1000 << "\n"
+                  << md->name << "  HALIDE_TARGET            " << md->target << "\n";
+        }
+    }
+
     struct Output {
         std::string name;
         Buffer<> actual;
@@ -139,6 +139,20 @@ Flags:
         Override the default minimum desired benchmarking time; ignored if
         --benchmarks is not also specified.
 
+    --concurrency=NUM:
+        Instead of timing one caller at a time, run the filter from NUM
+        threads at once, each with its own copies of the input and output
+        buffers, for at least --benchmark_min_time seconds. Reports the
+        total throughput and the p50/p90/p99 latency of individual calls,
+        which includes any contention between callers in the runtime (thread
+        pool, allocator, memoization cache, etc). Implies --benchmarks=all.
+
+    --num_threads=NUM[,NUM...]:
+        Set the size of the runtime's thread pool (as with HL_NUM_THREADS)
+        before running the filter. If several values are given, the
+        --concurrency benchmark is repeated for each one. Requires
+        --concurrency.
+
     --track_memory:
         Override Halide memory allocator to track high-water mark of memory
         allocation during run; note that this may slow down execution, so
@@ -381,6 +395,8 @@ int main(int argc, char **argv) {
     std::string default_input_buffers;
     std::string default_input_scalars;
     std::string benchmarks_flag_value;
+    int concurrency = 0;
+    std::vector<int> num_threads;
     for (int i = 1; i < argc; ++i) {
         if (argv[i][0] == '-') {
             const char *p = argv[i] + 1;  // skip -
@@ -437,6 +453,19 @@ int main(int argc, char **argv) {
             } else if (flag_name == "benchmarks") {
                 benchmarks_flag_value = flag_value;
                 benchmark = true;
+            } else if (flag_name == "concurrency") {
+                if (!parse_scalar(flag_value, &concurrency) || concurrency < 1) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
+                benchmark = true;
+            } else if (flag_name == "num_threads") {
+                for (const std::string &n : split_string(flag_value, ",")) {
+                    int value;
+                    if (!parse_scalar(n, &value) || value < 1) {
+                        fail() << "Invalid value for flag: " << flag_name;
+                    }
+                    num_threads.push_back(value);
+                }
             } else if (flag_name == "benchmark_min_time") {
                 if (!parse_scalar(flag_value, &benchmark_min_time)) {
                     fail() << "Invalid value for flag: " << flag_name;
@@ -484,6 +513,10 @@ int main(int argc, char **argv) {
     // It's OK to omit output arguments when we are benchmarking or tracking memory.
     bool ok_to_omit_outputs = (benchmark || track_memory);
 
+    if (!num_threads.empty() && !concurrency) {
+        fail() << "--num_threads requires --concurrency.";
+    }
+
     if (benchmark && track_memory) {
         warn() << "Using --track_memory with --benchmarks will produce inaccurate benchmark results.";
     }
@@ -519,7 +552,17 @@ int main(int argc, char **argv) {
         if (benchmarks_flag_value != "all") {
             fail() << "The only valid value for --benchmarks is 'all'";
         }
-        r.run_for_benchmark(benchmark_min_time);
+        if (concurrency) {
+            if (num_threads.empty()) {
+                r.run_for_throughput(concurrency, benchmark_min_time, 0);
+            }
+            for (int n : num_threads) {
+                halide_set_num_threads(n);
+                r.run_for_throughput(concurrency, benchmark_min_time, n);
+            }
+        } else {
+            r.run_for_benchmark(benchmark_min_time);
+        }
     } else {
         r.run_for_output();
     }
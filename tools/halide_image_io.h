@@ -10,6 +10,7 @@
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <map>
 #include <set>
@@ -1194,6 +1195,25 @@ bool buffer_is_compact_planar(ImageType &im) {
     return true;
 }
 
+// Read the header of a .tmp file, leaving f at the start of the payload.
+template<CheckFunc check>
+bool read_tmp_header(FileOpener &f, halide_type_t *im_type, std::vector<int> *im_dimensions) {
+    int32_t header[5];
+    if (!check(f.read_array(header), "Count not read .tmp header")) {
+        return false;
+    }
+
+    if (!check(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
+                   header[4] >= 0 && header[4] < kNumTmpCodes,
+               "Bad header on .tmp file")) {
+        return false;
+    }
+
+    *im_type = tmp_code_to_halide_type()[header[4]];
+    *im_dimensions = {header[0], header[1], header[2], header[3]};
+    return true;
+}
+
 // ".tmp" is a file format used by the ImageStack tool (see https://github.com/abadams/ImageStack)
 template<typename ImageType, CheckFunc check = CheckReturn>
 bool load_tmp(const std::string &filename, ImageType *im) {
@@ -1204,19 +1224,11 @@ bool load_tmp(const std::string &filename, ImageType *im) {
         return false;
     }
 
-    int32_t header[5];
-    if (!check(f.read_array(header), "Count not read .tmp header")) {
-        return false;
-    }
-
-    if (!check(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
-                   header[4] >= 0 && header[4] < kNumTmpCodes,
-               "Bad header on .tmp file")) {
+    halide_type_t im_type;
+    std::vector<int> im_dimensions;
+    if (!read_tmp_header<check>(f, &im_type, &im_dimensions)) {
         return false;
     }
-
-    const halide_type_t im_type = tmp_code_to_halide_type()[header[4]];
-    std::vector<int> im_dimensions = {header[0], header[1], header[2], header[3]};
     *im = ImageType(im_type, im_dimensions);
 
     // This should never fail unless the default Buffer<> constructor behavior changes.
@@ -1341,15 +1353,9 @@ enum MatlabClassCode {
     mxUINT64_CLASS = 15
 };
 
-template<typename ImageType, CheckFunc check = CheckReturn>
-bool load_mat(const std::string &filename, ImageType *im) {
-    static_assert(!ImageType::has_static_halide_type, "");
-
-    FileOpener f(filename, "rb");
-    if (!check(f.f != nullptr, "File could not be opened for reading")) {
-        return false;
-    }
-
+// Read the header of a .mat file, leaving f at the start of the payload.
+template<CheckFunc check>
+bool read_mat_header(FileOpener &f, halide_type_t *im_type, std::vector<int> *im_dimensions) {
     uint8_t header[128];
     if (!check(f.read_array(header), "Could not read .mat header\n")) {
         return false;
@@ -1382,7 +1388,8 @@ bool load_mat(const std::string &filename, ImageType *im) {
         return false;
     }
     int dims = shape_header[1] / 4;
-    std::vector<int> extents(dims);
+    std::vector<int> &extents = *im_dimensions;
+    extents.resize(dims);
     if (!check(f.read_vector(&extents), "Could not read .mat header\n")) {
         return false;
     }
@@ -1417,7 +1424,7 @@ bool load_mat(const std::string &filename, ImageType *im) {
     if (!check(f.read_array(payload_header), "Could not read .mat header\n")) {
         return false;
     }
-    halide_type_t type;
+    halide_type_t &type = *im_type;
     switch (payload_header[0]) {
     case miINT8:
         type = halide_type_of<int8_t>();
@@ -1449,6 +1456,25 @@ bool load_mat(const std::string &filename, ImageType *im) {
     case miDOUBLE:
         type = halide_type_of<double>();
         break;
+    default:
+        return check(false, "Could not parse this .mat file: unsupported payload type\n");
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_mat(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    halide_type_t type;
+    std::vector<int> extents;
+    if (!read_mat_header<check>(f, &type, &extents)) {
+        return false;
     }
 
     *im = ImageType(type, extents);
@@ -1679,6 +1705,245 @@ bool save_mat(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// ".npy" is numpy's array format, documented here:
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+//
+// Dimension i of the image is axis i of the array, as with the Python
+// bindings' conversions between Buffers and numpy arrays. Arrays in C
+// order are loaded as images with their last dimension innermost;
+// images are saved in Fortran order, so that they're written as-is.
+
+// Read the header of a .npy file, leaving f at the start of the
+// payload. Dimensions are returned with the strides of the payload.
+template<CheckFunc check>
+bool read_npy_header(FileOpener &f, halide_type_t *im_type, std::vector<halide_dimension_t> *im_shape) {
+    uint8_t magic[8];
+    if (!check(f.read_array(magic), "Could not read .npy header")) {
+        return false;
+    }
+    if (!check(memcmp(magic, "\x93NUMPY", 6) == 0, "Bad magic number on .npy file")) {
+        return false;
+    }
+    const int major_version = magic[6];
+    uint32_t header_len = 0;
+    if (major_version == 1) {
+        uint8_t len[2];
+        if (!check(f.read_array(len), "Could not read .npy header")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8);
+    } else if (major_version == 2 || major_version == 3) {
+        uint8_t len[4];
+        if (!check(f.read_array(len), "Could not read .npy header")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8) | (len[2] << 16) | ((uint32_t)len[3] << 24);
+    } else {
+        return check(false, "Unsupported .npy file version");
+    }
+    std::string header(header_len, ' ');
+    if (!check(f.read_bytes(&header[0], header_len), "Could not read .npy header")) {
+        return false;
+    }
+
+    // The header is a Python dict literal; find the value of the given key.
+    const auto find_value = [&header](const char *key) -> size_t {
+        size_t pos = header.find(key);
+        if (pos == std::string::npos) {
+            return pos;
+        }
+        pos = header.find(':', pos + strlen(key));
+        if (pos == std::string::npos) {
+            return pos;
+        }
+        return header.find_first_not_of(' ', pos + 1);
+    };
+
+    size_t descr = find_value("'descr'");
+    if (!check(descr != std::string::npos && descr + 1 < header.size() &&
+                   (header[descr] == '\'' || header[descr] == '"'),
+               "Could not parse .npy header: no descr")) {
+        return false;
+    }
+    const size_t descr_end = header.find(header[descr], descr + 1);
+    if (!check(descr_end != std::string::npos, "Could not parse .npy header: bad descr")) {
+        return false;
+    }
+    const std::string type_str = header.substr(descr + 1, descr_end - descr - 1);
+    static const std::map<std::string, halide_type_t> npy_types = {
+        {"u1", halide_type_t(halide_type_uint, 8)},
+        {"i1", halide_type_t(halide_type_int, 8)},
+        {"u2", halide_type_t(halide_type_uint, 16)},
+        {"i2", halide_type_t(halide_type_int, 16)},
+        {"u4", halide_type_t(halide_type_uint, 32)},
+        {"i4", halide_type_t(halide_type_int, 32)},
+        {"u8", halide_type_t(halide_type_uint, 64)},
+        {"i8", halide_type_t(halide_type_int, 64)},
+        {"f4", halide_type_t(halide_type_float, 32)},
+        {"f8", halide_type_t(halide_type_float, 64)},
+    };
+    // We only support little-endian data (or single bytes, for which
+    // the byte order is '|').
+    const auto it = type_str.size() == 3 ? npy_types.find(type_str.substr(1)) : npy_types.end();
+    if (!check(it != npy_types.end() &&
+                   (type_str[0] == '<' || type_str[0] == '|' || type_str[0] == '='),
+               "Unsupported .npy data type")) {
+        return false;
+    }
+    *im_type = it->second;
+
+    const size_t fortran_order = find_value("'fortran_order'");
+    if (!check(fortran_order != std::string::npos, "Could not parse .npy header: no fortran_order")) {
+        return false;
+    }
+    const bool is_fortran_order = header.compare(fortran_order, 4, "True") == 0;
+
+    const size_t shape = find_value("'shape'");
+    if (!check(shape != std::string::npos && header[shape] == '(', "Could not parse .npy header: no shape")) {
+        return false;
+    }
+    const size_t shape_end = header.find(')', shape);
+    if (!check(shape_end != std::string::npos, "Could not parse .npy header: bad shape")) {
+        return false;
+    }
+    std::vector<int> extents;
+    const char *p = header.c_str() + shape + 1;
+    const char *end = header.c_str() + shape_end;
+    while (p < end) {
+        char *next;
+        long long extent = strtoll(p, &next, 10);
+        if (next == p) {
+            // Skip whitespace and commas.
+            p++;
+            continue;
+        }
+        if (!check(extent >= 0 && extent <= 0x7fffffff, "Could not parse .npy header: bad extent")) {
+            return false;
+        }
+        extents.push_back((int)extent);
+        p = next;
+    }
+
+    const int dims = (int)extents.size();
+    im_shape->resize(dims);
+    int64_t stride = 1;
+    for (int i = 0; i < dims; i++) {
+        const int d = is_fortran_order ? i : dims - 1 - i;
+        if (!check(stride <= 0x7fffffff, "Could not load .npy file: too large")) {
+            return false;
+        }
+        (*im_shape)[d] = halide_dimension_t(0, extents[d], (int32_t)stride);
+        stride *= extents[d];
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_npy(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    halide_type_t type;
+    std::vector<halide_dimension_t> shape;
+    if (!read_npy_header<check>(f, &type, &shape)) {
+        return false;
+    }
+
+    // Allocate with the same layout as the payload, so it can be read
+    // in one go.
+    std::vector<int> extents, storage_order;
+    for (const halide_dimension_t &d : shape) {
+        extents.push_back(d.extent);
+        storage_order.push_back((int)storage_order.size());
+    }
+    std::sort(storage_order.begin(), storage_order.end(), [&shape](int a, int b) {
+        return shape[a].stride < shape[b].stride;
+    });
+    *im = ImageType(type, extents, storage_order);
+
+    if (!check(f.read_bytes(im->begin(), im->size_in_bytes()), "Could not read .npy payload")) {
+        return false;
+    }
+
+    im->set_host_dirty();
+    return true;
+}
+
+inline const std::set<FormatInfo> &query_npy() {
+    // Arrays can have any number of dimensions; our support arbitrarily
+    // stops at 16.
+    static std::set<FormatInfo> info = []() {
+        std::set<FormatInfo> s;
+        for (int i = 0; i < 16; i++) {
+            s.insert({halide_type_t(halide_type_float, 32), i});
+            s.insert({halide_type_t(halide_type_float, 64), i});
+            s.insert({halide_type_t(halide_type_uint, 8), i});
+            s.insert({halide_type_t(halide_type_int, 8), i});
+            s.insert({halide_type_t(halide_type_uint, 16), i});
+            s.insert({halide_type_t(halide_type_int, 16), i});
+            s.insert({halide_type_t(halide_type_uint, 32), i});
+            s.insert({halide_type_t(halide_type_int, 32), i});
+            s.insert({halide_type_t(halide_type_uint, 64), i});
+            s.insert({halide_type_t(halide_type_int, 64), i});
+        }
+        return s;
+    }();
+    return info;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_npy(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    const halide_type_t im_type = im.type();
+    const char code = im_type.code == halide_type_float ? 'f' : im_type.code == halide_type_int ? 'i' : 'u';
+    if (!check(query_npy().count({im_type, 0}) > 0, "Unsupported type for .npy file")) {
+        return false;
+    }
+
+    std::string header = "{'descr': '";
+    header += im_type.bits == 8 ? '|' : '<';
+    header += code;
+    header += std::to_string(im_type.bytes());
+    header += "', 'fortran_order': True, 'shape': (";
+    for (int i = 0; i < im.dimensions(); i++) {
+        header += std::to_string(im.dim(i).extent());
+        header += (i == 0 || i + 1 < im.dimensions()) ? ", " : "";
+    }
+    header += "), }";
+    // Pad with spaces and a newline, so that the payload starts on a
+    // 64-byte boundary (as numpy does).
+    const size_t prefix_len = 10;
+    const size_t total_len = (prefix_len + header.size() + 1 + 63) & ~(size_t)63;
+    header.resize(total_len - prefix_len - 1, ' ');
+    header += '\n';
+    if (!check(header.size() < 65536, "Too many dimensions for .npy file")) {
+        return false;
+    }
+
+    FileOpener f(filename, "wb");
+    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+        return false;
+    }
+    const uint8_t prefix[prefix_len] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                                        (uint8_t)(header.size() & 0xff), (uint8_t)(header.size() >> 8)};
+    if (!check(f.write_array(prefix) && f.write_bytes(header.data(), header.size()), "Could not write .npy header")) {
+        return false;
+    }
+
+    if (!write_planar_payload<ImageType, check>(im, f)) {
+        return false;
+    }
+
+    return true;
+}
+
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool load_tiff(const std::string &filename, ImageType *im) {
     static_assert(!ImageType::has_static_halide_type, "");
@@ -1991,6 +2256,7 @@ bool find_imageio(const std::string &filename, ImageIO<ImageType, check> *result
         {"ppm", {load_ppm<ImageType, check>, save_ppm<ConstImageType, check>, query_ppm}},
         {"tmp", {load_tmp<ImageType, check>, save_tmp<ConstImageType, check>, query_tmp}},
         {"mat", {load_mat<ImageType, check>, save_mat<ConstImageType, check>, query_mat}},
+        {"npy", {load_npy<ImageType, check>, save_npy<ConstImageType, check>, query_npy}},
         {"tiff", {load_tiff<ImageType, check>, save_tiff<ConstImageType, check>, query_tiff}},
     };
     std::string ext = Internal::get_lowercase_extension(filename);
@@ -0,0 +1,201 @@
+// Loading images without copying their pixels, by mapping the files
+// into memory. This is separate from halide_image_io.h, so that users
+// of plain load() and save() don't get the platform's memory mapping
+// headers.
+
+#ifndef HALIDE_IMAGE_IO_MMAP_H
+#define HALIDE_IMAGE_IO_MMAP_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "halide_image_io.h"
+
+namespace Halide {
+namespace Tools {
+
+namespace Internal {
+
+// A copy-on-write memory mapping of an entire file: the contents can be
+// modified in memory, but changes never reach the file. data is null if
+// the file could not be mapped.
+struct MappedFile {
+    explicit MappedFile(const std::string &filename) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+            if (mapping != nullptr) {
+                data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+                if (data != nullptr) {
+                    size = (size_t)file_size.QuadPart;
+                }
+                // The view keeps the mapping alive.
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data = p;
+                size = (size_t)st.st_size;
+            }
+        }
+        // The mapping keeps the file alive.
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+        if (data == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap(data, size);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    void *data = nullptr;
+    size_t size = 0;
+};
+
+// Where the pixels of a file live, for formats that store them
+// uncompressed, in native byte order, and in a layout a Buffer can
+// describe.
+struct PayloadLayout {
+    halide_type_t type;
+    std::vector<halide_dimension_t> shape;
+    size_t offset = 0;
+};
+
+// Returns false if the strides don't fit in an int32.
+inline bool planar_shape(const std::vector<int> &extents, std::vector<halide_dimension_t> *shape) {
+    shape->clear();
+    int64_t stride = 1;
+    for (int extent : extents) {
+        if (stride > 0x7fffffff) {
+            return false;
+        }
+        shape->emplace_back(0, extent, (int32_t)stride);
+        stride *= extent;
+    }
+    return true;
+}
+
+inline bool find_mappable_payload(const std::string &filename, PayloadLayout *layout) {
+    const std::string ext = get_lowercase_extension(filename);
+    FileOpener f(filename, "rb");
+    if (f.f == nullptr) {
+        return false;
+    }
+    if (ext == "tmp" || ext == "mat") {
+        std::vector<int> extents;
+        bool ok = ext == "tmp" ?
+                      read_tmp_header<CheckReturn>(f, &layout->type, &extents) :
+                      read_mat_header<CheckReturn>(f, &layout->type, &extents);
+        if (!ok || !planar_shape(extents, &layout->shape)) {
+            return false;
+        }
+    } else if (ext == "pgm") {
+        // 16-bit pgms are big-endian, and ppms are interleaved, so only
+        // 8-bit pgms can be used in place.
+        int width, height, bit_depth;
+        if (!read_pnm_header<CheckReturn>(f, "P5", &width, &height, &bit_depth) || bit_depth != 8) {
+            return false;
+        }
+        layout->type = halide_type_t(halide_type_uint, 8);
+        if (!planar_shape({width, height}, &layout->shape)) {
+            return false;
+        }
+    } else if (ext == "npy") {
+        if (!read_npy_header<CheckReturn>(f, &layout->type, &layout->shape)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+    long offset = ftell(f.f);
+    if (offset < 0) {
+        return false;
+    }
+    layout->offset = (size_t)offset;
+    return true;
+}
+
+}  // namespace Internal
+
+// Load the Image from the given file without copying the pixels, by
+// mapping the file into memory and pointing the Image at the mapped
+// pages. The pages are mapped copy-on-write, so the Image can be
+// written to without changing the file. The Image is only valid for as
+// long as *mapping (or a copy of it) is alive. Only uncompressed
+// formats that store pixels in native byte order and in a layout an
+// Image can describe (.tmp, .mat, .npy, and 8-bit .pgm) can be mapped;
+// anything else is loaded with load(), in which case *mapping is
+// left empty.
+// Returns false upon failure.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_mapped(const std::string &filename, ImageType *im, std::shared_ptr<void> *mapping) {
+    mapping->reset();
+
+    Internal::PayloadLayout layout;
+    if (Internal::find_mappable_payload(filename, &layout) &&
+        (!ImageType::has_static_halide_type || layout.type == ImageType::static_halide_type())) {
+        auto file = std::make_shared<Internal::MappedFile>(filename);
+        size_t payload_size = layout.type.bytes();
+        for (const halide_dimension_t &d : layout.shape) {
+            payload_size *= d.extent;
+        }
+        // The header might leave the payload misaligned, in which case
+        // we have to copy it out after all.
+        if (file->data != nullptr &&
+            layout.offset + payload_size <= file->size &&
+            ((uintptr_t)file->data + layout.offset) % layout.type.bytes() == 0) {
+            using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+            void *host = (uint8_t *)file->data + layout.offset;
+            DynamicImageType im_d(layout.type, host, (int)layout.shape.size(), layout.shape.data());
+            *im = im_d.template as<typename ImageType::ElemType>();
+            im->set_host_dirty();
+            *mapping = std::move(file);
+            return true;
+        }
+    }
+
+    return load<ImageType, check>(filename, im);
+}
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_IMAGE_IO_MMAP_H